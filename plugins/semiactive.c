@@ -0,0 +1,103 @@
+/*******************************************************************************
+semiactive.c - semi-active isolation control rule as an HPGdaac controller
+plug-in  (HPGplugin.h)
+
+inputs:     A/D channel 0 = acceleration,  1 = displacement,  2 = force
+output:     D/A channel 0, 0 to 1 volt
+constants:  1: K_iso  2: alpha  3: beta  4: gamma  5: threshold
+            from the control constants of the configuration file
+
+to compile:   make plugins ; sudo make install-plugins
+to use:       Controller data file name  : /usr/local/lib/HPGdaac/semiactive.so
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // malloc, free
+#include <string.h>         // standard string handling library
+#include <math.h>           // standard mathematics library
+
+#include "../src/HPGplugin.h"         // controller plug-in interface
+
+int  hpg_plugin_abi = HPG_PLUGIN_ABI;
+
+struct STATE {
+       float  V_out;        // the previous output, volts
+    };
+
+
+/* HPG_INIT - describe the plug-in and allocate its state            19oct26
+---------------------------------------------------------------------------*/
+int hpg_init ( struct HPG_PLUGIN_INFO *info )
+{
+  struct STATE  *st;
+
+  if ( info->nChnl < 3 ) {
+    fprintf(stderr," semiactive: needs A/D channels 0, 1, and 2\n");
+    return 1;
+  }
+  if ( (st = malloc ( sizeof(struct STATE) )) == NULL )  return 1;
+  st->V_out = 0.0;
+
+  strcpy ( info->title, "semi-active isolation control rule" );
+  info->nIn  = 3;
+  info->inChnl[0] = 0;  info->inChnl[1] = 1;  info->inChnl[2] = 2;
+  info->nOut = 1;
+  info->outDA[0]  = 0;
+  info->uMin = 0.0;
+  info->uMax = 1.0;
+  info->state = st;
+
+  return 0;
+}
+
+
+/* HPG_STEP - calculate control rule for analog output signal        24july01
+   y[0] = acceleration,  y[1] = displacement,  y[2] = force
+---------------------------------------------------------------------------*/
+void hpg_step ( const float *y, float *u, const struct CTRLCNST *ctrlCnst,
+                uint32_t scan, void *state )
+{
+  struct STATE  *st = (struct STATE *) state;
+  float  threshold = 100.0,  /* threshold to supress chatter */
+    K_iso = 6.6,    /* isolation stiffness  kN/cm  */
+    alpha = 0.2, beta = 0.2, gamma = 0.2;  /* ctrl cnstnts */
+
+  float  accel = 0.0, force = 0.0, displ = 0.0,  V_out = st->V_out;
+
+  /* proportional error feedback for pseudo-negative stiffness */
+
+  K_iso       = ctrlCnst[1].val;
+  alpha       = ctrlCnst[2].val;
+  beta        = ctrlCnst[3].val;
+  gamma       = ctrlCnst[4].val;
+  threshold   = ctrlCnst[5].val;
+  accel       = y[0];
+  displ       = y[1];
+  force       = y[2];
+
+  (void) K_iso;  (void) accel;  (void) scan;
+
+  if ( force*displ < 0.0 ) {
+    if ( fabsf(force) < threshold )    // connect
+      V_out = gamma*fabsf(displ);
+    else     // control
+  //  V_out += beta*( K_iso*displ + force ) * sgn(displ);
+      V_out = beta*fabsf(displ);
+    if ( V_out < 0.0 )
+      V_out = 0.0;
+    if ( V_out > 1.0 )
+      V_out = 1.0;
+  } else {
+      V_out = alpha;
+  }
+
+  st->V_out = u[0] = V_out;
+}
+
+
+/* HPG_FINISH - release the state                                    19oct26
+---------------------------------------------------------------------------*/
+void hpg_finish ( void *state )
+{
+  free ( state );
+}
@@ -29,6 +29,8 @@ https://github.com/shujima/HPADDAlibrary
 
  */
 
+#include <string.h>   // memcpy, memset, for the calibration table
+#include <time.h>     // clock_gettime, for the bring-up timing report
 #include "HPADDAlib.h"
 #include "../../HPGnumlib/HPGutil.h"
 
@@ -42,21 +44,128 @@ const uint8_t AD_DRDY   = RPI_GPIO_P1_11;
 // to store the data read from the AD data register 
 // int32_t    registerData = 0;
 
+/* register values written at start up, STATUS MUX ADCON CSPEED IO */
+static const uint8_t initReg[5] = { 0x01, 0x01, 0x20, 0xF0, 0xE0 };
+
+/* bits of each register that read back as written; the chip ID and DRDY
+ * bits of STATUS and the DIO pin levels of IO are not */
+static const uint8_t regMask[11] = { 0x0E, 0xFF, 0x7F, 0xFF, 0xF0,
+                                     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+/* the chip selects on the SPI bus of the Raspberry Pi, the DAC8532 and
+ * each ADS1256, attached with bus_attach */
+static uint8_t busCS[8];
+static int     nBusCS = 0;
+
+/*   name: bus_attach
+ *   function: make a chip select pin an output, high, and add it to the
+ *             chip selects on the bus
+ */
+static void bus_attach ( uint8_t cs )
+{
+    int k;
+
+    bcm2835_gpio_fsel( cs , BCM2835_GPIO_FSEL_OUTP );
+    bcm2835_gpio_write( cs , HIGH );
+    for (k = 0; k < nBusCS; k++)  if ( busCS[k] == cs )  return;
+    if ( nBusCS < (int) sizeof(busCS) )  busCS[nBusCS++] = cs;
+}
+
+/*   name: bus_claim
+ *   function: raise the chip selects of the other devices on the bus,
+ *             before the device on cs is selected
+ */
+static void bus_claim ( uint8_t cs )
+{
+    int k;
+
+    for (k = 0; k < nBusCS; k++)
+        if ( busCS[k] != cs )  bcm2835_gpio_write( busCS[k] , HIGH );
+}
+
+/* the bcm2835 library, the backend of the converters on the Raspberry Pi */
+const struct HPADDA_OPS hpadda_bcm2835 = {
+    bcm2835_gpio_fsel,
+    bcm2835_gpio_set_pud,
+    bcm2835_gpio_write,
+    bcm2835_gpio_lev,
+    bcm2835_spi_transfer,
+    bcm2835_st_read,
+    bcm2835_delayMicroseconds,
+    bus_attach,
+    bus_claim
+};
+
+/* the ADS1256 of the HPADDA board, opened by initHPADDAboard; the host copy
+ * of its registers, STATUS to FSC2, is kept in the converter, so that
+ * writes of values already in the chip are left out, with shadowSet 1
+ * where it is known, and so is the calibration of each PGA gain */
+struct ADS1256 ads1256;
+
+/* the DAC8532 of the HPADDA board, opened by initHPADDAboard */
+struct DAC8532 dac8532;
+
+
+/*   name: elapsed_ms
+ *   function: milli-seconds since t0, and restart t0
+ */
+static double elapsed_ms ( struct timespec *t0 )
+{
+    struct timespec t1;
+    double ms;
+
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    ms = (t1.tv_sec - t0->tv_sec)*1e3 + (t1.tv_nsec - t0->tv_nsec)*1e-6;
+    *t0 = t1;
+    return ms;
+}
+
+
+/*   name: shadow_wreg
+ *   function: with the A/D chip selected, write the registers of want[],
+ *             from register first, that differ from the shadow, with one
+ *             WREG command from the first to the last that differ
+ *   parameter: first : the register of want[0]
+ *              n     : the number of registers in want[]
+ *   The return value:  the number of registers written, 0 for none
+ */
+static int shadow_wreg ( struct ADS1256 *ad, uint8_t first, int n, const uint8_t want[] )
+{
+    int a = 0, b = n-1, k;
+
+    while ( a < n && ad->shadowSet[first+a] && ad->shadowReg[first+a] == want[a] )  a++;
+    if ( a == n )  return 0;                   // all in the chip already
+    while ( ad->shadowSet[first+b] && ad->shadowReg[first+b] == want[b] )  b--;
+
+    ad->ops->spi_transfer(CMD_WREG | (first+a));
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(b-a);                // number of registers - 1
+    ad->ops->wait_us(SPI_DELAY);
+    for (k = a; k <= b; k++) {
+        ad->ops->spi_transfer(want[k]);
+        ad->shadowReg[first+k] = want[k];
+        ad->shadowSet[first+k] = 1;
+    }
+    return b-a+1;
+}
+
+
 /* name: resetADS1256
- * function: reset the ADS1256 chip
+ * function: reset an ADS1256 chip with its RESET pin, and wait for DRDY,
+ *           which goes low when the reset and the self-calibration that
+ *           follows it are complete (about 1 ms at the default 30 kSPS)
  * parameter:
- * Info: t16 delay time > 4 x tau_clkin = 0.5 use
+ * Info: t16 RESET low time > 4 x tau_clkin = 0.52 us;  datasheet p.34
+ * The return value:  0:successful 1:DRDY did not go low
  */
-void resetADS1256(void)
+int resetADS1256(struct ADS1256 *ad)
 {
-    fprintf(stderr," ADS1256 reset "); fflush(stderr);
-    bcm2835_gpio_write( AD_RESET , HIGH );
-    delay_ms(50);
-    bcm2835_gpio_write( AD_RESET , LOW ); 
-    delay_ms(50); 
-    bcm2835_gpio_write( AD_RESET , HIGH );
-    delay_ms(50); 
-    fprintf(stderr," . . . . . . . . . . . . . . . . . . . . . . . . .  success \n");
+    ad->ops->gpio_write( ad->reset , LOW ); 
+    ad->ops->wait_us(1);                       // t16 > 0.52 us
+    ad->ops->gpio_write( ad->reset , HIGH );
+    ad->ops->wait_us(1);                       // DRDY goes high
+    memset ( ad->shadowSet, 0, sizeof(ad->shadowSet) ); // back to power-up values
+    return ADS1256_WaitDRDY(ad, ADS1256_RESET_US);
 }
 
 
@@ -91,25 +200,65 @@ int initHPADDAboard()
 
     fprintf(stderr," bcm2835 GPIO pin configuration  "); fflush(stderr);
     // GPIO output pin selection 
-    // ... AD pin settings
-    bcm2835_gpio_fsel( AD_RESET   , BCM2835_GPIO_FSEL_OUTP );
-    bcm2835_gpio_fsel( AD_SPI_CS  , BCM2835_GPIO_FSEL_OUTP );
-    bcm2835_gpio_write( AD_SPI_CS , HIGH);
-    bcm2835_gpio_fsel( AD_DRDY    , BCM2835_GPIO_FSEL_INPT );
-    bcm2835_gpio_set_pud( AD_DRDY , BCM2835_GPIO_PUD_UP );
-    delay_us(10);               // wait t6 ??
-    // ... DA pin settings
-    bcm2835_gpio_fsel( DA_SPI_CS  , BCM2835_GPIO_FSEL_OUTP );
-    bcm2835_gpio_write( DA_SPI_CS , HIGH);
+    // ... DA pin settings, the DAC8532 on the bus
+    DAC8532_Open ( &dac8532, &hpadda_bcm2835, DA_SPI_CS );
     // set PIN_38 and PIN_40 to outputs
     bcm2835_gpio_fsel( PIN_38 , BCM2835_GPIO_FSEL_OUTP );
     bcm2835_gpio_fsel( PIN_40 , BCM2835_GPIO_FSEL_OUTP );
     fprintf(stderr," . . . . . . . . . . . . . . . .  success \n");
 
-    resetADS1256();
+    // ... the AD pins, and the bring-up of the ADS1256 of the board
+    return ADS1256_Open ( &ads1256, &hpadda_bcm2835,
+                          AD_SPI_CS, AD_DRDY, AD_RESET );
+}
+
+
+/*   name: ADS1256_Open
+ *   function: configure the pins of an ADS1256, reset it, check its chip
+ *             ID, and write its registers;  after initHPADDAboard, for
+ *             another ADS1256 on the SPI bus with its own chip select,
+ *             DRDY and RESET pins
+ *   parameter: ad    : the converter, opened
+ *              ops   : the backend, &hpadda_bcm2835 on the Raspberry Pi
+ *              cs, drdy, reset : the pins of the converter
+ *   The return value:  0:successful 1:Abnormal
+ */
+int ADS1256_Open(struct ADS1256 *ad, const struct HPADDA_OPS *ops, uint8_t cs, uint8_t drdy, uint8_t reset)
+{
+    memset ( ad, 0, sizeof(*ad) );
+    ad->ops   = ops;
+    ad->cs    = cs;
+    ad->drdy  = drdy;
+    ad->reset = reset;
+
+    ad->ops->gpio_fsel( ad->reset , BCM2835_GPIO_FSEL_OUTP );
+    ad->ops->spi_attach( ad->cs );         // on the bus, not selected
+    ad->ops->gpio_fsel( ad->drdy  , BCM2835_GPIO_FSEL_INPT );
+    ad->ops->gpio_set_pud( ad->drdy , BCM2835_GPIO_PUD_UP );
+    ad->ops->wait_us(10);       // wait t6 ??
+
+    // each step below waits for DRDY or for the datasheet minimum time,
+    // rather than a fixed sleep, and its duration is reported 
+    struct timespec t0, tStart;
+    double   ms[4];
+    int      reg, bad = 0;
+
+    clock_gettime ( CLOCK_MONOTONIC, &tStart );
+    t0 = tStart;
+
+    fprintf(stderr," ADS1256 reset "); fflush(stderr);
+    if ( resetADS1256(ad) ) {
+        color(1); color(31); 
+        fprintf(stderr," . . . . . . . . . . . . . . . . . . . . . . . .  DRDY timeout \n");
+        fprintf(stderr," . . . try rebooting the Raspberry PI . . . \n");
+        color(1); color(37); 
+        return 1;
+    }
+    ms[0] = elapsed_ms ( &t0 );
+    fprintf(stderr," . . . . . . . . . . . . . . . . . . . . . . . . .  success \n");
 
     fprintf(stderr," ADS1256 chip ID read  "); fflush(stderr);
-    if( ADS1256_ReadChipID() == 3){
+    if( ADS1256_ReadChipID(ad) == 3){
         fprintf(stderr," . . . . . . . . . . . . . . . . . . . . .  success \n");
     } else {
         color(1); color(31); 
@@ -118,43 +267,41 @@ int initHPADDAboard()
         color(1); color(37); 
         return 1;
     }
+    ms[1] = elapsed_ms ( &t0 );
 
     fprintf(stderr," ADS1256 set registers "); fflush(stderr);
-    // set ADS1256 registers ( just in case ...)
-    bcm2835_gpio_write( DA_SPI_CS , HIGH);
-    bcm2835_gpio_write( AD_SPI_CS , LOW);  // AD1256 SPI Start
-    delay_us(10);               // wait t6  ??
-
-    bcm2835_spi_transfer(0xFE); // reset
-    delay_ms(2);                // minimum 0.6 ms required for Reset to finish
-    bcm2835_spi_transfer(0x0F); // issues SDATAC to do the reset
-    delay_us(10);               // wait t6
-    bcm2835_spi_transfer(CMD_WREG | 0);  // Command : Write from 0 register
-    delay_ms(2);               
-    bcm2835_spi_transfer(4);  // Number of Registers to write - 1 = 5 - 1 = 4
-    delay_ms(500); 
-    bcm2835_spi_transfer(0x01);    // register 0x00 : STATUS
-    delay_ms(200);                 // ??
-    bcm2835_spi_transfer(0x01);    // register 0x01 : MUX 
-    delay_ms(200);                 // ??
-    bcm2835_spi_transfer(0x20);    // register 0x02 : ADCON (reset value = 0x20)
-    delay_ms(200);                 // ??
-    bcm2835_spi_transfer(0xF0);    // register 0x03 : CSPEED
-    delay_ms(500);                 // ??
-    bcm2835_spi_transfer(0xE0);    // register 0x04 : IO
-    delay_ms(200);                 // ??
-
+    // write STATUS, MUX, ADCON, CSPEED and IO with one WREG command
+    if ( ADS1256_WaitDRDY(ad, ADS1256_DRDY_US) ) bad = 1;
+    ad->ops->spi_claim( ad->cs );
+    ad->ops->gpio_write( ad->cs , LOW);    // AD1256 SPI Start
+    ad->ops->spi_transfer(CMD_SDATAC);     // stop read data continuously
+    ad->ops->wait_us(1);                   // t11 > 4 tau_clkin = 0.52 us
+    ad->ops->spi_transfer(CMD_WREG | REG_STATUS); // write from register 0 
+    ad->ops->spi_transfer(4);      // Number of Registers to write - 1 = 5 - 1 = 4
+    for (reg = 0; reg < 5; reg++) {
+        ad->ops->spi_transfer(initReg[reg]);
+        ad->shadowReg[reg] = initReg[reg];
+        ad->shadowSet[reg] = 1;
+    }
+    ad->ops->wait_us(1);                   // t11 
+    ad->ops->gpio_write( ad->cs, HIGH );   // ADS1256 SPI end
+    ms[2] = elapsed_ms ( &t0 );
+
+    // verify the registers, instead of trusting long sleeps, and learn
+    // the calibration registers of the reset
+    if ( !bad && ADS1256_VerifyShadow(ad) )  bad = 1;
+    ms[3] = elapsed_ms ( &t0 );
+    if ( bad ) {
+        color(1); color(31); 
+        fprintf(stderr," . . . . . . . . . . . . . . . . . . . . .  failed \n");
+        fprintf(stderr," . . . try rebooting the Raspberry PI . . . \n");
+        color(1); color(37); 
+        return 1;
+    }
     fprintf(stderr," . . . . . . . . . . . . . . . . . . . . .  success \n");
 
-    bcm2835_gpio_write( AD_SPI_CS, HIGH );  // ADS1256 SPI end
-
-    ADS1256_PrintAllReg();
-
-
-/*
-    bcm2835_spi_end();         // end SPI transaction ??
-*/
-
+    fprintf(stderr," ADS1256 bring-up %.2f ms:  reset %.2f  chip ID %.2f  write %.2f  verify %.2f\n",
+                    elapsed_ms ( &tStart ), ms[0], ms[1], ms[2], ms[3] );
 
     return 0;
 }
@@ -182,13 +329,13 @@ void closeHPADDAboard()
  *   parameter: RegID: register  ID
  *   The return value: read register value
  */
-uint8_t ADS1256_ReadReg(uint8_t RegID)
+uint8_t ADS1256_ReadReg(struct ADS1256 *ad, uint8_t RegID)
 {
     uint8_t registerValueR;
 
-    bcm2835_gpio_write(DA_SPI_CS,HIGH);
+    ad->ops->spi_claim(ad->cs);              // the others off the bus
 
-    while(bcm2835_gpio_lev(AD_DRDY)) { /* wait for DRDY to go low */ }
+    while(ad->ops->gpio_lev(ad->drdy)) { /* wait for DRDY to go low */ }
 
 /*
     //SPI settings
@@ -199,15 +346,15 @@ uint8_t ADS1256_ReadReg(uint8_t RegID)
     bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_64);  //6.250Mhz on Raspberry Pi 3 
 */
 
-    bcm2835_gpio_write(AD_SPI_CS,LOW);       // SPI  cs  = 0
-    delay_us(10);                            // t6 delay
-    bcm2835_spi_transfer(CMD_RREG | RegID);  // Read REGister command 
-    delay_us(10);                            // t6 delay
-    bcm2835_spi_transfer(0x00);              // number of bytes to read minus 1
-    delay_us(10);                            // The minimum time delay 6.5us 
-    registerValueR = bcm2835_spi_transfer(0xff);  // Read the register values 
-    delay_us(10);                            // The minimum time delay 6.5us 
-    bcm2835_gpio_write(AD_SPI_CS,HIGH);      // SPI   cs  = 1 
+    ad->ops->gpio_write(ad->cs,LOW);         // SPI  cs  = 0
+    ad->ops->wait_us(10);                    // t6 delay
+    ad->ops->spi_transfer(CMD_RREG | RegID); // Read REGister command 
+    ad->ops->wait_us(10);                    // t6 delay
+    ad->ops->spi_transfer(0x00);             // number of bytes to read minus 1
+    ad->ops->wait_us(10);                    // The minimum time delay 6.5us 
+    registerValueR = ad->ops->spi_transfer(0xff); // Read the register values 
+    ad->ops->wait_us(10);                    // The minimum time delay 6.5us 
+    ad->ops->gpio_write(ad->cs,HIGH);        // SPI   cs  = 1 
 /*
     bcm2835_spi_end();                       // end SPI transaction
 */
@@ -222,12 +369,15 @@ uint8_t ADS1256_ReadReg(uint8_t RegID)
  *              RegValue: register Value
  *   The return value: NULL
 */
-void ADS1256_WriteReg(uint8_t RegID, uint8_t RegValue)
+void ADS1256_WriteReg(struct ADS1256 *ad, uint8_t RegID, uint8_t RegValue)
 {
-    bcm2835_gpio_write(DA_SPI_CS,HIGH);
+    if ( RegID < 11 && ad->shadowSet[RegID] && ad->shadowReg[RegID] == RegValue )
+        return;                              // already in the chip
+
+    ad->ops->spi_claim(ad->cs);              // the others off the bus
 
     // relevant video: https://youtu.be/KQ0nWjM-MtI
-    while(bcm2835_gpio_lev(AD_DRDY)) { /* wait for DRDY to go low */ }
+    while(ad->ops->gpio_lev(ad->drdy)) { /* wait for DRDY to go low */ }
 
 /*
     bcm2835_spi_begin();                     // begin SPI transaction
@@ -237,13 +387,17 @@ void ADS1256_WriteReg(uint8_t RegID, uint8_t RegValue)
     bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_64);  //6.250Mhz on Raspberry Pi 3 
 */
 
-    bcm2835_gpio_write(AD_SPI_CS,LOW);       // SPI  cs  = 0
-    delay_us(10);                            // t6 delay
-    bcm2835_spi_transfer(CMD_WREG | RegID);  // Write REGister command
-    bcm2835_spi_transfer(0x00);              // number of bytes to write minus 1
-    delay_us(10);                            // t6 delay
-    bcm2835_spi_transfer(RegValue);          // send register value 
-    bcm2835_gpio_write(AD_SPI_CS,HIGH);      // SPI   cs = 1
+    ad->ops->gpio_write(ad->cs,LOW);         // SPI  cs  = 0
+    ad->ops->wait_us(10);                    // t6 delay
+    ad->ops->spi_transfer(CMD_WREG | RegID); // Write REGister command
+    ad->ops->spi_transfer(0x00);             // number of bytes to write minus 1
+    ad->ops->wait_us(10);                    // t6 delay
+    ad->ops->spi_transfer(RegValue);         // send register value 
+    ad->ops->gpio_write(ad->cs,HIGH);        // SPI   cs = 1
+    if ( RegID < 11 ) {
+        ad->shadowReg[RegID] = RegValue;
+        ad->shadowSet[RegID] = 1;
+    }
 /*
     bcm2835_spi_end();                       // end SPI transaction
 */
@@ -255,12 +409,12 @@ void ADS1256_WriteReg(uint8_t RegID, uint8_t RegValue)
  *   parameter: _cmd : NULL
  *   The return value: four high status register
  */
-uint8_t ADS1256_ReadChipID(void)
+uint8_t ADS1256_ReadChipID(struct ADS1256 *ad)
 {
     uint8_t chipID;
 
-    while(bcm2835_gpio_lev(AD_DRDY)) { /* wait for DRDY to go low */ }
-    chipID = ADS1256_ReadReg(REG_STATUS);
+    while(ad->ops->gpio_lev(ad->drdy)) { /* wait for DRDY to go low */ }
+    chipID = ADS1256_ReadReg(ad, REG_STATUS);
     return (chipID >> 4);
 }
 
@@ -271,13 +425,13 @@ uint8_t ADS1256_ReadChipID(void)
  *   parameter: NULL
  *   The return value:  NULL
  * ------------------------------------------------------------------------- */
-void ADS1256_PrintAllReg()
+void ADS1256_PrintAllReg(struct ADS1256 *ad)
 {
     const char regName[11][20] = {"STATUS", "MUX   ", "ADCON ", "CSPEED", "IO    ",
                             "OFC0  ", "OFC1  ", "OFC2  ", "FSC0  ", "FSC1  ", "FSC2  "};
     int reg;
     for (reg = 0 ; reg < 11 ; reg++)
-        printf("%s : %4x\n", regName[reg] , ADS1256_ReadReg(reg));
+        printf("%s : %4x\n", regName[reg] , ADS1256_ReadReg(ad, reg));
 }
 
 
@@ -287,7 +441,7 @@ void ADS1256_PrintAllReg()
  *   This speed is for one input. It becomes later in the case of multi input.
  *   The return value: Actual set value
  */
-float ADS1256_SetDigitizationRate( float drate )
+float ADS1256_SetDigitizationRate( struct ADS1256 *ad, float drate )
 {
     ADS1256_CSPEED set_drate_e = ADS1256_100_SPS;// default 1000 conversions/sec
     float set_drate_f = ADS1256_1000_FRQ;        // default 1000 conversions/sec
@@ -357,7 +511,7 @@ float ADS1256_SetDigitizationRate( float drate )
       set_drate_f = ADS1256_30000_FRQ; 
     }
 
-    ADS1256_WriteReg( 3 , set_drate_e );
+    ADS1256_WriteReg( ad, REG_CSPEED , set_drate_e );
 
     return set_drate_f;
 }
@@ -421,9 +575,114 @@ float ADS1256_range_value ( uint8_t rangeCode )
 /*
 ADS1256_SET_GAIN - set the gain for all channels on ADS1256
 -----------------------------------------------------------------*/
-void ADS1256_set_gain ( uint8_t rangeCode ) 
+void ADS1256_set_gain ( struct ADS1256 *ad, uint8_t rangeCode ) 
+{
+  uint8_t adcon = ad->shadowSet[REG_ADCON] ? ad->shadowReg[REG_ADCON]
+                                           : ADS1256_ReadReg(ad, REG_ADCON);
+
+  ADS1256_WriteReg( ad, REG_ADCON , (adcon & 0xf8) | (rangeCode & 0x07) );
+}
+
+
+/*   name: ADS1256_VerifyShadow
+ *   function: read all eleven registers with one RREG command, report those
+ *             that differ from the shadow, and make the shadow match the chip
+ *   The return value:  the number of registers that differed, -1: DRDY timeout
+ */
+int ADS1256_VerifyShadow ( struct ADS1256 *ad )
+{
+    uint8_t  value[11];
+    int      reg, bad = 0;
+
+    ad->ops->spi_claim(ad->cs);              // the others off the bus
+    if ( ADS1256_WaitDRDY(ad, ADS1256_DRDY_US) )  return -1;
+    ad->ops->gpio_write(ad->cs,LOW);         // SPI  cs  = 0
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(CMD_RREG | REG_STATUS);
+    ad->ops->spi_transfer(10);               // number of bytes to read minus 1
+    ad->ops->wait_us(10);                    // t6 delay
+    for (reg = 0; reg < 11; reg++)
+        value[reg] = ad->ops->spi_transfer(0xFF);
+    ad->ops->gpio_write(ad->cs,HIGH);        // SPI   cs  = 1
+
+    for (reg = 0; reg < 11; reg++) {
+        if ( ad->shadowSet[reg] && ((value[reg] ^ ad->shadowReg[reg]) & regMask[reg]) ) {
+            color(1); color(31);
+            fprintf(stderr,"\n register 0x%02x reads 0x%02x, 0x%02x was written ",
+                            reg, value[reg], ad->shadowReg[reg] );
+            ++bad;
+        }
+        ad->shadowReg[reg] = value[reg];
+        ad->shadowSet[reg] = 1;
+    }
+    return bad;
+}
+
+
+/*   name: ADS1256_SelfCal
+ *   function: self-calibrate the offset and full scale at one PGA gain and
+ *             the present data rate, and read the six calibration registers
+ *   parameter: rangeCode : the PGA gain
+ *              cal       : OFC0 OFC1 OFC2 FSC0 FSC1 FSC2, returned
+ *   Info: self-calibration takes from 0.6 ms at 30 kSPS to 1.2 s at 2.5 SPS,
+ *         DRDY is high while it runs;  datasheet p.27, table 21
+ *   The return value:  0:successful 1:DRDY did not go low
+ */
+int ADS1256_SelfCal ( struct ADS1256 *ad, uint8_t rangeCode, uint8_t cal[6] )
+{
+    uint64_t start;
+    int      reg;
+
+    ADS1256_set_gain ( ad, rangeCode );
+
+    ad->ops->spi_claim(ad->cs);              // the others off the bus
+    if ( ADS1256_WaitDRDY(ad, ADS1256_DRDY_US) )  return 1;
+    ad->ops->gpio_write(ad->cs,LOW);         // SPI  cs  = 0
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(CMD_SELFCAL);      // offset and gain self-cal
+    ad->ops->gpio_write(ad->cs,HIGH);        // SPI  cs  = 1
+
+    start = ad->ops->st_read();              // DRDY goes high, then low
+    while ( !ad->ops->gpio_lev(ad->drdy) && ad->ops->st_read() - start < 100 ) { }
+    if ( ADS1256_WaitDRDY(ad, ADS1256_CAL_US) )  return 1;
+
+    ad->ops->gpio_write(ad->cs,LOW);         // read the six registers
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(CMD_RREG | REG_OFC0);
+    ad->ops->spi_transfer(0x05);             // number of bytes to read minus 1
+    ad->ops->wait_us(10);                    // t6 delay
+    for (reg = 0; reg < 6; reg++)
+        cal[reg] = ad->ops->spi_transfer(0xFF);
+    ad->ops->gpio_write(ad->cs,HIGH);        // SPI   cs  = 1
+
+    for (reg = 0; reg < 6; reg++) {          // the chip has it already
+        ad->shadowReg[REG_OFC0+reg] = cal[reg];
+        ad->shadowSet[REG_OFC0+reg] = 1;
+    }
+    ADS1256_SetCal ( ad, rangeCode, cal );
+    return 0;
+}
+
+
+/*   name: ADS1256_SetCal
+ *   function: keep the calibration of one PGA gain, written to the chip by
+ *             ADS1256_ChannelScan when a channel changes to this gain
+ *   parameter: rangeCode : the PGA gain
+ *              cal       : OFC0 OFC1 OFC2 FSC0 FSC1 FSC2
+ */
+void ADS1256_SetCal ( struct ADS1256 *ad, uint8_t rangeCode, const uint8_t cal[6] )
 {
-  ADS1256_WriteReg( 2 , (ADS1256_ReadReg(2) & 0xf8) | (rangeCode & 0x07) );
+    memcpy ( ad->calReg[rangeCode & 0x07], cal, 6 );
+    ad->calSet[rangeCode & 0x07] = 1;
+}
+
+
+/*   name: ADS1256_ClearCal
+ *   function: forget the calibrations of all PGA gains
+ */
+void ADS1256_ClearCal ( struct ADS1256 *ad )
+{
+    memset ( ad->calSet, 0, sizeof(ad->calSet) );
 }
 
 
@@ -441,7 +700,7 @@ void ADS1256_set_gain ( uint8_t rangeCode )
  * 
  *    The return value:  ADC vaule 
  */
-int32_t ADS1256_GetADC(int8_t positive_no , int8_t negative_no )
+int32_t ADS1256_GetADC(struct ADS1256 *ad, int8_t positive_no , int8_t negative_no )
 {
     int8_t positive_common =  0;    // Bit 7
     int8_t negative_common =  1;    // Bit 3
@@ -474,7 +733,8 @@ int32_t ADS1256_GetADC(int8_t positive_no , int8_t negative_no )
     }
     mux_data = (positive_common << 7) | ((positive_no & 7) << 4) | (negative_common << 3) | ((negative_no & 7));
 
-    while(bcm2835_gpio_lev(AD_DRDY)) { /* wait for DRDY to go low */ }
+    ad->ops->spi_claim(ad->cs);              // the others off the bus
+    while(ad->ops->gpio_lev(ad->drdy)) { /* wait for DRDY to go low */ }
 
 /*
     bcm2835_spi_begin();                     // begin SPI transaction
@@ -484,33 +744,35 @@ int32_t ADS1256_GetADC(int8_t positive_no , int8_t negative_no )
     bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_64);  //6.250Mhz on Raspberry Pi 3 
 */
 
-    bcm2835_gpio_write(AD_SPI_CS,LOW);       // SPI  cs  = 0
-    delay_us(10);                            // t6 delay
-
-    bcm2835_spi_transfer(CMD_WREG | REG_MUX);// Write to MUX REGister
-    bcm2835_spi_transfer(0x00);              // number of bytes to write minus 1
-    delay_us(10);                            // t6 delay
-    bcm2835_spi_transfer(mux_data);          // set the MUX
-    delay_us(SPI_DELAY);
-    bcm2835_spi_transfer(CMD_SYNC);          // Step 2.     
-    delay_us(4);                 // t11 delay 24*tau = 3.125 us round up to 4 us
-    bcm2835_spi_transfer(CMD_WAKEUP_FF);
-    delay_us(SPI_DELAY);
-    bcm2835_spi_transfer(CMD_RDATA);         // Step 3. 
-    delay_us(5);                         // t6 delay (~6.51 us) p.34, fig.30
+    ad->ops->gpio_write(ad->cs,LOW);         // SPI  cs  = 0
+    ad->ops->wait_us(10);                    // t6 delay
+
+    ad->ops->spi_transfer(CMD_WREG | REG_MUX);// Write to MUX REGister
+    ad->ops->spi_transfer(0x00);             // number of bytes to write minus 1
+    ad->ops->wait_us(10);                    // t6 delay
+    ad->ops->spi_transfer(mux_data);         // set the MUX
+    ad->shadowReg[REG_MUX] = (uint8_t) mux_data;
+    ad->shadowSet[REG_MUX] = 1;
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(CMD_SYNC);         // Step 2.     
+    ad->ops->wait_us(4);         // t11 delay 24*tau = 3.125 us round up to 4 us
+    ad->ops->spi_transfer(CMD_WAKEUP_FF);
+    ad->ops->wait_us(SPI_DELAY);
+    ad->ops->spi_transfer(CMD_RDATA);        // Step 3. 
+    ad->ops->wait_us(5);                 // t6 delay (~6.51 us) p.34, fig.30
 
     // Read the sample result as 24 bits in three 8-bit bytes
     // step out the data: MSB | mid-byte | LSB,
-    registerData |= bcm2835_spi_transfer(0x0F); // transfer MSB (high 8 bits) first 
+    registerData |= ad->ops->spi_transfer(0x0F); // transfer MSB (high 8 bits) first 
     registerData <<= 8;                         // shift MSB to the LEFT by 8 bits
-    delay_us(SPI_DELAY);
-    registerData |= bcm2835_spi_transfer(0x0F); // MSB, Mid-byte 
+    ad->ops->wait_us(SPI_DELAY);
+    registerData |= ad->ops->spi_transfer(0x0F); // MSB, Mid-byte 
     registerData <<= 8;                         // shift MSB , Mid-byte LEFT by 8 bits
-    delay_us(SPI_DELAY);
-    registerData |= bcm2835_spi_transfer(0x0F); // (MSB, Mid-byte) | LSB
+    ad->ops->wait_us(SPI_DELAY);
+    registerData |= ad->ops->spi_transfer(0x0F); // (MSB, Mid-byte) | LSB
                                                 // AD_DRDY should now go HIGH 
 
-    bcm2835_gpio_write(AD_SPI_CS,HIGH);
+    ad->ops->gpio_write(ad->cs,HIGH);
 
 /*
     bcm2835_spi_end();                          // reset all SPI pins to input mode
@@ -520,16 +782,64 @@ int32_t ADS1256_GetADC(int8_t positive_no , int8_t negative_no )
 }
 
 
+/*    name: ADS1256_ReadScanData
+ *    function:  RDATA, with SPI_CS low, the data of the last conversion
+ *    The return value:  the conversion, sign extended
+ */
+static int32_t ADS1256_ReadScanData(struct ADS1256 *ad)
+{
+    uint32_t  registerData = 0x00000000; 
+
+    ad->ops->spi_transfer(CMD_RDATA);    // Step 3. 
+
+    ad->ops->wait_us(10);           // t6 delay (~6.51 us) p.34, fig.30 10us?
+
+    // read the sample results to a 24 bit value in 3 8-bit bytes
+    // step out the data in this order: MSB | mid-byte | LSB,
+    registerData |= ad->ops->spi_transfer(0xFF); // transfer MSB (high 8 bits)
+    registerData <<= 8;                  // shift MSB, Low-byte LEFT by 8 bits
+    ad->ops->wait_us(SPI_DELAY);
+    registerData |= ad->ops->spi_transfer(0xFF); // MSB, Mid-byte 
+    registerData <<= 8;                  // shift MSB, Mid-byte LEFT by 8 bits
+    ad->ops->wait_us(SPI_DELAY);
+    registerData |= ad->ops->spi_transfer(0xFF); // (MSB, Mid-byte) | LSB
+                                         // DRDY should now go HIGH 
+
+    // extend a signed number
+    if (registerData & 0x800000)   registerData |= 0xFF000000;   
+
+    return (int32_t)(registerData);
+}
+
+
 /*    name: ADS1256_ChannelScan
- *    function:  read 8 values of ADS1256 input
- *    parameter: NULL
- *    The return value:  NULL
+ *    function:  read nChnl values of ADS1256 input, in the order of muxCode
+ *    parameter: ad: the converter
+ *               tConv: conversion instant of each channel, system timer,
+ *               micro-seconds, or NULL
+ *               nAvg: conversions averaged for each channel, or NULL for 1
+ *    The return value:  0: successful,  1: DRDY timed out, not converting
  *    https://curiousscientist.tech/blog/ads1256-arduino-stm32-sourcecode
+ *
+ *    The MUX of the next channel is written, and its conversion started,
+ *    before the data of the last conversion is read, datasheet figure 19,
+ *    so the RDATA of step chn returns the channel of step chn-1, and one
+ *    more step reads the last channel.  The conversion instant of a
+ *    channel is the middle of its conversion, from the WAKEUP to DRDY.
+ *
+ *    A channel with nAvg > 1 is read before the MUX changes, with the
+ *    nAvg-1 conversions that follow it on the same MUX, without a WREG or
+ *    a SYNC, and their sum is averaged in integer.  Its conversion instant
+ *    is then the middle of all of its conversions.  RDATA sets DRDY high
+ *    until the next conversion is ready, so each further conversion is the
+ *    next low of DRDY, even one that was ready before RDATA ended.
  */
-void ADS1256_ChannelScan(unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[], int32_t adScan[])
+int ADS1256_ChannelScan(struct ADS1256 *ad, unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[], int32_t adScan[], uint64_t tConv[], uint8_t nAvg[])
 {
-    uint32_t  registerData = 0x00000000; 
-    int       chn;
+    uint64_t  tWake = 0, tNext = 0, tDone;
+    int64_t   sum;
+    int       chn, n, k, avg;
+    uint8_t   gain, want[10];
 
 /*
     bcm2835_spi_begin();                   // begin SPI transaction
@@ -544,60 +854,79 @@ void ADS1256_ChannelScan(unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[],
 // channels are written manually, 
 // so we save time by switching the SPI.beginTransaction on and off.
 // datasheet page 21, figure 19
-    for (chn = 0; chn < nChnl; chn++) {
-      
-      registerData = 0x00000000;           // reset registerData
-
-      while (bcm2835_gpio_lev(AD_DRDY)) { } // wait for DRDY to go low 
-
-      bcm2835_gpio_write(AD_SPI_CS,LOW);   // SPI start
-
-      // Step 1.A - Update MUX  - datasheet page 21 figure 19 
-      // Step 1.B - Update PGA  - datasheet page 31 ADCON
-      delay_us(SPI_DELAY); 
-      bcm2835_spi_transfer(CMD_WREG | REG_MUX); // write from register REG_MUX
-      delay_us(SPI_DELAY); 
-      bcm2835_spi_transfer(0x01); // Number of Registers to write - 1 = 2-1=1
-      delay_us(SPI_DELAY); 
-      bcm2835_spi_transfer(muxCode[chn]);            // set the multiplexer
-      delay_us(SPI_DELAY);
-      bcm2835_spi_transfer( 0x20 | rangeCode[chn] ); // set the PGA
- 
-      delay_us(5); //??
-
-//    bcm2835_gpio_write(AD_SPI_CS,LOW);   // SPI start //?? 
-
-      bcm2835_spi_transfer(CMD_SYNC);      // Step 2.     
-      delay_us(4);                         // t6 delay
-      bcm2835_spi_transfer(CMD_WAKEUP_FF);
-      delay_us(SPI_DELAY);
-      bcm2835_spi_transfer(CMD_RDATA);     // Step 3. 
-
-      delay_us(10);                   // t6 delay (~6.51 us) p.34, fig.30 10us?
-     
-      // read the sample results to a 24 bit value in 3 8-bit bytes
-      // step out the data in this order: MSB | mid-byte | LSB,
-      registerData |= bcm2835_spi_transfer(0xFF); // transfer MSB (high 8 bits)
-      registerData <<= 8;                  // shift MSB, Low-byte LEFT by 8 bits
-      delay_us(SPI_DELAY);
-      registerData |= bcm2835_spi_transfer(0xFF); // MSB, Mid-byte 
-      registerData <<= 8;                  // shift MSB, Mid-byte LEFT by 8 bits
-      delay_us(SPI_DELAY);
-      registerData |= bcm2835_spi_transfer(0xFF); // (MSB, Mid-byte) | LSB
-                                           // DRDY should now go HIGH 
+    if (nChnl == 0)  return 0;
+    ad->ops->spi_claim(ad->cs);            // the others off the bus
+    for (chn = 0; chn <= (int) nChnl; chn++) {
+
+      // the conversion in progress before the first channel is abandoned
+      if (chn > 0 && ADS1256_WaitDRDY(ad, ADS1256_DRDY_US))
+          return 1;                        // DRDY low, the channel converted
+      tDone = ad->ops->st_read();
+
+      // a channel of the last step averaged over its next conversions
+      avg = ( chn > 0 && nAvg ) ? nAvg[chn-1] : 1;
+      if (avg > 1) {
+        ad->ops->gpio_write(ad->cs,LOW);
+        sum = ADS1256_ReadScanData(ad);
+        ad->ops->gpio_write(ad->cs,HIGH);
+        for (k = 1; k < avg; k++) {
+          if ( ADS1256_WaitDRDY(ad, ADS1256_DRDY_US) )  // the next conversion
+              return 1;
+          tDone = ad->ops->st_read();
+          ad->ops->gpio_write(ad->cs,LOW);
+          sum += ADS1256_ReadScanData(ad);
+          ad->ops->gpio_write(ad->cs,HIGH);
+        }
+        // save the average, rounded, to ad_scan array
+        adScan[chn-1] = (int32_t)( ( 2*sum + ( sum < 0 ? -avg/2 : avg/2 ) ) / avg ); // *2??
+        if (tConv)  tConv[chn-1] = ( tWake + tDone ) / 2;
+      }
+
+      ad->ops->gpio_write(ad->cs,LOW);     // SPI start
+
+      if (chn < (int) nChnl) {
+        // Step 1.A - Update MUX  - datasheet page 21 figure 19 
+        // Step 1.B - Update PGA  - datasheet page 31 ADCON
+        // Step 1.C - and the calibration of the PGA gain, OFC0..2 FSC0..2
+        // only the registers that change are written, with one WREG
+        gain = rangeCode[chn] & 0x07;
+        want[0] = muxCode[chn];                   // the multiplexer
+        want[1] = 0x20 | gain;                    // the PGA
+        n = 2;
+        if ( ad->calSet[gain] && ad->shadowSet[REG_CSPEED] && ad->shadowSet[REG_IO] ) {
+            want[2] = ad->shadowReg[REG_CSPEED];  // unchanged
+            want[3] = ad->shadowReg[REG_IO];      // unchanged
+            memcpy ( want+4, ad->calReg[gain], 6 );
+            n = 10;
+        }
+        ad->ops->wait_us(SPI_DELAY); 
+        if ( shadow_wreg ( ad, REG_MUX, n, want ) )
+            ad->ops->wait_us(5); //??
+
+//      ad->ops->gpio_write(ad->cs,LOW);   // SPI start //?? 
+
+        ad->ops->spi_transfer(CMD_SYNC);     // Step 2.     
+        ad->ops->wait_us(4);                 // t6 delay
+        ad->ops->spi_transfer(CMD_WAKEUP_FF);
+        tNext = ad->ops->st_read();          // the conversion starts
+        ad->ops->wait_us(SPI_DELAY);
+      }
+
+      if (chn > 0 && avg == 1) {           // the channel of the last step
+        // save data to ad_scan array
+        adScan[chn-1] = 2*ADS1256_ReadScanData(ad);    // *2??
+        if (tConv)  tConv[chn-1] = ( tWake + tDone ) / 2;
+      }
 
       // transfer sequence complete, so switch the A/D SPI_CS back to HIGH
-      bcm2835_gpio_write(AD_SPI_CS,HIGH);  // SPI stop
-
-      // extend a signed number
-      if (registerData & 0x800000)   registerData |= 0xFF000000;   
+      ad->ops->gpio_write(ad->cs,HIGH);    // SPI stop
 
-      // save data to ad_scan array
-      adScan[chn] = 2*(int32_t)(registerData);    // *2??
+      tWake = tNext;
     }
 /*
     bcm2835_spi_end();  // reset all SPI pins to input mode   //??
 */
+    return 0;
 }
 
 
@@ -615,10 +944,10 @@ double ADS1256_IntToVolt(int32_t value , double vref)
 
 /*    name: ADS1256_PrintAllValue
  *    function:  print 8 values of ADS1256 input
- *    parameter: NULL
+ *    parameter: ad : the converter
  *    The return value:  NULL
  * ------------------------------------------------------------------------ */
-void ADS1256_PrintAllValue()
+void ADS1256_PrintAllValue(struct ADS1256 *ad)
 {
    uint8_t  chn;
    int32_t ad_scan[NUMCHNL];
@@ -628,7 +957,7 @@ void ADS1256_PrintAllValue()
    uint8_t rangeCode[8] = { 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 };
 
 
-    ADS1256_ChannelScan(8, muxCode, rangeCode, ad_scan);
+    ADS1256_ChannelScan(ad, 8, muxCode, rangeCode, ad_scan, NULL, NULL);
 
     for (chn = 0 ; chn < 8 ; chn++)
     {
@@ -641,16 +970,16 @@ void ADS1256_PrintAllValue()
 
 /*    name: ADS1256_PrintAllValueDiff
  *    function:  print 4 values of ADS1256 differential input
- *    parameter: NULL
+ *    parameter: ad : the converter
  *    The return value:  NULL
  * ----------------------------------------------------------------------- */
-void ADS1256_PrintAllValueDiff()
+void ADS1256_PrintAllValueDiff(struct ADS1256 *ad)
 {
     int chn;
     int32_t adData;
     for (chn = 0 ; chn < 4 ; chn++)
     {
-        adData = ADS1256_GetADC( 2*chn , 2*chn + 1 );
+        adData = ADS1256_GetADC( ad, 2*chn , 2*chn + 1 );
         printf("%d-%d : %8d \t(%10f[V])\n",2*chn, 2*chn + 1 ,adData, ADS1256_IntToVolt(adData,  5.0 ) );
     }
 }
@@ -660,17 +989,36 @@ void ADS1256_PrintAllValueDiff()
 //  DA Functions
 
 
+/*
+*******************************************************************************
+*    name: DAC8532_Open
+*    function:  put a DAC8532 on the SPI bus, not selected
+*    parameter:  da  : the D/A converter, opened
+*                ops : the backend, &hpadda_bcm2835 on the Raspberry Pi
+*                cs  : its chip select pin
+*    The return value:  NULL
+*******************************************************************************
+*/
+void DAC8532_Open(struct DAC8532 *da, const struct HPADDA_OPS *ops, uint8_t cs)
+{
+    da->ops = ops;
+    da->cs  = cs;
+    da->ops->spi_attach( da->cs );
+}
+
+
 /*
 *******************************************************************************
 *    name: DAC8532_Write
 *    function:  change an output of DAC8532 to target value 
-*    parameter:  dac_channel : channel of DAC8532 (0 or 1)
+*    parameter:  da          : the D/A converter
+*                dac_channel : channel of DAC8532 (0 or 1)
 *                        val : output value to DAC8532 ( 0 - 65536 ) ,
 *   the DAC8532_VoltToValue function converts the integer val to a voltage
 *    The return value:  NULL
 *******************************************************************************
 */
-void DAC8532_Write( int dac_channel , unsigned int val)
+void DAC8532_Write(struct DAC8532 *da, int dac_channel , unsigned int val)
 {   
 
 /*
@@ -681,26 +1029,26 @@ void DAC8532_Write( int dac_channel , unsigned int val)
     bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_64); // 6.250Mhz on Raspberry Pi 3 
 */
 
-    bcm2835_gpio_write(AD_SPI_CS,HIGH);  // ADS1256 SPI end
-    bcm2835_gpio_write(DA_SPI_CS,LOW);
+    da->ops->spi_claim(da->cs);          // every ADS1256 SPI end
+    da->ops->gpio_write(da->cs,LOW);
     if(dac_channel == 0)
     {
-        delay_us(SPI_DELAY);
+        da->ops->wait_us(SPI_DELAY);
 //      bcm2835_spi_transfer(0x30);
-        bcm2835_spi_transfer(0x10);
+        da->ops->spi_transfer(0x10);
     }
     else if(dac_channel == 1)
     {
 //      bcm2835_spi_transfer(0x34);
-        bcm2835_spi_transfer(0x24);
+        da->ops->spi_transfer(0x24);
     }
 
-    delay_us(SPI_DELAY);
-    bcm2835_spi_transfer( (val & 0xff00) >> 8 );  // send upper 8 bits
-    delay_us(SPI_DELAY);
-    bcm2835_spi_transfer(  val & 0x00ff );        // send lower 8 bits
+    da->ops->wait_us(SPI_DELAY);
+    da->ops->spi_transfer( (val & 0xff00) >> 8 );  // send upper 8 bits
+    da->ops->wait_us(SPI_DELAY);
+    da->ops->spi_transfer(  val & 0x00ff );        // send lower 8 bits
 
-    bcm2835_gpio_write(DA_SPI_CS,HIGH);
+    da->ops->gpio_write(da->cs,HIGH);
 /*
     bcm2835_spi_end();  // reset all SPI pins to input mode
 */
@@ -722,24 +1070,50 @@ unsigned int DAC8532_VoltToValue( double volt , double volt_ref)
 }
 
 
+/*    name: ADS1256_WaitDRDYEdge
+ *    function: wait for the next falling edge of DRDY, the end of the next
+ *              conversion of the free-running converter, whether or not the
+ *              last conversion was read;  DRDY goes high briefly before
+ *              each new conversion is ready   datasheet p.20, figure 17
+ *    parameter:  ad         : the converter
+ *                timeout_us : the longest wait, micro-seconds
+ *                t          : the system timer at the edge, micro-seconds
+ *    The return value:  0: DRDY went low,  1: timed out
+ */
+int ADS1256_WaitDRDYEdge(struct ADS1256 *ad, uint32_t timeout_us, uint64_t *t)
+{
+    uint64_t start = ad->ops->st_read();
+
+    while(!ad->ops->gpio_lev(ad->drdy)) {       // the last conversion
+        if ( ad->ops->st_read() - start > timeout_us )
+            return 1;
+    }
+    while(ad->ops->gpio_lev(ad->drdy)) {        // the next conversion
+        if ( ad->ops->st_read() - start > timeout_us )
+            return 1;
+    }
+    *t = ad->ops->st_read();
+    return 0;
+}
+
+
 //#####################################################################
 //  Private Functions
 
 /*    name: ADS1256_WaitDRDY
- *    function: delay time  wait for automatic calibration
- *    parameter:  NULL
- *    The return value:  NULL
+ *    function: wait for DRDY to go low, e.g., after a reset or calibration
+ *    parameter:  ad         : the converter
+ *                timeout_us : the longest wait, micro-seconds
+ *    The return value:  0: DRDY is low,  1: timed out
  */
-void ADS1256_WaitDRDY(void)
+int ADS1256_WaitDRDY(struct ADS1256 *ad, uint32_t timeout_us)
 {
-    uint32_t i;
+    uint64_t start = ad->ops->st_read();
 
-    for (i = 0; i < 1000000; i++)
-    {
-        while(bcm2835_gpio_lev(AD_DRDY)) { /* wait for DRDY to go low */ }
-        return;
+    while(ad->ops->gpio_lev(ad->drdy)) {        // wait for DRDY to go low 
+        if ( ad->ops->st_read() - start > timeout_us )
+            return 1;
     }
-
-    perror("ADS1256_WaitDRDY() Time Out ...\r\n");    
+    return 0;
 }
 
@@ -35,16 +35,21 @@ https://github.com/shujima/HPADDAlibrary
 #include <stdint.h>   // uint8_t, ...
 #include <bcm2835.h>  // BroadCom SPI, I2C, and GPIO interface 
 
-#define NUMCHNL 8         
+#define NUMCHNL 32        /* channels of a test, 8 on each of 4 ADS1256  */
 #define ADMIN   0         /* min value returned by 24 bit A/D        */
 #define ADMAX   0xFFFFFF  /* max value returned by 24 bit A/D        */
 #define ADMID   0x800000  /* mid value returned by 24 bit A/D        */
 #define DA_LO   0x0000    /* min input value accepted by 16 bit D/A  */
 #define DA_HI   0xFFFF    /* max input value accepted by 16 bit D/A  */
 #define DA_00   0x0000    /* D/A output corresponding to zero volts  */
+#define DA_VREF 5.0       /* D/A output voltage at DA_HI             */
 
 #define SPI_DELAY 2       /* delay time for SPI transfers */
 
+#define ADS1256_RESET_US  500000 /* longest wait for DRDY after a reset, us  */
+#define ADS1256_DRDY_US   500000 /* longest wait for DRDY otherwise, us      */
+#define ADS1256_CAL_US   2000000 /* longest wait for a self-calibration, us  */
+
 
 //  GPIO read and write functions 
 #define GPIOwrite(_pin, _value) bcm2835_gpio_write(_pin, _value)
@@ -196,6 +201,53 @@ static const uint8_t s_tabDataRate[ADS1256_CSPEED_MAX] =
 }; 
 */
 
+//#####################################################################
+//
+//  Converters
+//
+//#####################################################################
+
+// the bus, the pins, and the timer of a converter ... the bcm2835 library
+// on the Raspberry Pi, hpadda_bcm2835, or another backend with the same
+// calls, e.g., a simulated converter;  the backend keeps the chip selects
+// on the bus, so a device claims the bus without knowing the others
+  struct HPADDA_OPS {
+         void     (*gpio_fsel)(uint8_t pin, uint8_t mode);
+         void     (*gpio_set_pud)(uint8_t pin, uint8_t pud);
+         void     (*gpio_write)(uint8_t pin, uint8_t on);
+         uint8_t  (*gpio_lev)(uint8_t pin);
+         uint8_t  (*spi_transfer)(uint8_t value);
+         uint64_t (*st_read)(void);
+         void     (*wait_us)(uint64_t us);
+         void     (*spi_attach)(uint8_t cs);  // a chip select on the bus, high
+         void     (*spi_claim)(uint8_t cs);   // the other chip selects high
+      };
+
+// one ADS1256, on its own chip select and DRDY pins, with the host copy of
+// its registers and the calibration of each PGA gain;  every ADS1256_
+// function takes the converter, so several can share the SPI bus
+  struct ADS1256 {
+         const struct HPADDA_OPS *ops;   // the backend
+         uint8_t  cs,                    // SPI chip select pin, low: selected
+                  drdy,                  // DRDY pin, low: data ready
+                  reset;                 // RESET pin, low: reset
+         uint8_t  shadowReg[11],         // registers STATUS to FSC2, as written
+                  shadowSet[11];         // 1: shadowReg is known
+         uint8_t  calReg[8][6],          // OFC0..2 FSC0..2 of each PGA gain
+                  calSet[8];             // 1: calReg is known
+      };
+
+// one DAC8532, on its own chip select of the SPI bus
+  struct DAC8532 {
+         const struct HPADDA_OPS *ops;   // the backend
+         uint8_t  cs;                    // SPI chip select pin, low: selected
+      };
+
+extern const struct HPADDA_OPS hpadda_bcm2835;   // the Raspberry Pi
+extern struct ADS1256 ads1256;                    // the ADS1256 of the board
+extern struct DAC8532 dac8532;                    // the DAC8532 of the board
+
+
 //#####################################################################
 //
 //  Prototype Declaration of Functions 
@@ -207,38 +259,47 @@ static const uint8_t s_tabDataRate[ADS1256_CSPEED_MAX] =
 
 //void  delay_us(uint64_t micros);
 
-void  resetADS1256(void);
+int   resetADS1256(struct ADS1256 *ad);
 int   initHPADDAboard(void);
 void  closeHPADDAboard(void);
+int   ADS1256_Open(struct ADS1256 *ad, const struct HPADDA_OPS *ops, uint8_t cs, uint8_t drdy, uint8_t reset);
 
 
 // Get AD
-int32_t ADS1256_GetADC(int8_t positive_no , int8_t negative_no );
+int32_t ADS1256_GetADC(struct ADS1256 *ad, int8_t positive_no , int8_t negative_no );
 double ADS1256_IntToVolt(int32_t value , double vref);
-void ADS1256_ChannelScan(unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[], int32_t adScan[]);
+int  ADS1256_ChannelScan(struct ADS1256 *ad, unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[], int32_t adScan[], uint64_t tConv[], uint8_t nAvg[]);
+int  ADS1256_WaitDRDYEdge(struct ADS1256 *ad, uint32_t timeout_us, uint64_t *t);
 
 
 // DA
-void DAC8532_Write( int dac_channel , unsigned int val);
+void DAC8532_Open(struct DAC8532 *da, const struct HPADDA_OPS *ops, uint8_t cs);
+void DAC8532_Write(struct DAC8532 *da, int dac_channel , unsigned int val);
 unsigned int DAC8532_VoltToValue( double volt , double volt_ref);
 
 // Print AD
-void ADS1256_PrintAllValue();
-void ADS1256_PrintAllValueDiff();
-void ADS1256_PrintAllReg();
+void ADS1256_PrintAllValue(struct ADS1256 *ad);
+void ADS1256_PrintAllValueDiff(struct ADS1256 *ad);
+void ADS1256_PrintAllReg(struct ADS1256 *ad);
 
 // AD settings
-float ADS1256_SetDigitizationRate( float drate );
+float ADS1256_SetDigitizationRate( struct ADS1256 *ad, float drate );
 
 uint8_t ADS1256_range_code ( float rangeValue );
 float ADS1256_range_value ( uint8_t rangeCode );
-void ADS1256_set_gain ( uint8_t rangeCode );
+void ADS1256_set_gain ( struct ADS1256 *ad, uint8_t rangeCode );
+int  ADS1256_VerifyShadow ( struct ADS1256 *ad );
+
+// AD calibration
+int  ADS1256_SelfCal ( struct ADS1256 *ad, uint8_t rangeCode, uint8_t cal[6] );
+void ADS1256_SetCal ( struct ADS1256 *ad, uint8_t rangeCode, const uint8_t cal[6] );
+void ADS1256_ClearCal ( struct ADS1256 *ad );
 
-uint8_t ADS1256_ReadChipID(void);
-void ADS1256_WriteReg(uint8_t _RegID, uint8_t _RegValue);
-uint8_t ADS1256_ReadReg(uint8_t _RegID);
+uint8_t ADS1256_ReadChipID(struct ADS1256 *ad);
+void ADS1256_WriteReg(struct ADS1256 *ad, uint8_t _RegID, uint8_t _RegValue);
+uint8_t ADS1256_ReadReg(struct ADS1256 *ad, uint8_t _RegID);
 
 // Privates
-void ADS1256_WaitDRDY(void);
+int  ADS1256_WaitDRDY(struct ADS1256 *ad, uint32_t timeout_us);
 
 #endif
@@ -0,0 +1,346 @@
+/*******************************************************************************
+HPADDAsim.c
+simulated ADS1256 converters on a simulated SPI bus ... a backend of
+HPADDAlib, hpadda_sim, for testing the library without the board
+
+Each simulated ADS1256 decodes the bytes of the SPI bus while its chip
+select is low, with the commands and registers of the datasheet: RREG,
+WREG, RDATA, SYNC, WAKEUP, SELFCAL, RESET, SDATAC, and STANDBY.  It
+converts continuously at the rate of its DRATE register from the last
+WAKEUP, reset, or self-calibration, on the input selected by its MUX
+register at that instant, and its DRDY pin goes low when a conversion is
+ready, high when it is read, and high for the last 2 us before the next.
+The data of a conversion is latched by SYNC and by RDATA, so RDATA after
+a SYNC and WAKEUP returns the conversion before the MUX changed, as on the
+chip, datasheet figure 19.  The inputs are set with hpadda_sim_input, and
+the code is that of an ideal converter with the reference SIM_VREF.
+
+Time is simulated: a SPI transfer and a read of a pin take 1 us, and
+wait_us takes its argument, so the polling loops of the library advance
+the clock, and a test runs as fast as the host can.  A transfer made with
+more than one chip select on the bus low is counted as contention.
+*******************************************************************************/
+
+#include <string.h>         // memset
+
+// local libraries .. .
+#include "HPADDAsim.h"                // header for the simulated converters
+
+#define SIM_MAXPIN   64     /* GPIO pins                                    */
+#define SIM_HALTED   UINT64_MAX       /* no conversion, after SYNC         */
+
+enum { SIM_IDLE, SIM_RREG_N, SIM_RREG, SIM_WREG_N, SIM_WREG, SIM_RDATA };
+
+  struct SIM_AD {       // one simulated ADS1256
+         uint8_t  cs, drdy, reset;      // its pins
+         uint8_t  reg[11];              // registers STATUS to FSC2
+         double   ain[8];               // input voltages, volts
+         uint64_t t0;                   // start of the conversions, us
+         uint8_t  convMux, convGain;    // input and gain of the conversions
+         uint64_t nRead;                // conversions read since t0
+         int32_t  out;                  // the output register, 24 bits
+         int      state,                // the command being decoded
+                  reg1, nByte;          // its register and bytes to go
+      };
+
+static struct SIM_AD  sim[SIM_MAXAD];
+static int            nSim = 0;
+static uint64_t       now = 0;                  // the simulated clock, us
+static uint8_t        level[SIM_MAXPIN];        // levels written to the pins
+static uint8_t        busCS[8];                 // chip selects on the bus
+static int            nBusCS = 0;
+static uint32_t       contention = 0;
+
+
+/* SIM_PERIOD - the conversion period of the DRATE register, us
+---------------------------------------------------------------------------*/
+static double sim_period ( uint8_t drate )
+{
+  static const uint8_t code[16] = { 0xF0, 0xE0, 0xD0, 0xC0, 0xB0, 0xA1,
+                                    0x92, 0x82, 0x72, 0x63, 0x53, 0x43,
+                                    0x33, 0x23, 0x13, 0x03 };
+  static const float   sps[16]  = { 30000, 15000, 7500, 3750, 2000, 1000,
+                                    500, 100, 60, 50, 30, 25, 15, 10, 5, 2.5 };
+  int  k;
+
+  for (k = 0; k < 16; k++)  if ( code[k] == drate )  return 1e6 / sps[k];
+  return 1e6 / 30000.0;
+}
+
+
+/* SIM_START - start converting the present input, at time t
+---------------------------------------------------------------------------*/
+static void sim_start ( struct SIM_AD *s, uint64_t t )
+{
+  s->t0 = t;
+  s->convMux  = s->reg[REG_MUX];
+  s->convGain = s->reg[REG_ADCON] & 0x07;
+  s->nRead = 0;
+}
+
+
+/* SIM_POWER_UP - the registers at power up, and conversions from now
+---------------------------------------------------------------------------*/
+static void sim_power_up ( struct SIM_AD *s )
+{
+  static const uint8_t reg0[11] = { 0x30, 0x01, 0x20, 0xF0, 0xE0,
+                                    0x00, 0x00, 0x00, 0x2E, 0x6C, 0x44 };
+
+  memcpy ( s->reg, reg0, sizeof(reg0) );
+  s->reg[REG_OFC0] = s->cs;                    // tells the chips apart
+  s->state = SIM_IDLE;
+  s->out = 0;
+  sim_start ( s, now );
+}
+
+
+/* SIM_DONE - conversions completed since the start, 0 while halted
+---------------------------------------------------------------------------*/
+static uint64_t sim_done ( struct SIM_AD *s )
+{
+  if ( s->t0 == SIM_HALTED || now < s->t0 )  return 0;
+  return (uint64_t)( (now - s->t0) / sim_period ( s->reg[REG_CSPEED] ) );
+}
+
+
+/* SIM_LATCH - the latest conversion to the output register
+---------------------------------------------------------------------------*/
+static void sim_latch ( struct SIM_AD *s )
+{
+  if ( sim_done ( s ) > 0 )
+    s->out = hpadda_sim_code ( s->cs, s->convMux, s->convGain );
+}
+
+
+/* SIM_FIND - the simulated converter on a pin, of its chip select (which
+   = 0), DRDY (1) or RESET (2), NULL for none
+---------------------------------------------------------------------------*/
+static struct SIM_AD *sim_find ( uint8_t pin, int which )
+{
+  int  k;
+
+  for (k = 0; k < nSim; k++)
+    if ( ( which == 0 && sim[k].cs    == pin ) ||
+         ( which == 1 && sim[k].drdy  == pin ) ||
+         ( which == 2 && sim[k].reset == pin ) )  return &sim[k];
+  return NULL;
+}
+
+
+/* SIM_BYTE - one byte of the SPI bus to a selected converter, and the byte
+   it returns
+---------------------------------------------------------------------------*/
+static uint8_t sim_byte ( struct SIM_AD *s, uint8_t in )
+{
+  uint8_t  ret = 0x00;
+
+  switch ( s->state ) {
+    case SIM_RREG_N:
+      s->nByte = in + 1;
+      s->state = SIM_RREG;
+      return ret;
+    case SIM_RREG:
+      ret = ( s->reg1 < 11 ) ? s->reg[s->reg1] : 0x00;
+      if ( s->reg1 == REG_STATUS )               // the DRDY bit
+        ret = ( ret & 0xFE ) | hpadda_sim.gpio_lev ( s->drdy );
+      ++s->reg1;
+      if ( --s->nByte == 0 )  s->state = SIM_IDLE;
+      return ret;
+    case SIM_WREG_N:
+      s->nByte = in + 1;
+      s->state = SIM_WREG;
+      return ret;
+    case SIM_WREG:
+      if ( s->reg1 == REG_STATUS )  s->reg[0] = 0x30 | ( in & 0x0E );
+      else
+      if ( s->reg1 < 11 )           s->reg[s->reg1] = in;
+      ++s->reg1;
+      if ( --s->nByte == 0 )  s->state = SIM_IDLE;
+      return ret;
+    case SIM_RDATA:
+      ret = (uint8_t)( s->out >> ( 8 * ( s->nByte - 1 ) ) );
+      if ( --s->nByte == 0 )  s->state = SIM_IDLE;
+      return ret;
+  }
+
+  if ( ( in & 0xF0 ) == CMD_RREG ) {             // SIM_IDLE, a command
+    s->reg1 = in & 0x0F;
+    s->state = SIM_RREG_N;
+  } else
+  if ( ( in & 0xF0 ) == CMD_WREG ) {
+    s->reg1 = in & 0x0F;
+    s->state = SIM_WREG_N;
+  } else
+  switch ( in ) {
+    case CMD_RDATA:
+      sim_latch ( s );
+      s->nRead = sim_done ( s );
+      s->nByte = 3;
+      s->state = SIM_RDATA;
+      break;
+    case CMD_SYNC:
+    case CMD_STANDBY:
+      sim_latch ( s );
+      s->t0 = SIM_HALTED;
+      break;
+    case CMD_WAKEUP_00:
+    case CMD_WAKEUP_FF:
+      if ( s->t0 == SIM_HALTED )  sim_start ( s, now );
+      break;
+    case CMD_SELFCAL:                            // OFC and FSC of the gain
+      s->reg[REG_OFC0] = s->cs;
+      s->reg[REG_OFC1] = 0x10 + ( s->reg[REG_ADCON] & 0x07 );
+      s->reg[REG_OFC2] = 0x00;
+      s->reg[REG_FSC0] = 0x2E + ( s->reg[REG_ADCON] & 0x07 );
+      s->reg[REG_FSC1] = 0x6C;
+      s->reg[REG_FSC2] = 0x44;
+      sim_start ( s, now + 2 * (uint64_t) sim_period ( s->reg[REG_CSPEED] ) );
+      break;
+    case CMD_RESET:
+      sim_power_up ( s );
+      break;
+  }
+  return ret;
+}
+
+
+/*---------------------------------------------------------------------------
+ the calls of the backend, struct HPADDA_OPS
+---------------------------------------------------------------------------*/
+static void sim_gpio_fsel ( uint8_t pin, uint8_t mode )  { }
+
+static void sim_gpio_set_pud ( uint8_t pin, uint8_t pud )  { }
+
+static void sim_gpio_write ( uint8_t pin, uint8_t on )
+{
+  struct SIM_AD *s;
+
+  if ( pin >= SIM_MAXPIN )  return;
+  if ( (s = sim_find ( pin, 0 )) && on )  s->state = SIM_IDLE; // CS high
+  if ( (s = sim_find ( pin, 2 )) && on && !level[pin] )  sim_power_up ( s );
+  level[pin] = on ? HIGH : LOW;
+}
+
+static uint8_t sim_gpio_lev ( uint8_t pin )
+{
+  struct SIM_AD *s = sim_find ( pin, 1 );
+  uint64_t       n;
+  double         T;
+
+  ++now;                                         // a read takes 1 us
+  if ( !s )  return ( pin < SIM_MAXPIN ) ? level[pin] : LOW;
+
+  n = sim_done ( s );                            // DRDY
+  if ( n == 0 || s->nRead >= n )  return HIGH;   // none, or read already
+  T = sim_period ( s->reg[REG_CSPEED] );
+  if ( now + 2 >= s->t0 + (uint64_t)( (n+1) * T ) )  return HIGH;
+  return LOW;
+}
+
+static uint8_t sim_spi_transfer ( uint8_t value )
+{
+  struct SIM_AD *sel = NULL;
+  uint8_t        ret = 0x00;
+  int            k, nLow = 0;
+
+  ++now;                                         // a transfer takes 1 us
+  for (k = 0; k < nBusCS; k++)  if ( level[busCS[k]] == LOW )  ++nLow;
+  if ( nLow > 1 )  ++contention;
+
+  for (k = 0; k < nSim; k++)
+    if ( level[sim[k].cs] == LOW ) {
+      ret = sim_byte ( &sim[k], value );
+      sel = &sim[k];
+    }
+  return sel ? ret : 0xFF;
+}
+
+static uint64_t sim_st_read ( void )  { return now; }
+
+static void sim_wait_us ( uint64_t us )  { now += us; }
+
+static void sim_spi_attach ( uint8_t cs )
+{
+  int  k;
+
+  sim_gpio_write ( cs, HIGH );
+  for (k = 0; k < nBusCS; k++)  if ( busCS[k] == cs )  return;
+  if ( nBusCS < (int) sizeof(busCS) )  busCS[nBusCS++] = cs;
+}
+
+static void sim_spi_claim ( uint8_t cs )
+{
+  int  k;
+
+  for (k = 0; k < nBusCS; k++)
+    if ( busCS[k] != cs )  sim_gpio_write ( busCS[k], HIGH );
+}
+
+const struct HPADDA_OPS hpadda_sim = {
+  sim_gpio_fsel,
+  sim_gpio_set_pud,
+  sim_gpio_write,
+  sim_gpio_lev,
+  sim_spi_transfer,
+  sim_st_read,
+  sim_wait_us,
+  sim_spi_attach,
+  sim_spi_claim
+};
+
+
+/* HPADDA_SIM_ADD - add a simulated ADS1256, at its power-up state
+   returns 0: successful  1: too many                                19oct26
+---------------------------------------------------------------------------*/
+int hpadda_sim_add ( uint8_t cs, uint8_t drdy, uint8_t reset )
+{
+  struct SIM_AD *s;
+
+  if ( nSim >= SIM_MAXAD || cs >= SIM_MAXPIN || drdy >= SIM_MAXPIN ||
+       reset >= SIM_MAXPIN )  return 1;
+  s = &sim[nSim++];
+  memset ( s, 0, sizeof(*s) );
+  s->cs = cs;  s->drdy = drdy;  s->reset = reset;
+  level[cs] = level[reset] = HIGH;
+  sim_power_up ( s );
+  return 0;
+}
+
+
+/* HPADDA_SIM_INPUT - the voltage at an input of a simulated ADS1256
+---------------------------------------------------------------------------*/
+void hpadda_sim_input ( uint8_t cs, int ain, double volts )
+{
+  struct SIM_AD *s = sim_find ( cs, 0 );
+
+  if ( s && ain >= 0 && ain < 8 )  s->ain[ain] = volts;
+}
+
+
+/* HPADDA_SIM_CODE - the code of an ideal ADS1256 for a MUX and PGA gain,
+   the positive input less the negative, AINCOM at zero volts, clipped to
+   the 24 bit range, sign extended
+---------------------------------------------------------------------------*/
+int32_t hpadda_sim_code ( uint8_t cs, uint8_t mux, uint8_t gain )
+{
+  struct SIM_AD *s = sim_find ( cs, 0 );
+  double  vp, vn, x;
+  int     p = mux >> 4,  n = mux & 0x0F;
+
+  if ( !s )  return 0;
+  vp = ( p < 8 ) ? s->ain[p] : 0.0;
+  vn = ( n < 8 ) ? s->ain[n] : 0.0;
+  x = ( vp - vn ) * (double)( 1 << ( gain & 0x07 ) ) / ( 2.0 * SIM_VREF )
+      * (double) 0x7FFFFF;
+  if ( x >  (double) 0x7FFFFF )  x = (double) 0x7FFFFF;
+  if ( x < -(double) 0x800000 )  x = -(double) 0x800000;
+  return (int32_t)( x < 0 ? x - 0.5 : x + 0.5 );
+}
+
+
+/* HPADDA_SIM_CONTENTION - transfers made with more than one chip select low
+---------------------------------------------------------------------------*/
+uint32_t hpadda_sim_contention ( void )
+{
+  return contention;
+}
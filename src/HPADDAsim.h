@@ -0,0 +1,47 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPADDAsim.h
+ *
+ *    Description:  header file for HPADDAsim.c
+ *                  simulated ADS1256 converters on a simulated SPI bus,
+ *                  a backend of HPADDAlib without the board
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPADDASIM_H_
+#define _HPADDASIM_H_
+
+#include <stdint.h>         // uint8_t, uint32_t
+#include "HPADDAlib.h"      // struct HPADDA_OPS
+
+#define SIM_MAXAD      4     /* simulated ADS1256, at most                 */
+#define SIM_VREF     2.5     /* reference voltage, volts                   */
+
+extern const struct HPADDA_OPS hpadda_sim;   // the simulated bus and timer
+
+/* add a simulated ADS1256 on chip select cs, with its DRDY and RESET pins,
+   at its power-up state;  returns 0: successful  1: too many */
+int  hpadda_sim_add ( uint8_t cs,
+                      uint8_t drdy,
+                      uint8_t reset );
+
+/* set the voltage at input ain (0 to 7) of the ADS1256 on chip select cs,
+   with respect to AINCOM */
+void hpadda_sim_input ( uint8_t cs,
+                        int ain,
+                        double volts );
+
+/* the A/D code of the simulated ADS1256 on chip select cs, 24 bits, sign
+   extended, for a MUX and PGA gain code */
+int32_t hpadda_sim_code ( uint8_t cs,
+                          uint8_t mux,
+                          uint8_t gain );
+
+/* SPI transfers made with more than one chip select on the bus low */
+uint32_t hpadda_sim_contention ( void );
+
+#endif // _HPADDASIM_H_
@@ -0,0 +1,168 @@
+/*******************************************************************************
+HPADDAsim_test.c - HPADDAlib on two simulated ADS1256 sharing the SPI bus
+
+Opens two ADS1256 of HPADDAsim.c, with a DAC8532 chip select on the same
+bus, through the simulated backend hpadda_sim, and checks the bring-up,
+the data rate, the register shadow, the multi-channel scan with averaged
+channels and PGA gains, the self-calibration and its restore in the scan,
+the DRDY edges, and that no two chip selects were ever low together.
+Needs neither the board nor root.
+
+to compile:   make simtest
+
+to run:       ./HPADDAsim_test
+              exits with 0 if every check passes, 1 otherwise
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // exit
+
+// local libraries .. .
+#include "HPADDAlib.h"                // High-Performance AD/DA library
+#include "HPADDAsim.h"                // simulated ADS1256 converters
+
+#define CS_A    22          /* chip select, DRDY and RESET, ADS1256 A       */
+#define DRDY_A  17
+#define RST_A   18
+#define CS_B     5          /* ... and ADS1256 B                            */
+#define DRDY_B   6
+#define RST_B   13
+#define CS_DA   23          /* the DAC8532, on the same bus                 */
+
+static int       failed = 0;
+static unsigned  nTransfer = 0;       // SPI transfers of the counted backend
+static struct HPADDA_OPS counted;     // hpadda_sim, counting the transfers
+
+
+/* CHECK - report one check
+---------------------------------------------------------------------------*/
+static void check ( int ok, const char *what )
+{
+  fprintf(stderr," %-60s %s\n", what, ok ? "ok" : "FAILED" );
+  if ( !ok )  ++failed;
+}
+
+
+/* COUNTED_TRANSFER - a transfer of hpadda_sim, counted
+---------------------------------------------------------------------------*/
+static uint8_t counted_transfer ( uint8_t value )
+{
+  ++nTransfer;
+  return hpadda_sim.spi_transfer ( value );
+}
+
+
+/* SCAN_CHECK - scan n channels of a converter and compare with the codes
+   of the simulated inputs;  returns 1: every channel as expected
+---------------------------------------------------------------------------*/
+static int scan_check ( struct ADS1256 *ad, unsigned n, uint8_t mux[],
+                        uint8_t range[], uint8_t avg[] )
+{
+  int32_t   adScan[NUMCHNL];
+  uint64_t  tConv[NUMCHNL];
+  unsigned  k;
+  int       ok = 1;
+
+  if ( ADS1256_ChannelScan ( ad, n, mux, range, adScan, tConv, avg ) )
+    return 0;
+  for (k = 0; k < n; k++) {
+    if ( adScan[k] != 2 * hpadda_sim_code ( ad->cs, mux[k], range[k] ) ) {
+      fprintf(stderr,"   cs %u channel %u: %d, %d expected\n", ad->cs, k,
+                      adScan[k], 2 * hpadda_sim_code ( ad->cs, mux[k], range[k] ) );
+      ok = 0;
+    }
+    if ( k > 0 && tConv[k] <= tConv[k-1] )  ok = 0;
+  }
+  return ok;
+}
+
+
+/* MAIN - the checks
+---------------------------------------------------------------------------*/
+int main ( int argc, char *argv[] )
+{
+  struct ADS1256  adA, adB;
+  struct DAC8532  da;
+  uint8_t   muxA[4]   = { 0x01, 0x23, 0x48, 0x58 },   // AIN0-AIN1, ... AIN5
+            rangeA[4] = { UP_5_00V, UP_5_00V, UP_1_25V, UP_2_50V },
+            avgA[4]   = { 1, 4, 1, 2 },
+            muxB[3]   = { 0x08, 0x18, 0x76 },
+            rangeB[3] = { UP_2_50V, UP_0_625V, UP_5_00V },
+            cal[6],  calAgain[6];
+  uint64_t  t1, t2;
+  float     drate;
+  int       k, ok;
+
+  hpadda_sim_add ( CS_A, DRDY_A, RST_A );
+  hpadda_sim_add ( CS_B, DRDY_B, RST_B );
+  DAC8532_Open ( &da, &hpadda_sim, CS_DA );
+  for (k = 0; k < 8; k++) {
+    hpadda_sim_input ( CS_A, k, 0.55 * k - 1.1 );
+    hpadda_sim_input ( CS_B, k, 0.07 * k + 0.2 );
+  }
+
+  check ( ADS1256_Open ( &adA, &hpadda_sim, CS_A, DRDY_A, RST_A ) == 0,
+          "ADS1256 A open, chip ID, registers" );
+  check ( ADS1256_Open ( &adB, &hpadda_sim, CS_B, DRDY_B, RST_B ) == 0,
+          "ADS1256 B open, chip ID, registers" );
+  check ( ADS1256_ReadReg ( &adA, REG_OFC0 ) == CS_A &&
+          ADS1256_ReadReg ( &adB, REG_OFC0 ) == CS_B,
+          "each converter answers on its own chip select" );
+
+  drate = ADS1256_SetDigitizationRate ( &adA, 7500.0 );
+  (void) ADS1256_SetDigitizationRate ( &adB, 7500.0 );
+  check ( drate == 7500.0 && ADS1256_ReadReg ( &adA, REG_CSPEED ) == 0xD0,
+          "data rate 7500 conversions per second" );
+
+  counted = hpadda_sim;
+  counted.spi_transfer = counted_transfer;
+  adA.ops = &counted;
+  ADS1256_WriteReg ( &adA, REG_CSPEED, 0xD0 );
+  check ( nTransfer == 0, "a register already in the chip is not written" );
+  ADS1256_set_gain ( &adA, UP_2_50V );
+  check ( nTransfer > 0 && ADS1256_VerifyShadow ( &adA ) == 0 &&
+          ADS1256_VerifyShadow ( &adB ) == 0,
+          "the register shadow matches the chips" );
+  adA.ops = &hpadda_sim;
+
+  check ( scan_check ( &adA, 4, muxA, rangeA, avgA ),
+          "scan of A, four channels, three gains, averaged channels" );
+  check ( scan_check ( &adB, 3, muxB, rangeB, NULL ),
+          "scan of B, three channels, three gains" );
+  check ( scan_check ( &adA, 4, muxA, rangeA, avgA ) &&
+          scan_check ( &adB, 3, muxB, rangeB, NULL ),
+          "scans of A and B, one after the other" );
+
+  DAC8532_Write ( &da, 0, 0x8000 );
+  ok = scan_check ( &adA, 4, muxA, rangeA, avgA );
+  DAC8532_Write ( &da, 1, 0x4000 );
+  check ( ok && scan_check ( &adB, 3, muxB, rangeB, NULL ),
+          "D/A writes between the scans, on the same bus" );
+
+  (void) ADS1256_SetDigitizationRate ( &adA, 30000.0 );
+  check ( scan_check ( &adA, 4, muxA, rangeA, avgA ),
+          "averaged channels at 30000 conversions per second" );
+  (void) ADS1256_SetDigitizationRate ( &adA, 7500.0 );
+
+  check ( ADS1256_SelfCal ( &adA, UP_1_25V, cal ) == 0 && cal[0] == CS_A &&
+          cal[1] == 0x10 + UP_1_25V && adA.calSet[UP_1_25V],
+          "self-calibration of A at 1.25 V" );
+  for (k = 0; k < 6; k++)  calAgain[k] = cal[k];
+  calAgain[1] = 0x10 + UP_5_00V;
+  ADS1256_SetCal ( &adA, UP_5_00V, calAgain );
+  check ( scan_check ( &adA, 4, muxA, rangeA, avgA ) &&
+          ADS1256_VerifyShadow ( &adA ) == 0 &&
+          ADS1256_ReadReg ( &adA, REG_OFC1 ) == 0x10 + UP_1_25V,
+          "the scan restores the calibration of each gain" );
+
+  check ( ADS1256_WaitDRDYEdge ( &adB, ADS1256_DRDY_US, &t1 ) == 0 &&
+          ADS1256_WaitDRDYEdge ( &adB, ADS1256_DRDY_US, &t2 ) == 0 &&
+          t2 - t1 >= 1e6/7500.0 - 2 && t2 - t1 <= 1e6/7500.0 + 2,
+          "DRDY edges one conversion period apart" );
+
+  check ( hpadda_sim_contention() == 0,
+          "never two chip selects low on the bus" );
+
+  fprintf(stderr," %d checks failed\n", failed );
+  exit ( failed ? 1 : 0 );
+}
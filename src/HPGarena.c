@@ -0,0 +1,131 @@
+/*******************************************************************************
+HPGarena.c
+the buffers of a test in one locked, pre-faulted region of memory ... the
+samples, the D/A waveforms, the rate groups, and the aligned channels
+
+Buffers from malloc are mapped by the kernel only when each page is first
+written, so the first scans to reach a page wait for a page fault, and a
+page may be swapped out during a long test.  arena_open() maps one region,
+large enough for every buffer of the test, locks it in RAM with mlock, and
+writes one byte of each page, before the test; arena_alloc() then gives out
+its buffers in order, aligned to a cache line, with no system call, and the
+region is unmapped at once at the end of the test.  The memory of a new
+anonymous mapping is zero, so the buffers need not be cleared.
+
+With huge pages the region is mapped on ARENA_HUGE pages (MAP_HUGETLB), if
+the system has huge pages reserved (/proc/sys/vm/nr_hugepages), for fewer
+TLB misses while the scans are written; otherwise on normal pages, advised
+as transparent huge pages.  A region that cannot be locked (the memory
+lock limit, when not run as root) is used unlocked, with a warning.
+arena_faults() returns the page faults of the process, from getrusage, to
+show that the scans of a test caused none.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // strerror
+#include <errno.h>          // errno
+#include <unistd.h>         // sysconf
+#include <sys/mman.h>       // mmap, mlock
+#include <sys/resource.h>   // getrusage
+
+// local libraries .. .
+#include "HPGarena.h"                 // header for the arena
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* ARENA_OPEN - map, lock, and pre-fault a region of at least bytes
+   returns 0: successful  1: abnormal                                19oct26
+---------------------------------------------------------------------------*/
+int arena_open ( struct ARENA *a, size_t bytes, int huge )
+{
+  long    page = sysconf ( _SC_PAGESIZE );
+  size_t  b;
+  void   *p = MAP_FAILED;
+
+  memset ( a, 0, sizeof(*a) );
+  if ( page <= 0 )  page = 4096;
+  if ( bytes == 0 )  bytes = 1;
+
+#ifdef MAP_HUGETLB
+  if ( huge ) {                             // reserved huge pages
+    a->size = ( bytes + ARENA_HUGE-1 ) & ~(size_t)(ARENA_HUGE-1);
+    p = mmap ( NULL, a->size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0 );
+    a->huge = ( p != MAP_FAILED );
+    if ( !a->huge ) {
+      color(1); color(33);
+      fprintf(stderr," arena: no huge pages reserved, normal pages used\n");
+    }
+  }
+#endif
+  if ( p == MAP_FAILED ) {                  // normal pages
+    a->size = ( bytes + page-1 ) & ~(size_t)(page-1);
+    p = mmap ( NULL, a->size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0 );
+  }
+  if ( p == MAP_FAILED ) {
+    errorMsg ( "  arena_open: cannot map the buffers of the test" );
+    fprintf(stderr,"  %.1f MB  %s\n", bytes / 1.0e6, strerror ( errno ) );
+    a->size = 0;
+    return 1;
+  }
+  a->base = (uint8_t *) p;
+#ifdef MADV_HUGEPAGE
+  if ( huge && !a->huge )  (void) madvise ( p, a->size, MADV_HUGEPAGE );
+#endif
+
+  if ( mlock ( a->base, a->size ) == 0 )
+    a->locked = 1;
+  else {
+    color(1); color(33);
+    fprintf(stderr," arena: the buffers cannot be locked in RAM, %s\n",
+                    strerror ( errno ) );
+  }
+  for (b=0; b < a->size; b += page)  a->base[b] = 0;   // pre-fault
+
+  color(1); color(33);
+  fprintf(stderr," arena: %.1f MB%s%s, pre-faulted\n", a->size / 1.0e6,
+                  a->huge ? " on huge pages" : "", a->locked ? ", locked" : "" );
+  return 0;
+}
+
+
+/* ARENA_ALLOC - the next n bytes of the region, aligned and zero, or NULL
+   if the region is full                                              19oct26
+---------------------------------------------------------------------------*/
+void *arena_alloc ( struct ARENA *a, size_t n )
+{
+  void  *p;
+
+  if ( a->base == NULL || ARENA_ROUND(n) > a->size - a->used )  return NULL;
+  p = a->base + a->used;
+  a->used += ARENA_ROUND(n);
+  return p;
+}
+
+
+/* ARENA_CLOSE - unlock and unmap the region                         19oct26
+---------------------------------------------------------------------------*/
+void arena_close ( struct ARENA *a )
+{
+  if ( a->base ) {
+    if ( a->locked )  (void) munlock ( a->base, a->size );
+    (void) munmap ( a->base, a->size );
+  }
+  memset ( a, 0, sizeof(*a) );
+}
+
+
+/* ARENA_FAULTS - the minor and major page faults of the process so far
+---------------------------------------------------------------------------*/
+void arena_faults ( long *minor, long *major )
+{
+  struct rusage  ru;
+
+  if ( getrusage ( RUSAGE_SELF, &ru ) ) {
+    *minor = *major = 0;
+    return;
+  }
+  *minor = ru.ru_minflt;
+  *major = ru.ru_majflt;
+}
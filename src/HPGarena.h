@@ -0,0 +1,52 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGarena.h
+ *
+ *    Description:  header file for HPGarena.c
+ *                  one locked, pre-faulted region of memory for the
+ *                  buffers of a test, reserved before the test
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGARENA_H_
+#define _HPGARENA_H_
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint8_t
+
+#define ARENA_ALIGN       64  /* alignment of each buffer, a cache line      */
+#define ARENA_HUGE  0x200000  /* bytes of a huge page                        */
+
+/* the bytes of an arena buffer of n bytes, with its alignment */
+#define ARENA_ROUND(n)  ( ( (size_t)(n) + ARENA_ALIGN-1 ) & ~(size_t)(ARENA_ALIGN-1) )
+
+  struct ARENA {        // the buffers of a test
+         uint8_t  *base;           // the region, NULL if not open
+         size_t    size;           // bytes in the region
+         size_t    used;           // bytes given out
+         int       huge;           // 1: on huge pages
+         int       locked;         // 1: locked in RAM
+      };
+
+/* map, lock and pre-fault a region of at least bytes, on huge pages if
+   huge and if the system has them;  returns 0: successful  1: abnormal */
+int   arena_open ( struct ARENA *a,
+                   size_t bytes,
+                   int huge );
+
+/* the next n bytes of the region, aligned and zero, or NULL if it is full */
+void *arena_alloc ( struct ARENA *a,
+                    size_t n );
+
+/* unlock and unmap the region, and every buffer in it */
+void  arena_close ( struct ARENA *a );
+
+/* the minor and major page faults of the process so far, getrusage */
+void  arena_faults ( long *minor,
+                     long *major );
+
+#endif // _HPGARENA_H_
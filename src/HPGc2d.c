@@ -0,0 +1,310 @@
+/*******************************************************************************
+HPGc2d.c
+convert Continuous time dynamics to Discrete time dynamics
+
+  continuous time:   dx/dt = A x(t) + B u(t)  ,   y(t) = C x(t) + D u(t)
+  discrete time:     x(k+1) = Ad x(k) + Bd u(k) ,  y(k) = Cd x(k) + Dd u(k)
+
+The n states, m inputs, and p outputs are stored together, row-major, in
+one (n+p) by (n+m) matrix  S = [ A B ; C D ] .
+
+The matrix exponential uses a (6,6) Pade approximation with scaling and
+squaring.  Discretization is done once, before the test, and the result is
+saved under C2D_CACHE_DIR with a name made from a hash of the continuous
+time system, the sample period, and the method, so that later runs of the
+same system at the same scan rate read the result instead.  The cache is
+read and written through HPGcache.c, which trusts only files owned by root
+in a directory only root may write.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <strings.h>        // strcasecmp
+#include <stdint.h>         // uint64_t
+#include <math.h>           // standard mathematics library
+
+// local libraries .. .
+#include "HPGc2d.h"                   // header for c2d
+#include "HPGcache.h"                 // cache_open, cache_create
+#include "../../HPGnumlib/NRutil.h"   // memory allocation routines
+
+#define C2D_MAGIC  "HPGc2d1"          /* cache file format identifier */
+
+
+/* C2D_SOLVE - solve  M X = R  for X, M is n by n, R and X are n by c,
+   by Gaussian elimination with partial pivoting.  M and R are destroyed,
+   and X is returned in R.   returns 0: successful  1: singular      19oct26
+---------------------------------------------------------------------------*/
+int c2d_solve ( double *M, double *R, int n, int c )
+{
+  double  piv, f, t;
+  int     i, j, k, p;
+
+  for (k=0; k<n; k++) {
+    p = k;                                      // partial pivoting
+    for (i=k+1; i<n; i++)  if ( fabs(M[i*n+k]) > fabs(M[p*n+k]) )  p = i;
+    if ( M[p*n+k] == 0.0 )  return 1;
+    if ( p != k ) {
+      for (j=0; j<n; j++) { t = M[k*n+j]; M[k*n+j] = M[p*n+j]; M[p*n+j] = t; }
+      for (j=0; j<c; j++) { t = R[k*c+j]; R[k*c+j] = R[p*c+j]; R[p*c+j] = t; }
+    }
+    piv = M[k*n+k];
+    for (i=k+1; i<n; i++) {                     // forward elimination
+      f = M[i*n+k] / piv;
+      if ( f == 0.0 )  continue;
+      for (j=k; j<n; j++)  M[i*n+j] -= f * M[k*n+j];
+      for (j=0; j<c; j++)  R[i*c+j] -= f * R[k*c+j];
+    }
+  }
+  for (k=n-1; k>=0; k--)                        // back substitution
+    for (j=0; j<c; j++) {
+      t = R[k*c+j];
+      for (i=k+1; i<n; i++)  t -= M[k*n+i] * R[i*c+j];
+      R[k*c+j] = t / M[k*n+k];
+    }
+
+  return 0;
+}
+
+
+/* MAT_MUL - P = X Y,  all n by n
+---------------------------------------------------------------------------*/
+static void mat_mul ( const double *X, const double *Y, double *P, int n )
+{
+  double  s;
+  int     i, j, k;
+
+  for (i=0; i<n; i++)
+    for (j=0; j<n; j++) {
+      s = 0.0;
+      for (k=0; k<n; k++)  s += X[i*n+k] * Y[k*n+j];
+      P[i*n+j] = s;
+    }
+}
+
+
+/* C2D_EXPM - matrix exponential E = expm(M), M is n by n, by a (6,6) Pade
+   approximation with scaling and squaring,  Golub and Van Loan, Alg. 11.3.1
+                                                                     19oct26
+---------------------------------------------------------------------------*/
+void c2d_expm ( const double *M, double *E, int n )
+{
+  const int  q = 6;                             // Pade approximation order
+  double    *X, *N, *D, *P, norm = 0.0, rs, c = 1.0, scale;
+  int        i, j, k, s = 0;
+
+  X = dvector ( 0, 4*n*n-1 );
+  N = X + n*n;
+  D = N + n*n;
+  P = D + n*n;
+
+  for (i=0; i<n; i++) {                         // infinity norm of M
+    rs = 0.0;
+    for (j=0; j<n; j++)  rs += fabs(M[i*n+j]);
+    if ( rs > norm )  norm = rs;
+  }
+  if ( norm > 0.5 )  s = (int) ceil ( log2 ( norm / 0.5 ) );
+  scale = ldexp ( 1.0, -s );
+
+  for (i=0; i<n*n; i++) { E[i] = M[i]*scale;  X[i] = E[i];  N[i] = D[i] = 0.0; }
+  for (i=0; i<n; i++)    N[i*n+i] = D[i*n+i] = 1.0;
+
+  for (k=1; k<=q; k++) {                        // N = sum c_k X^k
+    c = c * (q-k+1) / (k*(2*q-k+1));            // D = sum (-1)^k c_k X^k
+    if ( k > 1 ) {
+      mat_mul ( E, X, P, n );                   // X = (M/2^s)^k
+      for (i=0; i<n*n; i++)  X[i] = P[i];
+    }
+    for (i=0; i<n*n; i++) {
+      N[i] += c * X[i];
+      D[i] += ( k%2 ? -c : c ) * X[i];
+    }
+  }
+
+  (void) c2d_solve ( D, N, n, n );              // E = D^-1 N
+  for (i=0; i<n*n; i++)  E[i] = N[i];
+
+  for ( ; s > 0; s-- ) {                        // E = E^(2^s)
+    mat_mul ( E, E, P, n );
+    for (i=0; i<n*n; i++)  E[i] = P[i];
+  }
+
+  free_dvector ( X, 0, 4*n*n-1 );
+}
+
+
+/* C2D - convert S = [ A B ; C D ] from continuous time to discrete time
+   with sample period T, in place                                    19oct26
+   C2D_ZOH:     [ Ad Bd ; 0 I ] = expm ( [ A B ; 0 0 ] T )
+   C2D_FOH:     [ Ad G1 G2 ; 0 I I ; 0 0 I ] = expm ( [ A B 0 ; 0 0 I/T ; 0 0 0 ] T )
+                Bd = G1 + (Ad - I) G2 ,  Dd = D + C G2
+   C2D_TUSTIN:  Q = (I - A T/2)^-1 ,  Ad = Q (I + A T/2) ,  Bd = Q B T ,
+                Cd = C Q ,  Dd = D + C Q B T/2
+   returns 0: successful  1: abnormal
+---------------------------------------------------------------------------*/
+int c2d ( double *S, int n, int m, int p, double T, int method )
+{
+  const int  s = n+m,  q = n + 2*m;             // S has s columns
+  double    *M, *E, *R, *W, t;
+  int        i, j, k, ok = 0;
+
+  if ( n < 1 || m < 0 || p < 0 || T <= 0.0 )  return 1;
+
+  M = dvector ( 0, 2*q*q + n*s + p*s - 1 );
+  E = M + q*q;
+  R = E + q*q;                                  // n by (n+m)
+  W = R + n*s;                                  // p by (n+m)
+
+  switch ( method ) {
+
+    case C2D_ZOH:
+      for (i=0; i<s*s; i++)  M[i] = 0.0;
+      for (i=0; i<n; i++)
+        for (j=0; j<s; j++)  M[i*s+j] = S[i*s+j] * T;
+      c2d_expm ( M, E, s );
+      for (i=0; i<n; i++)
+        for (j=0; j<s; j++)  S[i*s+j] = E[i*s+j];
+      break;
+
+    case C2D_FOH:
+      for (i=0; i<q*q; i++)  M[i] = 0.0;
+      for (i=0; i<n; i++)
+        for (j=0; j<s; j++)  M[i*q+j] = S[i*s+j] * T;
+      for (i=0; i<m; i++)    M[(n+i)*q + n+m+i] = 1.0;
+      c2d_expm ( M, E, q );
+      for (i=0; i<n; i++)                       // Bd = G1 + (Ad - I) G2
+        for (j=0; j<m; j++) {
+          t = E[i*q+n+j] - E[i*q+n+m+j];
+          for (k=0; k<n; k++)  t += E[i*q+k] * E[k*q+n+m+j];
+          R[i*s+n+j] = t;
+        }
+      for (i=0; i<p; i++)                       // Dd = D + C G2
+        for (j=0; j<m; j++) {
+          t = S[(n+i)*s+n+j];
+          for (k=0; k<n; k++)  t += S[(n+i)*s+k] * E[k*q+n+m+j];
+          S[(n+i)*s+n+j] = t;
+        }
+      for (i=0; i<n; i++) {
+        for (j=0; j<n; j++)  S[i*s+j]   = E[i*q+j];
+        for (j=0; j<m; j++)  S[i*s+n+j] = R[i*s+n+j];
+      }
+      break;
+
+    case C2D_TUSTIN:
+      for (i=0; i<n; i++) {                     // M = I - A T/2
+        for (j=0; j<n; j++)  M[i*n+j] = -0.5*T*S[i*s+j];
+        M[i*n+i] += 1.0;
+      }
+      for (i=0; i<n; i++) {                     // R = [ I + A T/2 , B T ]
+        for (j=0; j<n; j++)  R[i*s+j] = 0.5*T*S[i*s+j];
+        R[i*s+i] += 1.0;
+        for (j=0; j<m; j++)  R[i*s+n+j] = T*S[i*s+n+j];
+      }
+      for (i=0; i<n*n; i++)  E[i] = M[i];
+      if ( c2d_solve ( M, R, n, s ) ) { ok = 1; break; }  // R = [ Ad , Q B T ]
+
+      // Cd = C Q  solves  Cd (I - A T/2) = C ,  i.e.  (I - A T/2)' Cd' = C'
+      for (i=0; i<n; i++)
+        for (j=0; j<n; j++)  M[i*n+j] = E[j*n+i];
+      for (i=0; i<n; i++)
+        for (j=0; j<p; j++)  W[i*p+j] = S[(n+j)*s+i];
+      if ( c2d_solve ( M, W, n, p ) ) { ok = 1; break; }  // W = Cd'
+
+      for (i=0; i<p; i++)                       // Dd = D + Cd B T/2
+        for (j=0; j<m; j++) {
+          t = 0.0;
+          for (k=0; k<n; k++)  t += W[k*p+i] * S[k*s+n+j];
+          S[(n+i)*s+n+j] += 0.5*T*t;
+        }
+      for (i=0; i<p; i++)
+        for (j=0; j<n; j++)  S[(n+i)*s+j] = W[j*p+i];
+      for (i=0; i<n; i++)
+        for (j=0; j<s; j++)  S[i*s+j] = R[i*s+j];
+      break;
+
+    default:
+      ok = 1;
+  }
+
+  free_dvector ( M, 0, 2*q*q + n*s + p*s - 1 );
+  return ok;
+}
+
+
+/* HASH - 64 bit FNV-1a hash of a block of bytes
+---------------------------------------------------------------------------*/
+static uint64_t hash ( uint64_t h, const void *data, size_t len )
+{
+  const unsigned char *b = (const unsigned char *) data;
+
+  while ( len-- ) { h ^= *b++;  h *= 0x100000001b3ULL; }
+  return h;
+}
+
+
+/* C2D_CACHED - c2d(), reading the result from the cache when the same
+   system has been converted with the same T and method before       19oct26
+   returns 0: successful  1: abnormal
+---------------------------------------------------------------------------*/
+int c2d_cached ( double *S, int n, int m, int p, double T, int method )
+{
+  FILE     *fp;
+  char      filename[512], tmp[544], magic[8];
+  int       dims[4] = { n, m, p, method },  cdims[4],  size = (n+p)*(n+m);
+  double    cT;
+  uint64_t  key = 0xcbf29ce484222325ULL,  ckey;
+
+  key = hash ( key, dims, sizeof(dims) );
+  key = hash ( key, &T, sizeof(T) );
+  key = hash ( key, S, size*sizeof(double) );
+
+  snprintf ( filename, sizeof(filename), "%s/c2d-%016llx.dat",
+             C2D_CACHE_DIR, (unsigned long long) key );
+
+  fprintf(stderr," c2d %s at T = %.6f s", method == C2D_ZOH ? "ZOH" :
+                  method == C2D_FOH ? "FOH" : "Tustin", T ); fflush(stderr);
+
+  if ( (fp = cache_open ( filename )) != NULL ) {       // look in the cache
+    if ( fread ( magic, 1, 8, fp ) == 8 && strncmp ( magic, C2D_MAGIC, 8 ) == 0 &&
+         fread ( &ckey, sizeof(ckey), 1, fp ) == 1 && ckey == key &&
+         fread ( cdims, sizeof(cdims), 1, fp ) == 1 &&
+         memcmp ( cdims, dims, sizeof(dims) ) == 0 &&
+         fread ( &cT, sizeof(cT), 1, fp ) == 1 && cT == T &&
+         fread ( S, sizeof(double), size, fp ) == size ) {
+      fclose(fp);
+      fprintf(stderr," . . . . . . . . . . . . . . . . . .  cached \n");
+      return 0;
+    }
+    fclose(fp);
+  }
+
+  if ( c2d ( S, n, m, p, T, method ) ) {
+    fprintf(stderr," . . . . . . . . . . . . . . . . . .  failed \n");
+    return 1;
+  }
+  fprintf(stderr," . . . . . . . . . . . . . . . . . .  success \n");
+
+  if ( (fp = cache_create ( filename, tmp, sizeof(tmp) )) != NULL ) { // save
+    memset ( magic, 0, 8 );
+    strncpy ( magic, C2D_MAGIC, 8 );
+    fwrite ( magic, 1, 8, fp );
+    fwrite ( &key, sizeof(key), 1, fp );
+    fwrite ( dims, sizeof(dims), 1, fp );
+    fwrite ( &T, sizeof(T), 1, fp );
+    fwrite ( S, sizeof(double), size, fp );
+    (void) cache_commit ( fp, tmp, filename );
+  }
+
+  return 0;
+}
+
+
+/* C2D_METHOD - the discretization method from its name, 0 if none   19oct26
+---------------------------------------------------------------------------*/
+int c2d_method ( char *name )
+{
+  if ( strcasecmp ( name, "zoh" )    == 0 )  return C2D_ZOH;
+  if ( strcasecmp ( name, "foh" )    == 0 )  return C2D_FOH;
+  if ( strcasecmp ( name, "tustin" ) == 0 )  return C2D_TUSTIN;
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGc2d.h
+ *
+ *    Description:  header file for HPGc2d.c
+ *                  continuous time to discrete time conversion
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGC2D_H_
+#define _HPGC2D_H_
+
+#include "HPGcache.h"       // CACHE_DIR
+
+#define C2D_ZOH      1   /* zero order hold                              */
+#define C2D_FOH      2   /* first order (triangle) hold                  */
+#define C2D_TUSTIN   3   /* bilinear (trapezoidal)                       */
+
+#define C2D_CACHE_DIR  CACHE_DIR  /* discretized systems, by hash, HPGcache.h */
+
+/* matrix exponential  E = expm(M),  M and E are n by n, row-major */
+void c2d_expm ( const double *M,
+                double *E,
+                int n );
+
+/* solve M X = R, M is n by n, R is n by c, X is returned in R */
+int  c2d_solve ( double *M,
+                 double *R,
+                 int n,
+                 int c );
+
+/* convert S = [ A B ; C D ] from continuous time to discrete time, in place */
+int  c2d ( double *S,
+           int n,
+           int m,
+           int p,
+           double T,
+           int method );
+
+/* c2d(), using the cached result for the same system, T, and method */
+int  c2d_cached ( double *S,
+                  int n,
+                  int m,
+                  int p,
+                  double T,
+                  int method );
+
+/* C2D_ZOH, C2D_FOH, or C2D_TUSTIN from a name, 0 if none */
+int  c2d_method ( char *name );
+
+#endif // _HPGC2D_H_
@@ -0,0 +1,112 @@
+/*******************************************************************************
+HPGcache.c
+the files kept from one test to the next ... the discretized controllers of
+HPGc2d.c and the ADS1256 calibrations of HPGcal.c
+
+HPGdaac runs as root, and the matrices and calibrations read from the cache
+go straight into the controller and the converter, so the cache is kept in
+CACHE_DIR, a directory that only root may write, and a cache file is
+trusted only if root owns it and no one else may write it.  The directory
+is checked with lstat, so a symbolic link planted in its place is refused.
+Files are opened with O_NOFOLLOW and checked with fstat on the open file,
+so the file checked is the file read.  A cache file is written to a new
+temporary file, created with O_EXCL, and renamed over the old file when it
+is complete, so a test running at the same time reads either the old or
+the new file, never part of one.  Cache files are written as root even
+while a test of hpgdaacd reaches the file system as its user (HPGuser.c).
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <errno.h>          // errno
+#include <fcntl.h>          // open, O_NOFOLLOW
+#include <unistd.h>         // getpid, close
+#include <sys/stat.h>       // mkdir, lstat, fstat
+
+// local libraries .. .
+#include "HPGcache.h"                 // header for the cache directory
+#include "HPGuser.h"                  // user_fs
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* CACHE_DIR - create the cache directory if it is missing, and check that
+   it is a directory owned by root that no one else may write
+   returns 0: safe  1: not safe, with a warning the first time       19oct26
+---------------------------------------------------------------------------*/
+int cache_dir ( void )
+{
+  static int   warned = 0;
+  struct stat  s;
+
+  if ( mkdir ( CACHE_DIR, 0755 ) && errno != EEXIST )  return 1;
+  if ( lstat ( CACHE_DIR, &s ) == 0 && S_ISDIR ( s.st_mode ) &&
+       s.st_uid == 0 && ( s.st_mode & (S_IWGRP | S_IWOTH) ) == 0 )
+    return 0;
+
+  if ( !warned ) {
+    color(1); color(33);
+    fprintf(stderr," cache: %s is not a directory owned and written only by root, not used\n",
+                    CACHE_DIR );
+    warned = 1;
+  }
+  return 1;
+}
+
+
+/* CACHE_OPEN - open a cache file for reading, only a regular file owned by
+   root that no one else may write, in a safe directory, NULL otherwise
+---------------------------------------------------------------------------*/
+FILE *cache_open ( const char *filename )
+{
+  struct stat  s;
+  FILE        *fp;
+  int          fd;
+
+  if ( cache_dir() )  return NULL;
+  if ( (fd = open ( filename, O_RDONLY | O_NOFOLLOW )) < 0 )  return NULL;
+  if ( fstat ( fd, &s ) || !S_ISREG ( s.st_mode ) || s.st_uid != 0 ||
+       ( s.st_mode & (S_IWGRP | S_IWOTH) ) ||
+       (fp = fdopen ( fd, "r" )) == NULL ) {
+    close ( fd );
+    return NULL;
+  }
+  return fp;
+}
+
+
+/* CACHE_CREATE - create the temporary file tmp next to filename, for
+   writing, with O_EXCL and O_NOFOLLOW, NULL if it cannot be created
+---------------------------------------------------------------------------*/
+FILE *cache_create ( const char *filename, char *tmp, size_t len )
+{
+  FILE  *fp = NULL;
+  int    fd, asUser = user_fs ( 0 );        // as root
+
+  if ( cache_dir() == 0 ) {
+    snprintf ( tmp, len, "%s.%d", filename, (int) getpid() );
+    (void) unlink ( tmp );                  // left by an earlier process
+    fd = open ( tmp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0644 );
+    if ( fd >= 0 && (fp = fdopen ( fd, "w" )) == NULL ) {
+      close ( fd );
+      (void) unlink ( tmp );
+    }
+  }
+  user_fs ( asUser );
+  return fp;
+}
+
+
+/* CACHE_COMMIT - close the temporary file and rename it to filename, or
+   remove it if it could not be written
+   returns 0: successful  1: abnormal
+---------------------------------------------------------------------------*/
+int cache_commit ( FILE *fp, const char *tmp, const char *filename )
+{
+  int  err = ferror ( fp ),  asUser = user_fs ( 0 );  // as root
+
+  if ( fclose ( fp ) || err || rename ( tmp, filename ) ) {
+    (void) unlink ( tmp );
+    err = 1;
+  }
+  user_fs ( asUser );
+  return err ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGcache.h
+ *
+ *    Description:  header file for HPGcache.c
+ *                  the files kept between tests, the c2d results and the
+ *                  ADS1256 calibrations, in a directory only root writes
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGCACHE_H_
+#define _HPGCACHE_H_
+
+#include <stdio.h>          // FILE
+#include <stddef.h>         // size_t
+
+#define CACHE_DIR  "/var/cache/HPGdaac"  /* owned by root, mode 0755     */
+
+/* create CACHE_DIR if it is missing, and check that it is a directory
+   owned by root that no one else may write;  returns 0: safe  1: not */
+int   cache_dir ( void );
+
+/* open a cache file for reading, only a regular file owned by root that
+   no one else may write, in a safe CACHE_DIR;  NULL otherwise */
+FILE *cache_open ( const char *filename );
+
+/* create a new temporary file, tmp, next to filename in a safe CACHE_DIR,
+   for writing;  NULL if it cannot be created */
+FILE *cache_create ( const char *filename,
+                     char *tmp,
+                     size_t len );
+
+/* close the temporary file and rename it to filename, or remove it if it
+   could not be written;  returns 0: successful  1: abnormal */
+int   cache_commit ( FILE *fp,
+                     const char *tmp,
+                     const char *filename );
+
+#endif // _HPGCACHE_H_
@@ -0,0 +1,231 @@
+/*******************************************************************************
+HPGcal.c
+self-calibration of the ADS1256 at each PGA gain used in a test
+
+The offset (OFC) and full-scale (FSC) calibration registers of the ADS1256
+hold one calibration, made at one PGA gain and one data rate.  The chip
+calibrates itself at gain 1 when it is reset, so channels with smaller
+voltage ranges would otherwise be converted with the calibration of another
+gain.  cal_setup() finds a calibration for each gain used by the channels,
+at the data rate of the test, and gives them to HPADDAlib, which writes the
+six OFC and FSC bytes of a gain in the same SPI command as the MUX and ADCON
+registers whenever the scan changes to that gain.
+
+A self-calibration takes from 0.6 ms at 30000 cps to 1.2 s at 2.5 cps, so
+calibrations are saved in CAL_CACHE_FILE, one line each, with the board,
+data rate, gain, temperature and time at which they were made:
+
+  board  cps  gain  deg.C  time  OFC0 OFC1 OFC2 FSC0 FSC1 FSC2
+
+The board is identified by the serial number of the Raspberry Pi it is
+mounted on, followed by /cs and the chip select pin for an ADS1256 other
+than that of the board, and its temperature by that of the Raspberry Pi
+processor.  A cached calibration is used within CAL_TEMP_WINDOW deg.C and
+CAL_MAX_AGE seconds of when it was made; otherwise the gain is calibrated
+again and the cache is updated.  The cache is read and written through
+HPGcache.c, which trusts only a file owned by root in a directory only root
+may write, since the calibrations go straight into the converter.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <strings.h>        // strcasecmp
+#include <math.h>           // fabs, NAN
+#include <time.h>           // time, clock_gettime
+
+// local libraries .. .
+#include "HPADDAlib.h"                // ADS1256_SelfCal, ADS1256_SetCal
+#include "HPGcal.h"                   // header for the calibration cache
+#include "HPGcache.h"                 // cache_open, cache_create
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+  struct CALLINE {      // one line of the calibration cache
+         char       board[32];     // Raspberry Pi serial number
+         float      cps;           // data rate, conversions per second
+         int        gain;          // PGA gain code, 0 to 6
+         float      degC;          // temperature, deg. C
+         long long  time;          // when it was made, seconds since 1970
+         unsigned   reg[6];        // OFC0 OFC1 OFC2 FSC0 FSC1 FSC2
+      };
+
+
+/* BOARD_SERIAL - the serial number of the Raspberry Pi             19oct26
+---------------------------------------------------------------------------*/
+static void board_serial ( char *board, size_t len )
+{
+  FILE  *fp;
+  char   line[256], serial[32];
+
+  snprintf ( board, len, "unknown" );
+  if ( (fp = fopen ( "/proc/cpuinfo", "r" )) == NULL )  return;
+  while ( fgets ( line, sizeof(line), fp ) != NULL )
+    if ( sscanf ( line, "Serial : %31s", serial ) == 1 )
+      snprintf ( board, len, "%s", serial );
+  fclose(fp);
+}
+
+
+/* BOARD_TEMPERATURE - the processor temperature, deg. C, NAN if unknown
+---------------------------------------------------------------------------*/
+static float board_temperature ( void )
+{
+  FILE  *fp;
+  int    milliC;
+
+  if ( (fp = fopen ( "/sys/class/thermal/thermal_zone0/temp", "r" )) == NULL )
+    return NAN;
+  if ( fscanf ( fp, "%d", &milliC ) != 1 )  milliC = 0x7fffffff;
+  fclose(fp);
+  return ( milliC == 0x7fffffff ) ? NAN : 0.001 * milliC;
+}
+
+
+/* CAL_MATCH - 1 if a cached calibration is for this board, data rate, and
+   gain, within the temperature window, or both temperatures unknown  19oct26
+---------------------------------------------------------------------------*/
+static int cal_match ( struct CALLINE *c, char *board, float cps, int gain,
+                       float degC )
+{
+  return ( strcmp ( c->board, board ) == 0 && fabs ( c->cps - cps ) < 0.01 &&
+           c->gain == gain &&
+           ( fabs ( c->degC - degC ) <= CAL_TEMP_WINDOW ||
+             ( isnan ( c->degC ) && isnan ( degC ) ) ) );
+}
+
+
+/* READ_CACHE - the lines of the calibration cache, the number read
+---------------------------------------------------------------------------*/
+static int read_cache ( struct CALLINE *c, int max )
+{
+  FILE  *fp;
+  char   line[256];
+  int    n = 0;
+
+  if ( (fp = cache_open ( CAL_CACHE_FILE )) == NULL )  return 0;
+  while ( n < max && fgets ( line, sizeof(line), fp ) != NULL ) {
+    if ( line[0] == '%' )  continue;                 // the heading
+    if ( sscanf ( line, "%31s %f %d %f %lld %x %x %x %x %x %x",
+                  c[n].board, &c[n].cps, &c[n].gain, &c[n].degC, &c[n].time,
+                  &c[n].reg[0], &c[n].reg[1], &c[n].reg[2],
+                  &c[n].reg[3], &c[n].reg[4], &c[n].reg[5] ) == 11 &&
+         c[n].gain >= 0 && c[n].gain < 8 )
+      ++n;
+  }
+  fclose(fp);
+  return n;
+}
+
+
+/* WRITE_CACHE - replace the calibration cache, by renaming a new file, so
+   a test running at the same time reads either the old or the new file
+---------------------------------------------------------------------------*/
+static void write_cache ( struct CALLINE *c, int n )
+{
+  FILE  *fp;
+  char   tmp[sizeof(CAL_CACHE_FILE)+16];
+  int    k;
+
+  if ( (fp = cache_create ( CAL_CACHE_FILE, tmp, sizeof(tmp) )) == NULL )
+    return;
+  fprintf(fp,"%% ADS1256 self-calibrations, written by HPGdaac\n");
+  fprintf(fp,"%% board              cps gain   deg.C       time  OFC0 OFC1 OFC2 FSC0 FSC1 FSC2\n");
+  for (k=0; k<n; k++)
+    fprintf(fp,"%-16s %8g %4d %7.1f %10lld   %02x   %02x   %02x   %02x   %02x   %02x\n",
+            c[k].board, c[k].cps, c[k].gain, c[k].degC, c[k].time,
+            c[k].reg[0], c[k].reg[1], c[k].reg[2],
+            c[k].reg[3], c[k].reg[4], c[k].reg[5] );
+  (void) cache_commit ( fp, tmp, CAL_CACHE_FILE );
+}
+
+
+/* CAL_MODE - the calibration method from its name, -1 if none       19oct26
+---------------------------------------------------------------------------*/
+int cal_mode ( char *name )
+{
+  if ( strcasecmp ( name, "off" )    == 0 )  return CAL_OFF;
+  if ( strcasecmp ( name, "cached" ) == 0 )  return CAL_CACHED;
+  if ( strcasecmp ( name, "fresh" )  == 0 )  return CAL_FRESH;
+  return -1;
+}
+
+
+/* CAL_SETUP - find a calibration for each PGA gain used by the channels,
+   at the present data rate, in the cache, or by self-calibration, and give
+   them to the converter ad.   returns 0: successful  1: abnormal   19oct26
+---------------------------------------------------------------------------*/
+int cal_setup ( struct ADS1256 *ad, unsigned nChnl, uint8_t *rangeCode,
+                float drate, int mode )
+{
+  static struct CALLINE  c[CAL_MAX_LINES];
+  struct timespec  t0, t1;
+  char       board[32];
+  float      degC;
+  long long  now = (long long) time(NULL);
+  int        used[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  int        n, k, r, g, found, saved = 0;
+  uint8_t    cal[6];
+  unsigned   chn;
+
+  ADS1256_ClearCal ( ad );
+  if ( mode == CAL_OFF )  return 0;
+
+  for (chn=0; chn<nChnl; chn++)  used[rangeCode[chn] & 0x07] = 1;
+
+  board_serial ( board, sizeof(board) );
+  if ( ad != &ads1256 )                       // another ADS1256 on the bus
+    snprintf ( board + strlen(board), sizeof(board) - strlen(board),
+               "/cs%u", ad->cs );
+  degC = board_temperature();
+  n = read_cache ( c, CAL_MAX_LINES );
+
+  for (g=0; g<8; g++) {
+    if ( !used[g] )  continue;
+    fprintf(stderr," ADS1256 calibration %8.5f V at %7.1f cps",
+                    ADS1256_range_value(g), drate );  fflush(stderr);
+
+    found = -1;                                      // the most recent match
+    if ( mode == CAL_CACHED )
+      for (k=0; k<n; k++)
+        if ( cal_match ( &c[k], board, drate, g, degC ) &&
+             now - c[k].time <= CAL_MAX_AGE &&
+             ( found < 0 || c[k].time > c[found].time ) )  found = k;
+
+    if ( found >= 0 ) {
+      for (r=0; r<6; r++)  cal[r] = (uint8_t) c[found].reg[r];
+      ADS1256_SetCal ( ad, g, cal );
+      fprintf(stderr," . . . . . . . . . . . . . .  cached \n");
+      continue;
+    }
+
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    if ( ADS1256_SelfCal ( ad, g, cal ) ) {
+      color(1); color(31);
+      fprintf(stderr," . . . . . . . . . . . . . .  failed \n");
+      color(1); color(37);
+      return 1;
+    }
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    fprintf(stderr," . . . . . . .  success %7.1f ms \n",
+             (t1.tv_sec - t0.tv_sec)*1e3 + (t1.tv_nsec - t0.tv_nsec)*1e-6 );
+
+    for (k=0; k<n; )          // replace calibrations in the same window
+      if ( cal_match ( &c[k], board, drate, g, degC ) )  c[k] = c[--n];
+      else  k++;
+    if ( n == CAL_MAX_LINES ) {                      // replace the oldest
+      for (found=0, k=1; k<n; k++)  if ( c[k].time < c[found].time )  found = k;
+      c[found] = c[--n];
+    }
+    snprintf ( c[n].board, sizeof(c[n].board), "%s", board );
+    c[n].cps  = drate;
+    c[n].gain = g;
+    c[n].degC = degC;
+    c[n].time = now;
+    for (r=0; r<6; r++)  c[n].reg[r] = cal[r];
+    ++n;
+    saved = 1;
+  }
+
+  if ( saved )  write_cache ( c, n );
+
+  return 0;
+}
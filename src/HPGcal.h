@@ -0,0 +1,42 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGcal.h
+ *
+ *    Description:  header file for HPGcal.c
+ *                  ADS1256 self-calibration, per PGA gain, cached on disk
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGCAL_H_
+#define _HPGCAL_H_
+
+#include <stdint.h>         // uint8_t
+#include "HPADDAlib.h"      // struct ADS1256
+#include "HPGcache.h"       // CACHE_DIR
+
+#define CAL_OFF      0   /* the calibration of the reset, at gain 1      */
+#define CAL_CACHED   1   /* from the cache, or self-calibrate and save   */
+#define CAL_FRESH    2   /* self-calibrate, and save                     */
+
+#define CAL_CACHE_FILE CACHE_DIR "/ads1256.cal"   /* one line per cal, HPGcache.h */
+#define CAL_TEMP_WINDOW   5.0   /* a cached calibration is used within   */
+                                /* this many deg C of where it was made  */
+#define CAL_MAX_AGE  (7*86400)  /* ... and for this many seconds         */
+#define CAL_MAX_LINES    256    /* calibrations kept in the cache        */
+
+/* the calibration method from its name, -1 if none */
+int  cal_mode ( char *name );
+
+/* calibrate each PGA gain used by the channels of converter ad, at the
+   present data rate */
+int  cal_setup ( struct ADS1256 *ad,
+                 unsigned nChnl,
+                 uint8_t *rangeCode,
+                 float drate,
+                 int mode );
+
+#endif // _HPGCAL_H_
@@ -0,0 +1,261 @@
+/*******************************************************************************
+HPGchar.c
+characterization of the board ... noise, resolution, scan period, and skew,
+over the data rates of the ADS1256 and its PGA gains
+
+    sudo HPGdaac -c test.cfg perf.tbl [reference.tbl]
+
+The channels of the test configuration are converted, with their inputs
+shorted or, with the loopback line of the configuration, wired to a D/A
+held at zero volts, at every data rate of ADS1256_CSPEED from 30000 cps
+down to the digitization rate of the configuration, and at every PGA gain.
+At each setting the board is calibrated as in a test, CHAR_SETTLE scans are
+discarded, and the number of scans on the "Characterization" line of the
+configuration (CHAR_SCANS by default) are converted as fast as they can be,
+with one ADS1256_ChannelScan of the channels of each converter of the
+"Converter" line, one converter after the other, as in a test.  For each
+setting one row of the table file gives
+
+  cps      the data rate, conversions per second
+  range    the voltage range of the PGA gain, volts
+  gain     the PGA gain code, 0 to 6
+  scans    the scans converted
+  chn      the noisiest channel
+  rms_uV   its noise, rms, micro-volts
+  rms      ... in A/D units
+  p-p      its peak-to-peak noise, A/D units
+  ENOB     effective number of bits,  log2 ( 2 ADMAX / rms )
+  NFB      noise-free bits,           log2 ( 2 ADMAX / p-p )
+  scan_us  the mean time to convert a scan, micro-seconds
+  max_us   the longest time to convert a scan, micro-seconds
+  max_sps  the highest scan rate, 1e6 / max_us
+  skew_us  the mean time between the conversions of consecutive channels
+  first_us the conversion instant of the first channel converted, after
+           the scan start
+  ref      the noise of the reference table at this setting, A/D units rms,
+           or 0 if the setting is not in the reference table
+
+The table has the '%' heading lines of the data files, and one row of
+numbers per setting, to be read by a program.  A setting whose noise
+exceeds that of the reference table, a table of the same board made
+earlier, by more than a factor CHAR_DEGRADED is reported as degraded, and
+HPGdaac exits with status 1.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <math.h>           // sqrt, log2, fabs
+#include <time.h>           // time, ctime
+
+// local libraries .. .
+#include "HPGdaac.h"                  // read_configuration, good_bye
+#include "HPGcal.h"                   // ADS1256 self-calibration
+#include "HPGchar.h"                  // header for the characterization
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+  struct CHARREF {      // one row of a reference table
+         float   cps;              // data rate, conversions per second
+         int     gain;             // PGA gain code
+         double  rms;              // noise, A/D units rms
+      };
+
+// the data rates of ADS1256_CSPEED, fastest first
+static const float charRate[16] = { 30000, 15000, 7500, 3750, 2000, 1000, 500,
+                                    100, 60, 50, 30, 25, 15, 10, 5, 2.5 };
+
+
+/* READ_REFERENCE - the rows of a reference table, the number read
+---------------------------------------------------------------------------*/
+static int read_reference ( char *filename, struct CHARREF *r, int max )
+{
+  FILE     *fp;
+  char      line[512];
+  float     range;
+  unsigned  scans, chn;
+  double    rmsuV;
+  int       n = 0;
+
+  if ( (fp = fopen ( filename, "r" )) == NULL ) {
+    color(0); color(41);
+    fprintf(stderr,"  cannot open reference table '%s'  ", filename );
+    color(0); fprintf(stderr,"\n"); color(1); color(33);
+    return 0;
+  }
+  while ( n < max && fgets ( line, sizeof(line), fp ) != NULL ) {
+    if ( line[0] == '%' )  continue;                 // the heading
+    if ( sscanf ( line, "%f %f %d %u %u %lf %lf", &r[n].cps, &range,
+                  &r[n].gain, &scans, &chn, &rmsuV, &r[n].rms ) == 7 )
+      ++n;
+  }
+  fclose(fp);
+  return n;
+}
+
+
+/* CHARACTERIZE - sweep the data rates and PGA gains on the channels of a
+   test configuration, write the table of noise, resolution, scan period
+   and skew.   returns the number of degraded settings               19oct26
+---------------------------------------------------------------------------*/
+int characterize ( int argc, char *argv[] )
+{
+  static struct CHARREF  ref[CHAR_MAX_ROWS];
+  FILE     *fp;
+  char     *args[3],
+            title[MAXL], chnlDesc[MAXL], da0fn[MAXL], da1fn[MAXL],
+            sensiFilename[MAXL];
+  float     dtime, sr, drate, cps;
+  unsigned  nChnl = 8, chn, worst, s, nScans, c, n;
+  int       da0 = 0, da1 = 0, nRef = 0, nDegraded = 0, r, g, k;
+  uint8_t   muxCode[NUMCHNL], rangeCode[NUMCHNL], gainCode[NUMCHNL],
+            mux[NUMCHNL];
+  int32_t   ad[NUMCHNL], adCnv[NUMCHNL];
+  uint64_t  tConv[NUMCHNL], tCnv[NUMCHNL], t0, t1;
+  struct ADS1256  *conv[ACQ_MAXAD];   // the converters of the channels
+  double    sum[NUMCHNL], sum2[NUMCHNL], lo[NUMCHNL], hi[NUMCHNL], inst[NUMCHNL],
+            rms[NUMCHNL], tScan, tMax, refRms, enob, nfb, skew, first, last;
+  time_t    now = time(NULL);
+
+  if ( argc < 3 ) {
+    errorMsg("  usage: HPGdaac -c [config file] [table file] [reference table]  ");
+    good_bye ( 0,0,0 );
+  }
+  args[0] = "HPGdaac";  args[1] = argv[1];  args[2] = argv[2];
+  read_configuration ( 3, args, title, &dtime, &sr, &drate, &nChnl, muxCode,
+                       rangeCode, chnlDesc, chnl, &da0, &da1, da0fn, da1fn,
+                       sensiFilename, ctrlCnst, &opts );
+  if ( argc > 3 )  nRef = read_reference ( argv[3], ref, CHAR_MAX_ROWS );
+  nScans = opts.charScans;
+  for (chn=0; chn<nChnl; chn++)
+    if ( opts.cnv[chn] >= opts.nCnv ) {
+      errorMsg("  A channel is on a converter without pins on the Pins line.");
+      good_bye ( 0,0,0 );
+    }
+
+  if ( (fp = fopen ( argv[2], "w" )) == NULL ) {
+    color(0); color(41);
+    fprintf(stderr,"  cannot open table file '%s'  ", argv[2] );
+    color(0); fprintf(stderr,"\n"); color(1); color(33);
+    good_bye ( 0,0,0 );
+  }
+
+  if ( initHPADDAboard() || open_converters ( conv, &opts ) ) {
+    fclose(fp);
+    good_bye ( 1,0,0 );
+  }
+  if ( opts.loopDA == 0 || opts.loopDA == 1 )      // looped inputs at zero
+    DAC8532_Write ( &dac8532, opts.loopDA, DA_00 );
+
+  fprintf(fp, "%% %s", ctime(&now) );
+  fprintf(fp, "%% %s\n", title );
+  fprintf(fp, "%% characterization table '%s' created using configuration '%s'\n",
+               argv[2], argv[1] );
+  fprintf(fp, "%%  %u scans of %u channels at each setting, inputs %s\n",
+               nScans, nChnl, ( opts.loopDA == 0 || opts.loopDA == 1 ) ?
+               "looped to a D/A at zero volts" : "shorted" );
+  if ( opts.nCnv > 1 ) {
+    fprintf(fp, "%%  converter of each channel ");
+    for (chn=0; chn<nChnl; chn++)  fprintf(fp, " %u", opts.cnv[chn] );
+    fprintf(fp, "\n");
+  }
+  fprintf(fp, "%% %s\n", chnlDesc );
+  fprintf(fp, "%%     cps   range gain  scans chn    rms_uV       rms       p-p   ENOB    NFB   scan_us    max_us   max_sps  skew_us first_us       ref\n");
+
+  for (r=0; r<16 && charRate[r] >= drate; r++)
+    for (g=0; g<7; g++) {
+      for (chn=0; chn<nChnl; chn++)  gainCode[chn] = (uint8_t) g;
+      cps = setup_converters ( conv, opts.nCnv, nChnl, opts.cnv, gainCode,
+                               charRate[r], opts.calMode );
+      if ( cps == 0 ) {
+        fclose(fp);
+        good_bye ( 1,0,0 );
+      }
+
+      for (chn=0; chn<nChnl; chn++) {
+        sum[chn] = sum2[chn] = inst[chn] = 0.0;
+        lo[chn] = 1e12;  hi[chn] = -1e12;
+      }
+      tScan = tMax = 0.0;
+      for (s=0; s<CHAR_SETTLE + nScans; s++) {
+        t0 = conv[0]->ops->st_read();
+        for (c=0; c<opts.nCnv; c++) {           // the channels of each converter
+          for (chn=n=0; chn<nChnl; chn++)
+            if ( opts.cnv[chn] == c )  mux[n++] = muxCode[chn];
+          if ( n == 0 )  continue;
+          if ( ADS1256_ChannelScan ( conv[c], n, mux, gainCode, adCnv, tCnv, NULL ) ) {
+            errorMsg("  characterize: DRDY timeout, the ADS1256 is not converting");
+            fclose(fp);
+            good_bye ( 1,0,0 );
+          }
+          for (chn=n=0; chn<nChnl; chn++)
+            if ( opts.cnv[chn] == c ) {
+              ad[chn] = adCnv[n];
+              tConv[chn] = tCnv[n++];
+            }
+        }
+        t1 = conv[0]->ops->st_read();
+        if ( s < CHAR_SETTLE )  continue;
+        tScan += (double)( t1 - t0 );
+        if ( (double)( t1 - t0 ) > tMax )  tMax = (double)( t1 - t0 );
+        for (chn=0; chn<nChnl; chn++) {
+          sum[chn]  += ad[chn];
+          sum2[chn] += (double) ad[chn] * ad[chn];
+          if ( ad[chn] < lo[chn] )  lo[chn] = ad[chn];
+          if ( ad[chn] > hi[chn] )  hi[chn] = ad[chn];
+          inst[chn] += (double)( tConv[chn] - t0 );
+        }
+      }
+
+      worst = 0;
+      for (chn=0; chn<nChnl; chn++) {
+        sum[chn] /= nScans;
+        rms[chn]  = sqrt ( fabs ( sum2[chn] / nScans - sum[chn]*sum[chn] ) );
+        inst[chn] /= nScans;
+        if ( rms[chn] > rms[worst] )  worst = chn;
+      }
+      tScan /= nScans;
+      enob = log2 ( 2.0 * ADMAX / MAX ( rms[worst], 1.0 ) );
+      nfb  = log2 ( 2.0 * ADMAX / MAX ( hi[worst] - lo[worst], 1.0 ) );
+      first = last = inst[0];                 // in the order converted
+      for (chn=1; chn<nChnl; chn++) {
+        if ( inst[chn] < first )  first = inst[chn];
+        if ( inst[chn] > last  )  last  = inst[chn];
+      }
+      skew = ( nChnl > 1 ) ? ( last - first ) / ( nChnl-1 ) : 0.0;
+
+      refRms = 0.0;
+      for (k=0; k<nRef; k++)
+        if ( fabs ( ref[k].cps - cps ) < 0.01 && ref[k].gain == g )  refRms = ref[k].rms;
+
+      fprintf(fp, "%9.1f %7.4f %4d %6u %3u %9.3f %9.1f %9.0f %6.2f %6.2f %9.1f %9.0f %9.1f %8.1f %8.1f %9.1f\n",
+              cps, ADS1256_range_value(g), g, nScans, worst,
+              rms[worst] * ADS1256_range_value(g) / ADMAX * 1e6,
+              rms[worst], hi[worst] - lo[worst], enob, nfb,
+              tScan, tMax, 1e6 / MAX ( tMax, 1.0 ), skew, first, refRms );
+      fflush(fp);
+
+      color(1); color(33);
+      fprintf(stderr," %8.1f cps %7.4f V  chn %u  %9.3f uV rms  %5.2f bits  %8.1f sps  skew %6.1f us",
+              cps, ADS1256_range_value(g), worst,
+              rms[worst] * ADS1256_range_value(g) / ADMAX * 1e6,
+              enob, 1e6 / MAX ( tMax, 1.0 ), skew );
+      if ( refRms > 0 && rms[worst] > CHAR_DEGRADED * refRms ) {
+        ++nDegraded;
+        color(0); color(41);  fprintf(stderr," DEGRADED");
+        color(0); color(1); color(33);
+      }
+      fprintf(stderr,"\n");
+    }
+
+  fclose(fp);
+  chOwnGrpMod( argv[2], 0444 );
+  closeHPADDAboard();
+
+  color(1); color(33);
+  fprintf(stderr,"  characterization saved to file '%s'", argv[2] );
+  if ( nRef > 0 )
+    fprintf(stderr,", %d settings degraded from '%s'", nDegraded, argv[3] );
+  fprintf(stderr,"\n");
+  color(0);
+
+  return nDegraded;
+}
@@ -0,0 +1,29 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGchar.h
+ *
+ *    Description:  header file for HPGchar.c
+ *                  characterization of the board: noise, resolution,
+ *                  scan period, and skew, over data rates and PGA gains
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGCHAR_H_
+#define _HPGCHAR_H_
+
+#define CHAR_SCANS      1000   /* scans at each data rate and gain, default */
+#define CHAR_SETTLE        4   /* scans discarded after a change of setting */
+#define CHAR_DEGRADED    1.5   /* noise above a reference table, by this    */
+#define CHAR_MAX_ROWS    256   /* rows of a reference table                 */
+
+/* HPGdaac -c config_file table_file [reference_table_file]
+   sweep the data rates and gains on the channels of the configuration,
+   returns the number of settings noisier than the reference table */
+int  characterize ( int argc,
+                    char *argv[] );
+
+#endif // _HPGCHAR_H_
@@ -1,327 +1,499 @@
 /*******************************************************************************
 HPGcontrol.c
 routines for real time control
+
+    ---- CONTROLLER  DATA  FILE  FORMAT ----
+
+Descriptive Title (one line only)
+Number of controller states      (N)       :   2
+Number of controller inputs      (L)       :   2
+Number of controller outputs     (M)       :   1
+Input A/D channels  [0 to 31]              :   0   1
+Output D/A channels [0 or 1]               :   0
+Output voltage limits (min max)            :   0.0   5.0
+Time domain [discrete, zoh, foh, tustin]   :   discrete
+Controller dynamics matrix A  (N rows of N values)
+    0.9980    0.0100
+   -0.0100    0.9980
+Controller input matrix    B  (N rows of L values)
+    0.0000    0.0000
+    0.0100    0.0000
+Controller output matrix   C  (M rows of N values)
+    1.0000    0.0000
+Controller feedthrough matrix D  (M rows of L values)
+    0.5000   -0.5000
+
+The controller is a discrete time system at the scan rate,
+  x(k+1) = A x(k) + B y(k)   ...   u(k) = C x(k) + D y(k)
+where y is in the sensor units of the sensitivity file and u is in volts.
+If the time domain is zoh, foh, or tustin, the matrices describe a continuous
+time system,  dx/dt = A x + B y ... u = C x + D y,  which is converted to
+discrete time at the scan rate, once, before the test, by c2d() in HPGc2d.c.
+
+    ---- CONTROLLER  PLUG-INS ----
+
+A controller data file name ending in .so is loaded as a controller plug-in,
+a shared object with the interface of HPGplugin.h.  Since HPGdaac runs
+setuid root, and the plug-in runs in the scan handler with it, the plug-in
+must be a regular file owned by root and not writable by group or others,
+in a directory owned by root that group and others may not write, such as
+/usr/local/lib/HPGdaac (make install-plugins).  The directory and then the
+file in it are opened, without following a symbolic link to the file, and
+checked with fstat, and the plug-in is loaded through /proc/self/fd, so the
+file checked is the file loaded.
 *******************************************************************************/
 
 #include <stdio.h>          // standard input/output library routines
 #include <string.h>         // standard string handling library
+#include <strings.h>        // strcasecmp
 #include <math.h>           // standard mathematics library
+#include <time.h>           // clock_gettime
+#include <unistd.h>         // close
+#include <fcntl.h>          // open, openat, O_NOFOLLOW
+#include <libgen.h>         // dirname, basename
+#include <dlfcn.h>          // dlopen, dlsym, dlclose
+#include <sys/stat.h>       // fstat
 
 // local libraries .. .
 #include "HPGcontrol.h"          // header for feedback control functions
+#include "HPGc2d.h"              // continuous to discrete time
 #include "../../HPGnumlib/NRutil.h" // memory allocation routines
+#include "../../HPGnumlib/HPGutil.h" // HPG utility functions
 
-#if CONTROL
 
-/* STATE_MATRICES - the matrix coefficients which define the integrator 17jul01
+/* READ_MATRIX - read an r by c matrix, one row per line, into rows of G
+   with row stride s, starting at column c0                          19oct26
 ---------------------------------------------------------------------------*/
-void state_matrices ( float *xc, float *xc1, float *dxcdt, float *y,
-  float *constants, float sr )
+static int read_matrix ( FILE *fp, float *G, int r, int c, int s, int c0 )
 {
-  float  gainP = 0.0,  /* proportional error feedback gain  */
-    gainI = 0.0,  /* integral error feedback gain    */
-    gainD = 0.0,  /* derivitive error feedback gain  */
-    gainF = 0.0;  /* proportional command feedforward gain */
-/*
-  gainP  = constants[1];
-  gainI  = constants[2];
-  gainD  = constants[3];
-  gainF  = constants[4];
-*/
-
-/*   Jesse's integrator state-varriable constants */
-  float  r1=0.15846e6,  r2=0.16931e6,  r3=1.40752e6,
-    c1=8.53433e-6, c2=6.90523e-6, c3=1.56000e-4, c4=4.28669e-9,
-    scale = 0.03;
-
-/* Julie's integrator state-varriable constants */
-/*  float  r1=0.21715e6,  r2=0.15388e6,  r3=3.63108e6,
-    c1=8.71817e-5, c2=5.41742e-6, c3=1.56000e-4, c4=1.91548e-9,
-    scale=0.0276;
-*/
-
-  int  i, j;     /* counter for initilizing state matrix */
-
-  void  c2d();    /* convert continuous time to discrete time */
-
-  for (i=1; i<=_N; i++) {  /* zero all values for L.T.I. system  */
-    xc[i] = xc1[i] = dxcdt[i] = 0.0;
-   for (j=1; j<=_N; j++)  Ac[i][j] = 0.0;
-    for (j=1; j<=_L; j++)  Bc[i][j] = 0.0;
-  }
-  for (i=1; i<=_M; i++) {  
-    y[i] = 0.0;
-   for (j=1; j<=_N; j++)  Cc[i][j] = 0.0;
-    for (j=1; j<=_L; j++)  Dc[i][j] = 0.0;
-  }
-
-/* 
-  Ac[1][2] = 1.0,
-  Ac[2][1] = -1.0/(r1*r2*c1*c2),
-  Ac[2][2] = -(r1+r2)/(r1*r2*c1),
-  Ac[3][2] = c3/c4,
-  Ac[3][3] = -1.0/(r3*c4);
-  
-  Bc[1][1] = 0.0,
-  Bc[2][1] = scale*1.0/(r1*r2*c1*c2),
-  Bc[3][1] = 0.0;
-*/
-  Ac[1][2] =  1.0;
-  Ac[2][1] = -9.8135e4;
-  Ac[2][2] = -4.9097e2;
-
-  Bc[1][1] = 0.0;
-  Bc[2][1] = 1.0;
-
-  Cc[1][2] = gainD * 1.1747e5;
-//  Cc[1][3] = gainI * 0;
-
-  Dc[1][1] = gainP;
-  Dc[1][2] = gainF;
-
-  c2d(Ac,Bc,sr); /* continuous time to discrete time  */
-
-  color(1);
-  for (i=1; i<=_N; i++) {  /* zero all values for L.T.I. system  */
-    color(32); printf(" Ac:");
-    color(36);
-   for (j=1; j<=_N; j++)  printf(" %10.3e ", Ac[i][j] );
-    color(32); printf(" Bc:");
-    color(36);
-    for (j=1; j<=_L; j++)  printf(" %10.3e ", Bc[i][j] );
-    printf("\n");
-  }
-  for (i=1; i<=_M; i++) {  
-    color(32); printf(" Cc:");
-    color(36);
-   for (j=1; j<=_N; j++)  printf(" %10.3e ", Cc[i][j] );
-    color(32); printf(" Dc:");
-    color(36);
-    for (j=1; j<=_L; j++)  printf(" %10.3e ", Dc[i][j] );
-    printf("\n");
-  }
-  printf("\n");
-  
-  return;
+  char  str[MAXL];
+  int   i, j;
+
+  (void) getLine ( fp, MAXL, str );          // matrix label line
+  for (i=0; i<r; i++)
+    for (j=0; j<c; j++)
+      if ( fscanf ( fp, "%f", &G[i*s + c0 + j] ) != 1 )  return 1;
+  (void) getLine ( fp, MAXL, str );          // clear line
+  return 0;
 }
 
 
-/* DT_SIM - evaluate xc at time (t+1) 
-  xc(t+1) = Ac * xc(t) + Bc * y(t)   ... for the Discrete Time Dynamics
------------------------------------------------------------------------------*/
-void DT_sim ( float *xc1, float *xc, float *y )
+/* READ_CONTROLLER - read a controller data file and allocate the controller
+   storage in one contiguous block.  A continuous time controller is
+   converted to discrete time at the scan rate sr                    19oct26
+---------------------------------------------------------------------------*/
+int read_controller ( char *ctrlFilename, unsigned nChnl, float sr,
+                      struct CTRL *ctrl )
 {
-  int  i, j;
+  FILE  *fp;
+  char   str[MAXL], domain[MAXL];
+  int    i, nz, nw, method = 0;
+  double *S;
 
-  for (i=1; i<=_N; i++) {
-    xc1[i] = 0.0;
-    for (j=1; j<=_N; j++)  xc1[i] += Ac[i][j] * xc[j];
-    for (j=1; j<=_L; j++)  xc1[i] += Bc[i][j] * y[j];
-  }
-  return;
-}
+  i = strlen ( ctrlFilename );                 // a controller plug-in
+  if ( i > 3 && strcmp ( ctrlFilename + i - 3, ".so" ) == 0 )
+    return load_plugin ( ctrlFilename, nChnl, sr, ctrl );
 
+  ctrl->dl = NULL;
 
-/* CONTROL_RULE - calculate control rule for analog output signal     24july01
------------------------------------------------------------------------------*/
-void control_rule ( float *V_out, float *xc, float *y, float *constants )
-{
-  float  threshold = 100.0,  /* threshold to supress chatter */
-    K_iso = 6.6,    /* isolation stiffness  kN/cm  */
-    alpha = 0.2, beta = 0.2, gamma = 0.2,  /* ctrl cnstnts */
-    sgn();      /* sign of a float    */
-
-  float  accel = 0.0, force = 0.0, displ = 0.0;
-
-  int  i, j;
-
-  /* proportional error feedback for pseudo-negative stiffness */
-
-  K_iso       = constants[1];
-  alpha       = constants[2];
-  beta  = constants[3];
-  gamma       = constants[4];
-  threshold   = constants[5];
-  accel       = y[1];
-  displ       = y[2];
-  force      = y[3];
-
-  if ( force*displ < 0.0 ) {
-    if ( fabs(force) < threshold )    // connect
-  //    *V_out = threshold_2;
-      *V_out = gamma*fabs(displ);
-    else     // control
-  //    *V_out += beta*( K_iso*displ + force ) * sgn(displ);
-      *V_out = beta*fabs(displ);
-    if ( *V_out < 0.0 )
-      *V_out = 0.0;
-    if ( *V_out > 1.0 )
-      *V_out = 1.0;
-  } else {
-//    if ( fabs(force) > threshold )    // dis-connect
-      *V_out = alpha;     
-//    else    // don't re-connect
-//      *V_out = 0.0;
+  if ((fp=fopen(ctrlFilename,"r")) == NULL ) {
+    errorMsg("  read_controller: cannot open controller data file" );
+    fprintf(stderr,"  '%s'\n", ctrlFilename );
+    good_bye ( 0,0,0 );
   }
 
-//  if ( force*displ > 0.0 ) {
-//    if ( fabs(force) > threshold )
-//      *V_out = -alpha * fabs(force);
-//    else
-//      *V_out = 0.0;
-//  }
-//  else  
-//    *V_out += beta*( force + K_iso*displ ) * sgn(displ);
+  getLine  ( fp, MAXL, ctrl->title );
+  scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%d", &ctrl->N );
+  scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%d", &ctrl->L );
+  scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%d", &ctrl->M );
+
+  if ( ctrl->N < 0 || ctrl->N > CTRL_MAX_N ||
+       ctrl->L < 1 || ctrl->L > nChnl ||
+       ctrl->M < 1 || ctrl->M > CTRL_MAX_M ) {
+    errorMsg("  read_controller: controller dimensions out of range.");
+    fprintf(stderr,"  0 <= N <= %d,  1 <= L <= %d,  1 <= M <= %d \n",
+                    CTRL_MAX_N, nChnl, CTRL_MAX_M );
+    fclose(fp);
+    good_bye ( 0,0,0 );
+  }
 
-#if 0  /* state variable controller output equation u = Cc*xc + Dc*y */
+  scanLine ( fp, MAXL, str, ':' );
+  for (i=0; i<ctrl->L; i++)  (void) fscanf ( fp, "%d", &ctrl->inChnl[i] );
+  getLine  ( fp, MAXL, str );    // clear line
+  scanLine ( fp, MAXL, str, ':' );
+  for (i=0; i<ctrl->M; i++)  (void) fscanf ( fp, "%d", &ctrl->outDA[i] );
+  getLine  ( fp, MAXL, str );    // clear line
+  scanLine ( fp, MAXL, str, ':' );
+  (void) fscanf ( fp, "%f %f", &ctrl->uMin, &ctrl->uMax );
+  getLine  ( fp, MAXL, str );    // clear line
+  scanLine ( fp, MAXL, str, ':' );
+  (void) fscanf ( fp, "%s", domain );
+  getLine  ( fp, MAXL, str );    // clear line
+  if ( strcasecmp ( domain, "discrete" ) != 0 &&
+       (method = c2d_method ( domain )) == 0 ) {
+    errorMsg("  read_controller: the time domain must be discrete, zoh, foh, or tustin.");
+    fprintf(stderr,"  '%s'\n", domain );
+    fclose(fp);
+    good_bye ( 0,0,0 );
+  }
 
-  *V_out = 0.0;
-  for (i=1; i<=_N; i++)
-    if ( fabs(xc[i]) < 10000.0 )
-  *V_out += Cc[1][i]*xc[i];  // _M = 1
-  for (i=1; i<=_L; i++)  *V_out += Dc[1][i]* y[i];  // _M = 1
-#endif  // state variable controller output equation
+  for (i=0; i<ctrl->L; i++)
+    if ( ctrl->inChnl[i] < 0 || ctrl->inChnl[i] >= nChnl ) {
+      errorMsg("  read_controller: input channel out of range.");
+      fprintf(stderr,"  input %d reads channel %d,", i+1, ctrl->inChnl[i] );
+      fprintf(stderr," but only channels 0 to %d are scanned", nChnl-1 );
+      fclose(fp);
+      good_bye ( 0,0,0 );
+    }
+  for (i=0; i<ctrl->M; i++)
+    if ( ctrl->outDA[i] < 0 || ctrl->outDA[i] > 1 ||
+         ( i > 0 && ctrl->outDA[i] == ctrl->outDA[0] ) ) {
+      errorMsg("  read_controller: output D/A channels must be 0 or 1, and distinct.");
+      fclose(fp);
+      good_bye ( 0,0,0 );
+    }
+  if ( ctrl->uMin < 0.0 )     ctrl->uMin = 0.0;      // D/A output range
+  if ( ctrl->uMax > DA_VREF ) ctrl->uMax = DA_VREF;
+
+  // allocate G, z, and w together, so the kernel touches one block of memory
+  nz = ctrl->N + ctrl->L;
+  nw = ctrl->N + ctrl->M;
+  ctrl->G = vector ( 0, nw*nz + nz + nw - 1 );
+  ctrl->z = ctrl->G + nw*nz;
+  ctrl->w = ctrl->z + nz;
+  for (i=0; i < nw*nz + nz + nw; i++)  ctrl->G[i] = 0.0;
+
+  if ( read_matrix ( fp, ctrl->G,             ctrl->N, ctrl->N, nz, 0 )       ||
+       read_matrix ( fp, ctrl->G,             ctrl->N, ctrl->L, nz, ctrl->N ) ||
+       read_matrix ( fp, ctrl->G + ctrl->N*nz, ctrl->M, ctrl->N, nz, 0 )      ||
+       read_matrix ( fp, ctrl->G + ctrl->N*nz, ctrl->M, ctrl->L, nz, ctrl->N ) ) {
+    errorMsg("  read_controller: too few values in the controller matrices.");
+    fprintf(stderr,"  '%s'\n", ctrlFilename );
+    fclose(fp);
+    good_bye ( 0,0,0 );
+  }
+  fclose(fp);
+
+  if ( method && ctrl->N > 0 ) {      // continuous time ... convert to discrete
+    S = dvector ( 0, nw*nz - 1 );
+    for (i=0; i < nw*nz; i++)  S[i] = ctrl->G[i];
+    if ( c2d_cached ( S, ctrl->N, ctrl->L, ctrl->M, 1.0/sr, method ) ) {
+      errorMsg("  read_controller: the controller could not be converted to discrete time.");
+      free_dvector ( S, 0, nw*nz - 1 );
+      good_bye ( 0,0,0 );
+    }
+    for (i=0; i < nw*nz; i++)  ctrl->G[i] = S[i];
+    free_dvector ( S, 0, nw*nz - 1 );
+  }
 
-  if (*V_out < -9.0) *V_out = -9.0;
-  if (*V_out >  9.0) *V_out =  9.0;
+  print_controller ( ctrl );
 
-  return;
+  return(0);
 }
 
-/*// process the data in real time for feedback control 
-#if CONTROL
-  
-    y[1] = ad_data[smpl-stop_chnl+RT_CHN_1] - chnl[RT_CHN_1].bias; 
-    y[1] *=  range / ADMAX / sensi[RT_CHN_1];
 
-    y[2] = ad_data[smpl-stop_chnl+RT_CHN_2] - chnl[RT_CHN_2].bias; 
-    y[2] *=  range / ADMAX / sensi[RT_CHN_2];
+/* ROOT_ONLY - 1 if the open file fd is owned by root, is not writable by
+   group or others, and is a regular file or a directory, as asked
+---------------------------------------------------------------------------*/
+static int root_only ( int fd, int dir )
+{
+  struct stat  st;
 
-    y[3] = ad_data[smpl-stop_chnl+RT_CHN_3] - chnl[RT_CHN_3].bias; 
-    y[3] *=  range / ADMAX / sensi[RT_CHN_3];
+  return ( fd >= 0 && fstat ( fd, &st ) == 0 &&
+           ( dir ? S_ISDIR ( st.st_mode ) : S_ISREG ( st.st_mode ) ) &&
+           st.st_uid == 0 && ( st.st_mode & ( S_IWGRP | S_IWOTH ) ) == 0 );
+}
 
-#if 0
-    // S.L. table control stuff 
-    ref_cmnd = ((float)da0_data[t]-2048.8)/2048.0 * max_displ;
 
-    y[1] -= ref_cmnd;    // position error 
-    y[2] = ref_cmnd;     // reference command 
-#endif  // S.L. table control stuff
+/* OPEN_PLUGIN - open the plug-in file, only a file owned and written only
+   by root in a directory owned and written only by root, and return the
+   open file, -1 if it is not such a file                            19oct26
+---------------------------------------------------------------------------*/
+static int open_plugin ( char *pluginFilename )
+{
+  char  dirPath[MAXL], filePath[MAXL];
+  int   dfd, fd = -1;
 
-    // state_deriv ( y, xc, dxcdt );
-    // rk4 ( xc, dxcdt, _N, 1.0/sr, y, xc, state_deriv);
-    
-    DT_sim( xc1, xc, y );
-    control_rule( &V_out, xc1, y, constants );
+  strncpy ( dirPath,  pluginFilename, MAXL-1 );  dirPath[MAXL-1]  = '\0';
+  strncpy ( filePath, pluginFilename, MAXL-1 );  filePath[MAXL-1] = '\0';
 
-//    V_out = -5.0 + t*10.0/N_scans;    // for testing
-//    V_out = ref_cmnd;      // for testing
+  dfd = open ( dirname ( dirPath ), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+  if ( root_only ( dfd, 1 ) ) {     // no one else can replace the file ...
+    fd = openat ( dfd, basename ( filePath ),
+                  O_RDONLY | O_NOFOLLOW | O_CLOEXEC );
+    if ( fd >= 0 && !root_only ( fd, 0 ) ) { close ( fd );  fd = -1; }
+  }
+  if ( dfd >= 0 )  close ( dfd );
+  return fd;
+}
 
-#if CONTROL_DA0
-    da0_data[t] = (int)((V_out / 10.1 + 1.0) * 2047.0 ); // 12 bit
-#endif  // CONTROL DA0 
-#if CONTROL_DA1
-    da1_data[t] = (int)((V_out / 10.1 + 1.0) * 2047.0 ); // 12 bit
-#endif  // CONTROL_DA1
 
-    xc = xc1;    // copy contents of xc1 into xc 
+/* REJECT_PLUGIN - release a plug-in whose init function has run, with its
+   finish function and dlclose, and end the test                     19oct26
+---------------------------------------------------------------------------*/
+static void reject_plugin ( struct CTRL *ctrl, void *state )
+{
+  if ( ctrl->finish )  (*ctrl->finish)( state );
+  dlclose ( ctrl->dl );
+  ctrl->dl = NULL;
+  good_bye ( 0,0,0 );
+}
 
-#endif  // CONTROL 
-*/
 
+/* LOAD_PLUGIN - load a controller plug-in, check its interface, call its
+   init function, and allocate the controller input and output arrays
+                                                                     19oct26
+---------------------------------------------------------------------------*/
+int load_plugin ( char *pluginFilename, unsigned nChnl, float sr,
+                  struct CTRL *ctrl )
+{
+  struct HPG_PLUGIN_INFO  info;
+  HPG_PLUGIN_INIT  init;
+  char   fdPath[32];
+  int   *abi, i, fd;
+
+  // HPGdaac is setuid root ... load only a file no one but root can replace
+  if ( (fd = open_plugin ( pluginFilename )) < 0 ) {
+    errorMsg("  load_plugin: the plug-in and its directory must be owned by root, and not writable by group or others" );
+    fprintf(stderr,"  '%s'\n", pluginFilename );
+    good_bye ( 0,0,0 );
+  }
 
+  snprintf ( fdPath, sizeof(fdPath), "/proc/self/fd/%d", fd );
+  ctrl->dl = dlopen ( fdPath, RTLD_NOW | RTLD_LOCAL );   // the file checked
+  close ( fd );
+  if ( ctrl->dl == NULL ) {
+    errorMsg("  load_plugin: cannot load the controller plug-in" );
+    fprintf(stderr,"  %s\n", dlerror() );
+    good_bye ( 0,0,0 );
+  }
 
-/* STATE_DERIV  -  calculate the state derivitive of a LTI system    17jul01
-    dx/dt = A x + B y
------------------------------------------------------------------------------*/
-void state_deriv ( float *y, float *xc, float *dxcdt )
-{
-  int i,j;
+  abi          = (int *) dlsym ( ctrl->dl, "hpg_plugin_abi" );
+  init         = (HPG_PLUGIN_INIT)   dlsym ( ctrl->dl, "hpg_init" );
+  ctrl->step   = (HPG_PLUGIN_STEP)   dlsym ( ctrl->dl, "hpg_step" );
+  ctrl->finish = (HPG_PLUGIN_FINISH) dlsym ( ctrl->dl, "hpg_finish" );
+  if ( !abi || *abi != HPG_PLUGIN_ABI || !init || !ctrl->step ) {
+    errorMsg("  load_plugin: the plug-in does not have the HPGplugin.h interface" );
+    fprintf(stderr,"  hpg_plugin_abi = %d (need %d), hpg_init %s, hpg_step %s\n",
+             abi ? *abi : -1, HPG_PLUGIN_ABI, init ? "ok" : "missing",
+             ctrl->step ? "ok" : "missing" );
+    dlclose ( ctrl->dl );
+    good_bye ( 0,0,0 );
+  }
 
-  for (i=1; i<=_N; i++) {
-    dxcdt[i] = 0.0;
-    for (j=1; j<=_N; j++)  dxcdt[i] += Ac[i][j]*xc[j];
-       for (j=1; j<=_L; j++)  dxcdt[i] += Bc[i][j]*y[j];
+  memset ( &info, 0, sizeof(info) );
+  info.abi   = HPG_PLUGIN_ABI;
+  info.nChnl = nChnl;
+  info.dt    = 1.0/sr;
+  info.uMax  = DA_VREF;
+  strncpy ( info.title, pluginFilename, MAXL-1 );
+
+  if ( (*init)( &info ) != 0 ) {
+    errorMsg("  load_plugin: the plug-in init function failed" );
+    dlclose ( ctrl->dl );
+    good_bye ( 0,0,0 );
   }
 
-  return;
+  if ( info.nIn < 1 || info.nIn > nChnl || info.nIn > HPG_PLUGIN_MAXIO ||
+       info.nOut < 1 || info.nOut > CTRL_MAX_M ) {
+    errorMsg("  load_plugin: plug-in inputs or outputs out of range.");
+    fprintf(stderr,"  1 <= inputs <= %d,  1 <= outputs <= %d \n",
+                    nChnl, CTRL_MAX_M );
+    reject_plugin ( ctrl, info.state );
+  }
+
+  strncpy ( ctrl->title, info.title, MAXL-1 );
+  ctrl->N = 0;
+  ctrl->L = info.nIn;
+  ctrl->M = info.nOut;
+  for (i=0; i<ctrl->L; i++)  ctrl->inChnl[i] = info.inChnl[i];
+  for (i=0; i<ctrl->M; i++)  ctrl->outDA[i]  = info.outDA[i];
+  ctrl->uMin  = MAX ( info.uMin, 0.0 );
+  ctrl->uMax  = info.uMax < DA_VREF ? info.uMax : DA_VREF;
+  ctrl->state = info.state;
+  ctrl->budget_ns    = 1e3 * ( info.budget_us > 0 ? info.budget_us : 0.25e6/sr );
+  ctrl->overrunLimit = info.overrunLimit > 0 ? info.overrunLimit : 10;
+  ctrl->overrunRun = ctrl->stopped = 0;
+  ctrl->overruns = ctrl->nonFinite = 0;
+  latency_init ( &ctrl->latStep, "plug-in step" );
+
+  for (i=0; i<ctrl->L; i++)
+    if ( ctrl->inChnl[i] < 0 || ctrl->inChnl[i] >= nChnl ) {
+      errorMsg("  load_plugin: input channel out of range.");
+      reject_plugin ( ctrl, info.state );
+    }
+  for (i=0; i<ctrl->M; i++)
+    if ( ctrl->outDA[i] < 0 || ctrl->outDA[i] > 1 ||
+         ( i > 0 && ctrl->outDA[i] == ctrl->outDA[0] ) ) {
+      errorMsg("  load_plugin: output D/A channels must be 0 or 1, and distinct.");
+      reject_plugin ( ctrl, info.state );
+    }
+
+  // the same storage as a state space controller, with N = 0
+  ctrl->G = vector ( 0, ctrl->M*ctrl->L + ctrl->L + ctrl->M - 1 );
+  ctrl->z = ctrl->G + ctrl->M*ctrl->L;
+  ctrl->w = ctrl->z + ctrl->L;
+  for (i=0; i < ctrl->M*ctrl->L + ctrl->L + ctrl->M; i++)  ctrl->G[i] = 0.0;
+
+  color(0); color(1); color(32);
+  fprintf(stderr,"\n %s\n", ctrl->title );
+  fprintf(stderr," plug-in %s: %d inputs (chnl", pluginFilename, ctrl->L );
+  for (i=0; i<ctrl->L; i++)  fprintf(stderr," %d", ctrl->inChnl[i] );
+  fprintf(stderr,"), %d outputs (D/A", ctrl->M );
+  for (i=0; i<ctrl->M; i++)  fprintf(stderr," %d", ctrl->outDA[i] );
+  fprintf(stderr,"), %.3f V to %.3f V, budget %.1f us\n\n",
+                  ctrl->uMin, ctrl->uMax, ctrl->budget_ns/1e3 );
+  color(0); color(1); color(36);
+
+  return(0);
 }
 
 
-/* RK4  -  4th Order Runge-Kutta, ``Numerical Recipes In C,'' 17julyo1
+/* CONTROL_SETUP - input scale factors from the pre-test statistics, and
+   zero initial controller states                                    19oct26
+   y = ( adScan - bias ) * range / ADMAX / sensitivity
 ---------------------------------------------------------------------------*/
-void rk4 ( float *y, float *dydx, int n, float h, float vi, float *yout, 
-  void (*derivs)() )
+void control_setup ( struct CTRL *ctrl, struct CHNL chnl[], uint8_t rangeCode[] )
 {
-  int  i;
-  float  hh, h6, *dym, *dyt, *yt;
-
-  dym = vector(1,n);
-  dyt = vector(1,n);
-  yt  = vector(1,n);
+  int  i, chn;
 
-  hh = h/2.0;
-  h6 = h/6.0;
+  for (i=0; i<ctrl->L; i++) {
+    chn = ctrl->inChnl[i];
+    ctrl->inBias[i] = chnl[chn].bias;
+    ctrl->inGain[i] = ADS1256_range_value(rangeCode[chn]) / ADMAX / chnl[chn].sensi;
+  }
+  for (i=0; i < ctrl->N + ctrl->L; i++)  ctrl->z[i] = 0.0;
+  for (i=0; i < ctrl->N + ctrl->M; i++)  ctrl->w[i] = 0.0;
 
-  for(i=1;i<=n;i++)
-    yt[i] = y[i]+hh*dydx[i];
+  return;
+}
 
-  (*derivs)(vi,yt,dyt);
-  for(i=1;i<=n;i++)
-    yt[i] = y[i]+hh*dyt[i];
 
-  (*derivs)(vi,yt,dym);
-  for(i=1;i<=n;i++) {
-    yt[i] = y[i]+h*dym[i];
-    dym[i] += dyt[i];
+/* CONTROL_STEP - evaluate the controller for one scan                19oct26
+   [ x(k+1) ; u(k) ] = [ A B ; C D ] [ x(k) ; y(k) ]
+   The cost is (N+M)*(N+L) multiply-adds every scan, with no branches on the
+   data and no memory allocation.
+   A plug-in step is timed against its budget; after overrunLimit
+   consecutive overruns the plug-in is stopped and its D/A outputs are
+   zero volts, even if uMin is higher, as are outputs that are not finite.
+---------------------------------------------------------------------------*/
+void control_step ( struct CTRL *ctrl, int32_t adScan[], uint32_t scan,
+                    uint16_t daOut[] )
+{
+  const int  N = ctrl->N,  L = ctrl->L,  M = ctrl->M,  nz = N+L;
+  const float *g = ctrl->G;
+  float     *z = ctrl->z,  *w = ctrl->w,  s, u;
+  int        i, j;
+  int64_t    ns;
+  struct timespec  t0, t1;
+
+  for (j=0; j<L; j++)                       // scaled controller inputs
+    z[N+j] = ( adScan[ctrl->inChnl[j]] - ctrl->inBias[j] ) * ctrl->inGain[j];
+
+  if ( ctrl->dl ) {                         // controller plug-in
+    if ( ctrl->stopped ) {
+      for (i=0; i<M; i++)  w[i] = NAN;      // zero volts, below
+    } else {
+      clock_gettime ( CLOCK_MONOTONIC, &t0 );
+      (*ctrl->step)( z, w, ctrlCnst, scan, ctrl->state );
+      clock_gettime ( CLOCK_MONOTONIC, &t1 );
+      latency_add ( &ctrl->latStep, ns = latency_ns ( &t0, &t1 ) );
+      if ( ns > ctrl->budget_ns ) {
+        ++ctrl->overruns;
+        if ( ++ctrl->overrunRun >= ctrl->overrunLimit )  ctrl->stopped = 1;
+      } else  ctrl->overrunRun = 0;
+      for (i=0; i<M; i++)
+        if ( !isfinite ( w[i] ) )  ++ctrl->nonFinite;
+    }
+  } else {                                  // state space controller
+    for (i=0; i < N+M; i++, g += nz) {      // one pass through G
+      s = 0.0;
+      for (j=0; j<nz; j++)  s += g[j] * z[j];
+      w[i] = s;
+    }
+    for (i=0; i<N; i++)  z[i] = w[i];       // x(k) <- x(k+1)
   }
 
-  (*derivs)(vi,yt,dyt);
-  for(i=1;i<=n;i++)
-    yout[i] = y[i]+h6*(dydx[i]+dyt[i]+2.0*dym[i]);
+  for (i=0; i<M; i++) {                     // limit and convert u to D/A
+    u = w[N+i];
+    if ( !isfinite ( u ) ) { daOut[i] = 0;  continue; }  // zero volts
+    if ( u < ctrl->uMin )  u = ctrl->uMin;
+    if ( u > ctrl->uMax )  u = ctrl->uMax;
+    daOut[i] = (uint16_t) ( u / DA_VREF * DA_HI + 0.5 );
+  }
 
-  free_vector(yt,1,n);
-  free_vector(dyt,1,n);
-  free_vector(dym,1,n);
   return;
 }
 
 
-/* C2D - convert Continuous time dynamics to Discrete time dynamics
------------------------------------------------------------------------------*/
-// c2d
-/*
-  Ak = A;
-  k_factorial = 1;
+/* PRINT_CONTROLLER - display the controller matrices                19oct26
+---------------------------------------------------------------------------*/
+void print_controller ( struct CTRL *ctrl )
+{
+  int  i, j, nz = ctrl->N + ctrl->L;
+
+  color(0); color(1); color(32);
+  fprintf(stderr,"\n %s\n", ctrl->title );
+  fprintf(stderr," %d states, %d inputs (chnl", ctrl->N, ctrl->L );
+  for (i=0; i<ctrl->L; i++)  fprintf(stderr," %d", ctrl->inChnl[i] );
+  fprintf(stderr,"), %d outputs (D/A", ctrl->M );
+  for (i=0; i<ctrl->M; i++)  fprintf(stderr," %d", ctrl->outDA[i] );
+  fprintf(stderr,"), %.3f V to %.3f V\n", ctrl->uMin, ctrl->uMax );
+
+  for (i=0; i < ctrl->N + ctrl->M; i++) {
+    color(32); fprintf(stderr, i < ctrl->N ? " A:" : " C:" );
+    color(36);
+    for (j=0; j<ctrl->N; j++)  fprintf(stderr," %10.3e ", ctrl->G[i*nz+j] );
+    color(32); fprintf(stderr, i < ctrl->N ? " B:" : " D:" );
+    color(36);
+    for (j=ctrl->N; j<nz; j++)  fprintf(stderr," %10.3e ", ctrl->G[i*nz+j] );
+    fprintf(stderr,"\n");
+  }
+  fprintf(stderr,"\n");
+  color(0); color(1); color(36);
+
+  return;
+}
 
-  max_iter = 100;
-  tolerance = 1e-6;
 
- for k = 1:max_iter
+/* CONTROL_REPORT - display the plug-in step times and overruns      19oct26
+---------------------------------------------------------------------------*/
+void control_report ( struct CTRL *ctrl )
+{
+  if ( !ctrl->dl )  return;
+
+  latency_report ( &ctrl->latStep );
+  color(0); color(1);
+  color( ctrl->overruns ? 31 : 32 );
+  fprintf(stderr,"   %u steps over the %.1f us budget", ctrl->overruns,
+                  ctrl->budget_ns/1e3 );
+  if ( ctrl->nonFinite )
+    fprintf(stderr,", %u outputs not finite", ctrl->nonFinite );
+  fprintf(stderr,"\n");
+  if ( ctrl->stopped )
+    fprintf(stderr,"   the plug-in was stopped after %d consecutive overruns\n",
+                    ctrl->overrunLimit );
+  color(0); color(1); color(36);
 
-    expmA = expmA + Ak/k_factorial;
+  return;
+}
 
-    if all( abs(Ak(find(expmA~=0))) ./ abs(expmA(find(expmA~=0)))/k_factorial < tolerance )
-  break;
-    end
-    
-    Ak = Ak*A;
-    k_factorial = k_factorial*(k+1);
- end
-  
 
-    7 June 2007
+/* FREE_CONTROLLER - de-allocate the controller storage, and release a
+   controller plug-in                                                19oct26
 ---------------------------------------------------------------------------*/
+void free_controller ( struct CTRL *ctrl )
+{
+  int  nz = ctrl->N + ctrl->L,  nw = ctrl->N + ctrl->M;
 
+  if ( ctrl->G )  free_vector ( ctrl->G, 0, nw*nz + nz + nw - 1 );
+  ctrl->G = ctrl->z = ctrl->w = NULL;
 
-/* SGN - return the sign of x    28 Oct 03
------------------------------------------------------------------------------*/
-float  sgn( float x )
-{
-  if (x > 0.0)  return  1.0 ;
-  if (x < 0.0)  return -1.0 ;
-  if (x == 0.0)  return  0.0 ;
-  return(0.0);
-}
+  if ( ctrl->dl ) {
+    if ( ctrl->finish )  (*ctrl->finish)( ctrl->state );
+    dlclose ( ctrl->dl );
+    ctrl->dl = NULL;
+  }
 
-#endif
+  return;
+}
@@ -5,47 +5,92 @@
  *
  *    Description:  header file for HPGcontrol.c
  *
- *         Author:  Henri P. Gavin 
+ *         Author:  Henri P. Gavin
  *
  * ==========================================================================
  */
 
-#define CONTROL      0   /* perform realtime control computation         */
-#define CONTROL_DA0  0   /* online processing for analog output 0        */
-#define CONTROL_DA1  0   /* online processing for analog output 1        */
-#define RT_CHN_1     1   /* an input channel for realtime processing     */
-#define RT_CHN_2     2   /* an input channel for realtime processing     */
-#define RT_CHN_3     3   /* an input channel for realtime processing     */
+#ifndef _HPGCONTROL_H_
+#define _HPGCONTROL_H_
 
-#define _N           2   /* number of dynamic states in controller       */
-#define _L           2   /* number of controller inputs                  */
-#define _M           1   /* number of controller outputs                 */
+#include <stdint.h>
+#include "HPGdaac.h"         // struct CHNL, MAXL, NUMCHNL
+#include "HPGplugin.h"       // controller plug-in interface
+#include "HPGlatency.h"      // plug-in step time histogram
+
+#define CTRL_MAX_N  64       /* maximum number of controller states          */
+#define CTRL_MAX_M   2       /* maximum number of controller outputs (D/A's) */
 
 #define MAX(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a > _b ? _a : _b; })
 
-#if CONTROL
+/*
+ * A discrete time state space controller, loaded from a controller file
+ *
+ *   x(k+1) = A x(k) + B y(k)      ... controller dynamics
+ *   u(k)   = C x(k) + D y(k)      ... controller output equation
+ *
+ * The four matrices are stored together, row-major, in one contiguous
+ * (N+M) x (N+L) block  G = [ A B ; C D ],  acting on  z = [ x ; y ]
+ * so that one pass through G gives both  x(k+1)  and  u(k).
+ *
+ * A controller plug-in (HPGplugin.h) has no states (N = 0) and no matrices;
+ * its step function maps the scaled inputs z = y to the outputs w = u.
+ */
+  struct CTRL {
+         char   title[MAXL];       // controller description
+         int    N, L, M;           // number of states, inputs, and outputs
+         int    inChnl[NUMCHNL];   // A/D channel of each controller input
+         int    outDA[CTRL_MAX_M]; // D/A channel of each controller output
+         float  uMin, uMax;        // output voltage limits
+         float  inGain[NUMCHNL];   // input scale factor, A/D LSB to sensor units
+         float  inBias[NUMCHNL];   // input offset, A/D LSB
+         float *G;                 // (N+M) x (N+L) matrix [ A B ; C D ]
+         float *z;                 // N+L vector [ x(k)   ; y(k) ]
+         float *w;                 // N+M vector [ x(k+1) ; u(k) ]
+
+         void  *dl;                // plug-in shared object, NULL if none
+         HPG_PLUGIN_STEP   step;   // plug-in step function
+         HPG_PLUGIN_FINISH finish; // plug-in finish function, or NULL
+         void  *state;             // plug-in state
+         int64_t  budget_ns;       // plug-in step time budget
+         int      overrunLimit;    // consecutive overruns before stopping
+         int      overrunRun;      // current number of consecutive overruns
+         uint32_t overruns;        // total number of overruns
+         uint32_t nonFinite;       // number of outputs that were not finite
+         int      stopped;         // 1: plug-in stopped for overrunning
+         struct LATENCY latStep;   // plug-in step time histogram
+      };
 
-/* compute state matrices      */
-void state_matrices ( float *xc, float *xc1, float *dxcdt, float *y,
-        float *constants, float csr );
+/* read a controller file and allocate the controller */
+int  read_controller ( char *ctrlFilename,
+                       unsigned nChnl,
+                       float sr,
+                       struct CTRL *ctrl );
 
-/* continuous time to discrete time */
-void c2d ( float **Ac, float **Bc, float csr );
+/* input scaling from the pre-test statistics, zero the controller state */
+void control_setup ( struct CTRL *ctrl,
+                     struct CHNL chnl[],
+                     uint8_t rangeCode[] );
 
-/* compute state derivative    */
-void state_deriv ( float *y, float *xc, float *dxcdt );
+/* load a controller plug-in, called by read_controller for a .so file */
+int  load_plugin ( char *pluginFilename,
+                   unsigned nChnl,
+                   float sr,
+                   struct CTRL *ctrl );
 
-/* 4th Order Runge-Kutta Method */
-void rk4 ( float *y, float *dydx, int n, float h, float vi, float *yout,
-	void (*derivs)() );
+/* one controller time step: scan in, D/A values out */
+void control_step ( struct CTRL *ctrl,
+                    int32_t adScan[],
+                    uint32_t scan,
+                    uint16_t daOut[] );
 
-/* simulate discrete time systm */
-void DT_sim ( float *xc1, float *xc, float *y );
+/* display the plug-in step times and overruns after the test */
+void control_report ( struct CTRL *ctrl );
 
-/* control rule                 */
-void control_rule ( float V_out, float *xc1, float *y, float *constants );
+/* print the controller matrices */
+void print_controller ( struct CTRL *ctrl );
 
-/* sign of a value */
-float   sgn( float x );
+/* de-allocate controller memory */
+void free_controller ( struct CTRL *ctrl );
 
-#endif
+#endif // _HPGCONTROL_H_
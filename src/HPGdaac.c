@@ -22,6 +22,13 @@ Constant Description n                     :
 D/A 0 data file name                       : optional e.g., DA-files/chirp0.dat
 D/A 1 data file name                       : optional e.g., DA-files/chirp1.dat
 
+Optional lines may follow the D/A file names, recognized by the first word
+of their label; HPGdaac lists them when it cannot open the configuration
+file.  The features they set are described in HPGcontrol.c, HPGlatency.c,
+HPGplot.c, HPGstream.h, HPGshm.h, HPGcal.c, HPGsched.c, HPGskew.c,
+HPGchar.c, HPGplan.c, HPGstore.c, HPGarena.c, and, for the converters
+on the bus, HPADDAlib.h.  The state of a test is struct ACQ, in HPGdaac.h.
+
 
     ---- SENSITIVITY  DATA  FILE  FORMAT ----  
 
@@ -40,13 +47,23 @@ Channel    Label       Sensitivity  V/Unit  Smoothing    Detrend
 to compile:   make clean; make; sudo make install
 
 to run:   sudo HPGdaac test.cfg data.out
-Channel-to-channel skew is ??  micro-sec 
+
+or, with the board kept ready between tests by the hpgdaacd daemon,
+          sudo HPGdaac -d &                  (or hpgdaacd, a link to HPGdaac)
+          HPGdaac -r test1.cfg data1.out test2.cfg data2.out ...
+
+to characterize the noise, resolution, scan period, and skew of the board
+over the data rates and gains, on the channels of a configuration,
+          sudo HPGdaac -c test.cfg perf.tbl [reference.tbl]
+Channel-to-channel skew is measured in each test, see the data file header
 (c) H.P. Gavin, Dept. of Civil Engineering, Duke University, 
 2018-08-23 , 2022-01-31 , 2022-10-14, 2023-03-06
 *******************************************************************************/
 
 #include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // abs
 #include <string.h>         // standard string handling library
+#include <strings.h>        // strcasecmp
 #include <math.h>           // standard mathematics library
 #include <signal.h>         // interrupt routines
 #include <unistd.h>         // ualarm 
@@ -55,60 +72,109 @@ Channel-to-channel skew is ??  micro-sec
 #include "../../HPGnumlib/NRutil.h"   // memory allocation routines
 #include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
 #include "HPGcontrol.h"               // HPG feedback control functions
+#include "HPGlatency.h"               // control path latency histograms
+#include "HPGstream.h"                // live data export over a socket
+#include "HPGshm.h"                   // live data ring in shared memory
+#include "HPGdaemon.h"                // hpgdaacd, the resident HPGdaac
+#include "HPGcal.h"                   // ADS1256 self-calibration cache
+#include "HPGsched.h"                 // multi-rate scan schedule
+#include "HPGskew.h"                  // channel-to-channel skew, alignment
+#include "HPGchar.h"                  // noise and skew characterization
+#include "HPGplan.h"                  // timing plan of the scans
+#include "HPGstore.h"                 // blocks of packed samples
+#include "HPGarena.h"                 // locked buffers of the test
 #include "HPGdaac.h"                  // header file for HPGdaac
 
 //prevent memory swapping ... from bcm2835.h
 //nclude <sched.h>
 //nclude <sys/mman.h>
 
-#define GRAPHICS     1      /* 1: use realtime graphics ; 0: don't          */
+#define GRAPHICS     1      /* 1: compile realtime graphics ; 0: don't      */
 
 #if GRAPHICS
 #include <xcb/xcb.h>
 #include "../../HPGxcblib/HPGxcb.h" // HPG xcb gracphics functions
+#include "HPGplot.h"                // real time plotting
 #endif  // GRAPHICS
 
 // external declarations ...
 FILE      *fp;              // pointer to the output file of measured DA data
 
- int32_t  *adData,          // A-to-D data, all in one vector   0 to +16777215
-           adScan[NUMCHNL]; // A-to-D data in a single scan     0 to +16777215
-
-uint16_t  *da0Data,         // D-to-A data,  channel 0,    -32767 to    +32768
-          *da1Data;         // D-to-A data,  channel 1,    -32767 to    +32768
+struct ACQ   acq;           // the converters, scan list, A-to-D and D-to-A data
+struct ARENA arena;         // the buffers of the test, locked, pre-faulted
+struct ADS1256 adsBus[ACQ_MAXAD-1]; // the other ADS1256 on the bus, Pins line
 
-uint32_t   smpl = 0,        // current sample number 
-           scan = 1;        // current scan   number
-
- uint8_t   muxCode[8]; 
   int      da0=0, da1=0;    // flags indicating D-to-A  
 
-  unsigned chn, nChnl=8,    // number of channels
+  unsigned chn,             // a channel number
            scn, nScan,      // total number of channel scans
            spl, nSmpl;      // total number of samples
 
   float    sr    = 100.0;   // scan rate in scans per second
 
   float    voltRange = 5.0; // unipolar voltage measurement range
-  uint8_t  rangeCode[8] = {0, 0, 0, 0, 0, 0, 0, 0}; // voltage range codes
 
   struct CHNL chnl[NUMCHNL];     // allocate memory to the array of structures
 
   struct CTRLCNST ctrlCnst[16];  // allocate memory to the array of structures
 
+  struct OPTIONS  opts;          // optional configuration settings
+
+  struct CTRL ctrl;              // state space or plug-in feedback controller
+  int      control = 0,          // 1: feedback control ; 0: don't
+           ctrlDA[2] = {0, 0};   // D/A channels driven by the controller
+  int      loopback = 0;         // 1: loopback latency test ; 0: don't
+
+#define LOOP_PERIOD  10          /* scans between loopback D/A steps         */
+#define LOOP_TRIES   20          /* A/D conversions to find a loopback step  */
+
 
+  int      graphics = 0;           // 1: plot in real time ; 0: headless
+  int      testOK = 0;             // 1: the test ran to completion
 #if GRAPHICS
   float    xu=0, xo=0,             // x axis unit, place, offsets
            yu=0, yo=0;             // y axis unit, place, offsets
-  static uint32_t CHNL_COLR[8] = {0xffffff, 0xff9205, 0x02ce2a, 0x02c3c4, 0x2201c4, 0xe0ee02, 0xce02c7, 0xf2031d};  // bruel+kjaer
 #endif // GRAPHICS
 
-#if CONTROL
-float    **Ac, **Bc, **Cc, **Dc;   // L.T.I. state space controller 
-#endif // CONTROL
-
 
+/* MAIN - run one test, or start or call the hpgdaacd daemon        19oct26
+------------------------------------------------------------------------------*/
 int main (int argc, char *argv[])
+{
+  char  *name = strrchr ( argv[0], '/' ),
+        *sockPath = HPGD_SOCKET;
+  int    arg = 2;
+
+  name = name ? name+1 : argv[0];
+
+  if ( strcmp ( name, "hpgdaacd" ) == 0 ||
+       ( argc > 1 && strcmp ( argv[1], "-d" ) == 0 ) ) {  // daemon
+    if ( strcmp ( name, "hpgdaacd" ) == 0 )  arg = 1;
+    if ( argc > arg )  sockPath = argv[arg];
+    exit ( daemon_serve ( sockPath ) );
+  }
+
+  if ( argc > 1 && strcmp ( argv[1], "-r" ) == 0 ) {       // client
+    if ( argc > 3 && strcmp ( argv[2], "-s" ) == 0 ) {
+      sockPath = argv[3];
+      arg = 4;
+    }
+    exit ( daemon_client ( sockPath, argc-arg, argv+arg ) );
+  }
+
+  if ( argc > 1 && strcmp ( argv[1], "-c" ) == 0 )         // characterize
+    exit ( characterize ( argc-1, argv+1 ) ? 1 : 0 );
+
+  run_test ( argc, argv );
+  exit(0);
+}
+
+
+/* RUN_TEST - configure, acquire, control, plot, and save one test     19oct26
+   In hpgdaacd the board is already initialized, and the test neither
+   plots nor waits for the operator.
+------------------------------------------------------------------------------*/
+int run_test (int argc, char *argv[])
 {
 
 /* ----------------------- declare variables --------------------------- */
@@ -126,13 +192,6 @@ int main (int argc, char *argv[])
   float    dtime =  20.0,          // number of seconds  spent collecting
            memory;                 // RAM memory allowed for data
 
-#if CONTROL
-  float   *xc, *xc1,                 // controller state vector
-          *dxcdt,                    // controller state vector derivative
-          *y,                        // controller input vector
-           vOut = 0.0;               // output voltage from control rule
-#endif // CONTROL
-
   int      integChnl = -1,           // channel to integrate
            diffrChnl = -1;           // channel to differentiate
 
@@ -140,75 +199,170 @@ int main (int argc, char *argv[])
            pause_us = 0;           // microseceonds from scan stop to scan start
 
   float    drate = 2000.0;         // digitization rate in samples per second
+  unsigned convPerScan = 0;        // conversion periods per scan, DRDY pacing
+  struct PLAN plan;                // the time of each scan
 
   time_t   startTime;              // acquisition starting time  
+  long     minFlt0, majFlt0,       // page faults before the test
+           minFlt1, majFlt1;       // ... and after it
 
 /* ----------------------------------------------------------------------- */
 
-#if CONTROL
-// allocate memory for state-variable matrices
-  xc    = vector(1,_N);      // allocate controller state vector
-  xc1   = vector(1,_N);      // allocate controller state vector
-  dxcdt = vector(1,_N);      // allocate controller state derivative
-  y     = vector(1,_L);      // allocate  plant output vector
-  Ac    = matrix(1,_N,1,_N); // allocate controller dynamics matrix
-  Bc    = matrix(1,_N,1,_L); // allocate controller input matrix
-  Cc    = matrix(1,_M,1,_N); // allocate controller input matrix
-  Dc    = matrix(1,_M,1,_L); // allocate controller input matrix
-#endif  // CONTROL 
- 
 /*prevent memory swapping ... from bcm2835.h
   struct sched_param sp;
   memset(&sp, 0, sizeof(sp));
   sp.sched_priority = sched_get_priority_max(SCHED_FIFO);
   sched_setscheduler(0, SCHED_FIFO, &sp);
-  mlockall(MCL_CURRENT | MCL_FUTURE);
+... the buffers of the test are locked in the arena, HPGarena.c
 */
 
   read_configuration( argc, argv, title, &dtime, &sr, &drate, 
-                  &nChnl, muxCode, rangeCode, chnlDesc, chnl, 
-                  &da0, &da1, da0fn, da1fn, sensiFilename, ctrlCnst );
+                  &acq.nChnl, acq.muxCode, acq.rangeCode, chnlDesc, chnl, 
+                  &da0, &da1, da0fn, da1fn, sensiFilename, ctrlCnst, &opts );
+  if ( daemon_running() )  opts.graphics = 0;      // hpgdaacd plots nothing
 
-  read_sensitivity( argv, sensiFilename, nChnl, 
+  read_sensitivity( argv, sensiFilename, acq.nChnl, 
                    xLabel, yLabel, chnl, &integChnl, &diffrChnl);
 
   nScan    = (unsigned)(dtime * sr);               // total # channel scans
-  nSmpl    = (unsigned)(nChnl * nScan);            // total # A-to-D samples 
+  nSmpl    = (unsigned)(acq.nChnl * nScan);        // total # A-to-D samples 
   delta_us = (uint64_t)(1.0e6/sr);                 // time step  us
-  pause_us = (uint64_t)(1.0e6*(1.0/sr - (double)nChnl/drate)); // time pause us
 
-  memory = 20e6;
-  if ( nScan*(nChnl+da0+da1) > memory ) {   // RAM limit on PC, (ha!) 
+  memory = 80e6;                                   // bytes
+  if ( store_bytes ( acq.nChnl, nScan, opts.packed ) +
+       2*(float)nScan*(float)(da0+da1) > memory ) {   // RAM limit on PC, (ha!) 
       errorMsg ("Requested memory exceeds the allowed RAM buffer capacity." );
       fprintf(stderr,"  %.0f bytes were requested",
-                             2*(float)nScan*(float)(nChnl+da0+da1) );
-      fprintf(stderr,", but only %.0f bytes are available.", 2*memory );
+                 store_bytes ( acq.nChnl, nScan, opts.packed ) +
+                 2*(float)nScan*(float)(da0+da1) );
+      fprintf(stderr,", but only %.0f bytes are available.", memory );
       good_bye ( 0,da0,da1 );
   }
 
-#if CONTROL 
-  // define L.T.I. system dynamics
-  state_matrices(xc,xc1, dxcdt, y, constants, sr );
-#endif  // CONTROL 
- 
-  if (da0 || CONTROL_DA0) da0Data = u16vector(1,nScan);  // DtoA 0 
-  if (da1 || CONTROL_DA1) da1Data = u16vector(1,nScan);  // DtoA 1
+  if ( opts.ctrlFilename[0] ) {                    // feedback controller 
+    read_controller ( opts.ctrlFilename, acq.nChnl, sr, &ctrl );
+    control = 1;
+    for (chn = 0; chn < ctrl.M; chn++)  ctrlDA[ctrl.outDA[chn]] = 1;
+    if ( (da0 && ctrlDA[0]) || (da1 && ctrlDA[1]) ) {
+      errorMsg("  A D/A channel can not have both a D/A file and a controller.");
+      good_bye ( 0,0,0 );
+    }
+  }
+
+  acq.nAd = opts.nCnv;                             // the ADS1256 on the bus
+  for (chn = 0; chn < acq.nChnl; chn++) {
+    if ( opts.cnv[chn] >= acq.nAd ) {
+      errorMsg("  A channel is on a converter without pins on the Pins line.");
+      good_bye ( 0,0,0 );
+    }
+    acq.cnv[chn] = opts.cnv[chn];
+  }
+
+  if ( opts.loopDA >= 0 ) {                        // loopback latency test
+    if ( opts.loopDA > 1 || opts.loopChnl < 0 || opts.loopChnl >= acq.nChnl ||
+         (da0 && opts.loopDA==0) || (da1 && opts.loopDA==1) || ctrlDA[opts.loopDA] ) {
+      errorMsg("  The loopback D/A must be 0 or 1 and not otherwise in use, and the A/D channel must be scanned.");
+      good_bye ( 0,0,0 );
+    }
+    loopback = 1;
+    ctrlDA[opts.loopDA] = 1;
+  }
+
+  // the control channels are converted first in every scan
+  acq.nFirst = set_scan_order ( acq.nChnl, acq.muxCode, acq.rangeCode,
+                                opts.convAvg, acq.cnv, drate,
+                                opts.calMode != CAL_OFF,
+                                acq.scanOrder, acq.muxOrder, acq.rangeOrder );
+
+  for (chn = 0; chn < acq.nChnl; chn++) {
+    acq.avgOrder[chn] = opts.convAvg[acq.scanOrder[chn]];
+    acq.cnvOrder[chn] = acq.cnv[acq.scanOrder[chn]];
+  }
+
+  // slow channels spread over the scans, by their rate divisors
+  if ( sched_build ( &acq.sched, acq.nChnl, opts.rateDiv, opts.convAvg, acq.cnv,
+                     acq.nFirst, acq.scanOrder, acq.muxOrder, acq.rangeOrder ) )
+    good_bye ( 0,0,0 );
+
+  // the time of a scan, checked against the scan period, before the test
+  if ( plan_test ( &plan, opts.plan, sr, drate, &acq.sched, acq.nFirst,
+                   acq.muxOrder, acq.rangeOrder, acq.avgOrder, acq.cnvOrder,
+                   opts.calMode != CAL_OFF,
+                   control ? &ctrl : NULL,
+                   ( control ? ctrl.M : 0 ) + da0 + da1 + loopback,
+                   loopback ? LOOP_TRIES : 0 ) ) {
+    plan_report ( &plan );
+    errorMsg("  The scans do not fit in the scan period.  Lower the scan rate or raise the digitization rate.");
+    fprintf(stderr,"  The highest safe scan rate is %.1f scans per second.\n", plan.maxSr );
+    good_bye ( 0,0,0 );
+  }
+  plan_report ( &plan );
+  drate = plan.drate;
+  pause_us = (uint64_t) MAX ( 0.0, plan.headroom_us );       // time pause us
+  latency_init ( &acq.latAdDa,   "control A/D to D/A" );
+  latency_init ( &acq.latScanDa, "scan start to D/A" );
+  latency_init ( &acq.latLoop,   "loopback D/A to A/D" );
+
+  // every buffer of the test in one arena, locked and pre-faulted
+  if ( arena_open ( &arena, store_bytes ( acq.nChnl, nScan, opts.packed ) +
+                    sched_bytes ( &acq.sched, nScan ) +
+                    skew_bytes ( opts.align, acq.nChnl, nScan ) +
+                    ( (da0 || ctrlDA[0]) + (da1 || ctrlDA[1]) ) *
+                    ARENA_ROUND ( (nScan+1) * sizeof(uint16_t) ), opts.huge ) )
+    good_bye ( 0,da0,da1 );
+  acq.daData[0] = acq.daData[1] = NULL;
+  if (da0 || ctrlDA[0])                                // DtoA 0, 1 to nScan
+    acq.daData[0] = (uint16_t *) arena_alloc ( &arena, (nScan+1) * sizeof(uint16_t) );
+  if (da1 || ctrlDA[1])                                // DtoA 1, 1 to nScan
+    acq.daData[1] = (uint16_t *) arena_alloc ( &arena, (nScan+1) * sizeof(uint16_t) );
+  for (scn = 1; scn <= nScan; scn++) {                 // controller D/A's
+    if (ctrlDA[0]) acq.daData[0][scn] = DA_00;
+    if (ctrlDA[1]) acq.daData[1][scn] = DA_00;
+  }
 
-  adData = i32vector( 0, nSmpl );             // allocate A-to-D memory
-  for (smpl=0; smpl<=nSmpl; smpl++)           // set all samples to 0x0
-    adData[smpl] = 0x00000000; 
-  smpl = 0;
+  if ( store_alloc ( &acq.adData, acq.nChnl, nScan, opts.packed, &arena ) ||
+       sched_alloc ( &acq.sched, nScan, &arena ) )  // A-to-D, rate groups
+    good_bye ( 0,da0,da1 );
+  acq.smpl = 0;
 
   // read digital-to-analog data files ---------------------------------
-  if (da0) read_da_file ( da0, da0fn, nScan, da0Data );
-  if (da1) read_da_file ( da1, da1fn, nScan, da1Data );
+  if (da0) read_da_file ( da0, da0fn, nScan, acq.daData[0] );
+  if (da1) read_da_file ( da1, da1fn, nScan, acq.daData[1] );
 
   // initialize and reset hardware with  HPADDAlib ---------------------
-  initHPADDAboard();
-  ADS1256_set_gain (rangeCode[0]);
-  drate = ADS1256_SetDigitizationRate(drate);
+  if ( !daemon_running() && initHPADDAboard() )  good_bye ( 1,da0,da1 );
+  if ( open_converters ( acq.ad, &opts ) )  good_bye ( 1,da0,da1 );
+  acq.da = &dac8532;                   // the DAC8532 of the board
+  if ( daemon_running() ) {            // registers changed since the last test?
+    int nDiff = ADS1256_VerifyShadow ( acq.ad[0] );
+    if ( nDiff < 0 ) {
+      errorMsg("  hpgdaacd: the ADS1256 does not respond, DRDY timeout");
+      good_bye ( 1,da0,da1 );
+    }
+    if ( nDiff > 0 ) {
+      color(1); color(33);
+      fprintf(stderr,"\n ADS1256 registers re-read  . . . . . . . . . . . . . . . . . .  ok \n");
+    }
+  }
+  drate = setup_converters ( acq.ad, acq.nAd, acq.nChnl, acq.cnv,
+                             acq.rangeCode, drate, opts.calMode ); // OFC, FSC
+  if ( drate == 0 )  good_bye ( 1,da0,da1 );
+
+  if ( opts.pacing == PACE_DRDY ) {   // a whole number of conversions per scan
+    convPerScan = MAX ( (unsigned)( drate / sr + 0.5 ),
+                        (unsigned)( plan.scan_us * drate / 1e6 ) + 2 );
+    sr = drate / convPerScan;
+    dtime = nScan / sr;
+    delta_us = (uint64_t)(1.0e6/sr);
+    pause_us = (uint64_t) MAX ( 0.0, 1.0e6/sr - plan.scan_us );
+    fprintf(stderr," DRDY pacing: %u conversion periods per scan, %.3f scans per second\n",
+                    convPerScan, sr );
+  }
+  skew_init ( &acq.skew, acq.nChnl, sr, acq.sched.div, opts.align );
+  if ( skew_alloc ( &acq.skew, nScan, &arena ) )       // aligned data memory
+    good_bye ( 1,da0,da1 );
 
-  fprintf(stderr,"sr= %f delta_us= %llu pause_us= %llu dtime= %f  nChnl= %d  nScan= %u  nSmpl= %u  drate= %8.1f\n", sr, delta_us,pause_us, dtime, nChnl, nScan, nSmpl, drate );
+  fprintf(stderr,"sr= %f delta_us= %llu pause_us= %llu dtime= %f  nChnl= %d  nScan= %u  nSmpl= %u  drate= %8.1f\n", sr, delta_us,pause_us, dtime, acq.nChnl, nScan, nSmpl, drate );
 
 
   /* initialize and reset hardware with  WaveShare
@@ -221,23 +375,64 @@ int main (int argc, char *argv[])
    */
   
   // pretest data sample -----------------------------------------------
-  pretest_sample_stats( chnl, nChnl, muxCode, 100 );
+  pretest_sample_stats( acq.ad, acq.cnv, chnl, acq.nChnl, acq.muxCode, acq.rangeCode, 100 );
+  for (chn = 0; chn < acq.nChnl; chn++)    // slow channels, until converted
+    acq.adScan[chn] = (int32_t) chnl[chn].bias;
+
+  // controller input scaling from the pre-test bias ------------------
+  if (control) control_setup ( &ctrl, chnl, acq.rangeCode );
+
+  // loopback step, a half of the D/A or 80 percent of the A/D range ---
+  acq.loopDA = acq.loopChnl = -1;
+  acq.daLoop = DA_00;
+  if (loopback) {
+    float  step = MIN ( 0.5*DA_VREF,
+                        0.8*ADS1256_range_value(acq.rangeCode[opts.loopChnl]) );
+    acq.loopDA   = opts.loopDA;
+    acq.loopChnl = opts.loopChnl;
+    acq.daStep = (uint16_t)( step / DA_VREF * DA_HI + 0.5 );
+    acq.adStep = (int32_t)( step / ADS1256_range_value(acq.rangeCode[opts.loopChnl]) * ADMAX );
+  }
+
+  // the rest of the scan state of the acquisition context --------------
+  acq.ctrl      = control ? &ctrl : NULL;
+  acq.daFile[0] = da0;
+  acq.daFile[1] = da1;
+  acq.nScan     = nScan;
+  acq.sr        = sr;
 
   // turn on digital outputs -------------------------------------------
-  bcm2835_gpio_write(PIN_38, HIGH);
-  bcm2835_gpio_write(PIN_40, HIGH);
+  acq.ad[0]->ops->gpio_write(PIN_38, HIGH);
+  acq.ad[0]->ops->gpio_write(PIN_40, HIGH);
 
 #if GRAPHICS
   // initialize graphics -----------------------------------------------
-  plot_setup ( &xu, &yu, &xo, &yo, 0, dtime, rangeCode, 
-               title, xLabel, yLabel, nChnl, chnl );
+  if ( opts.graphics ) {
+    graphics = ( plot_setup ( &xu, &yu, &xo, &yo, 0, dtime, acq.rangeCode, 
+                              title, xLabel, yLabel, acq.nChnl, chnl, sr,
+                              opts.stripSec ) == 0 );
+    if ( !graphics ) {
+      color(1); color(33);
+      fprintf(stderr," no X display  . . . . . . . . . . . . . . . . . . . . . . . . .  headless \n");
+    }
+  }
 #endif  // GRAPHICS
 
+  // live data stream ---------------------------------------------------
+  if ( opts.streamAddr[0] &&
+       stream_open ( opts.streamAddr, title, acq.nChnl, chnl, acq.rangeCode, sr, nScan ) )
+    good_bye ( 1,da0,da1 );
+
+  // live data ring in shared memory -----------------------------------
+  if ( opts.shmName[0] &&
+       shm_ring_open ( opts.shmName, title, acq.nChnl, chnl, acq.rangeCode, sr, nScan ) )
+    good_bye ( 1,da0,da1 );
+
 //initscr();                               // ncurses
 //putchar ('\a');                          // ring when ready 
 
-  bcm2835_gpio_write(PIN_38, LOW);
-  bcm2835_gpio_write(PIN_40, LOW);
+  acq.ad[0]->ops->gpio_write(PIN_38, LOW);
+  acq.ad[0]->ops->gpio_write(PIN_40, LOW);
 
   int ll = 75-strlen(title);
   color(0); color(1); color(33);
@@ -245,7 +440,7 @@ int main (int argc, char *argv[])
   fprintf (stderr,"________________________________________\n");
   color(33); color(44);
   fprintf (stderr,"  %s %*s  \n", title, ll, " " );
-  fprintf (stderr,"  %d scans of %d channels at %6.1f sps and %7.1f cps in %.3f seconds\n", nScan, nChnl, sr, drate, dtime );
+  fprintf (stderr,"  %d scans of %d channels at %6.1f sps and %7.1f cps in %.3f seconds\n", nScan, acq.nChnl, sr, drate, dtime );
   color(0); color(1); color(32);
  
   color(1); color(33);
@@ -254,6 +449,9 @@ int main (int argc, char *argv[])
   color(1); color(37); fprintf(stderr,"/");
   color(1); color(31); fprintf(stderr,"n  ");
   color(1); color(37); 
+  if ( daemon_running() )                  // hpgdaacd ... always ready
+    fprintf(stderr,"\n");
+  else
   while ((ch = getchar()) != EOF) {        // get the character
     if ( (ch != ' ') && (ch != '\t' ) ) break;
   }
@@ -274,50 +472,63 @@ int main (int argc, char *argv[])
   }
 
   startTime = time(NULL);
+  arena_faults ( &minFlt0, &majFlt0 );
 
-  signal( SIGALRM, AD_write_process_DA_plot );
-  ualarm( delta_us, delta_us);                     // GO!
-
-  // main data acquisition and control loop
-  scan = 0;
-  do {
-//  bcm2835_gpio_write(PIN_40, HIGH);
-//  DEV_Delay_micro(pause_us);
-//  AD_write_process_DA_plot(0);
-//  ADS1256_PrintAllValue();
-//  fprintf(stderr,"x "); fflush(stderr);
-//  bcm2835_gpio_write(PIN_40, LOW);
-//  fprintf(stderr,"o "); fflush(stderr);
-//  fprintf(stderr," . . . scan = %9u  smpl = %9u \n", scan, smpl ); // debug
-  } while ( scan < nScan ); 
-
-#if CONTROL
-  // memory de-allocation 
-  free_vector(xc,1,_N);
-  free_vector(xc1,1,_N);
-  free_vector(dxcdt,1,_N);
-  free_vector(y,1,_L);
-  free_matrix(Ac,1,_N,1,_N);      
-  free_matrix(Bc,1,_N,1,_L);
-  free_matrix(Cc,1,_M,1,_N);
-  free_matrix(Dc,1,_M,1,_L);
-#endif  // CONTROL
-
-  ualarm( 0 , 0 );                                 // STOP!
+  if ( opts.pacing == PACE_DRDY ) {
+    acq.scan = 0;
+    pace_drdy ( &acq, convPerScan, drate );        // GO! ... and STOP!
+    sr = acq.sr;                                   // the measured scan rate
+  } else {
+    signal( SIGALRM, AD_write_process_DA_plot );
+    ualarm( delta_us, delta_us);                   // GO!
+
+    // main data acquisition and control loop
+    acq.scan = 0;
+    do {
+//    bcm2835_gpio_write(PIN_40, HIGH);
+//    DEV_Delay_micro(pause_us);
+//    AD_write_process_DA_plot(0);
+//    ADS1256_PrintAllValue();
+//    fprintf(stderr,"x "); fflush(stderr);
+//    bcm2835_gpio_write(PIN_40, LOW);
+//    fprintf(stderr,"o "); fflush(stderr);
+//    fprintf(stderr," . . . scan = %9u  smpl = %9u \n", scan, smpl ); // debug
+    } while ( acq.scan < nScan ); 
+
+    ualarm( 0 , 0 );                               // STOP!
+  }
+  arena_faults ( &minFlt1, &majFlt1 );
+  skew_flush ( &acq.skew, nScan );                 // the last aligned scans
+#if GRAPHICS
+  if (graphics)  plot_flush ();                    // the last frame
+#endif  // GRAPHICS
+  stream_close ();                                 // the last scans
+  shm_ring_close ();
   color(1); color(33);
 //printf("        . . . test complete . . . \n");  
 //printf("        . . . scan = %9u  smpl = %9u \n", scan, smpl ); // debug
 //putchar ('\a'); putchar ('\a');            // ring when done
 
-  save_data ( argv, title, nChnl, chnlDesc, chnl, 
-              da0Data, da1Data, nScan, drate, sr, dtime, rangeCode, startTime, 
+  save_data ( argv, title, acq.nChnl, chnlDesc, chnl, 
+              acq.daData[0], acq.daData[1], nScan, drate, sr, dtime, acq.rangeCode, startTime, 
               adDataFilename, sensiFilename);
 
-  enter_esc_to_exit();
+  if (control) {                           // control path latency
+    latency_report ( &acq.latAdDa );
+    latency_report ( &acq.latScanDa );
+    control_report ( &ctrl );
+  }
+  if (loopback)  latency_report ( &acq.latLoop );
+  color(1); color(33);
+  fprintf(stderr," page faults: %ld minor, %ld major before the test;  %ld minor, %ld major during the test\n",
+                  minFlt0, majFlt0, minFlt1 - minFlt0, majFlt1 - majFlt0 );
 
+  if ( !daemon_running() )  enter_esc_to_exit();
+
+  testOK = 1;
   good_bye ( 1,da0,da1 );                  // GOOD BYE !
 
-  exit(0);
+  return 0;
 }
 
 
@@ -341,17 +552,18 @@ Constant Description 1                     :
 Constant Description n                     : 
 D/A 0 data file name                       : optional e.g., DA-files/chirp0.dat
 D/A 1 data file name                       : optional e.g., DA-files/chirp1.dat
+  (optional lines: see the listing below)
 
 ------------------------------------------------------------------------------*/
 int read_configuration( int argc, char *argv[], char *title,
   float *dtime, float *sr, float *drate, 
   unsigned *nChnl, uint8_t muxCode[], uint8_t *rangeCode, char *chnlDesc,
   struct CHNL  *chnl, int *da0, int *da1, char *da0fn, char *da1fn,
-  char *sensiFilename, struct CTRLCNST *ctrlCnst )
+  char *sensiFilename, struct CTRLCNST *ctrlCnst, struct OPTIONS *opts )
 {
   char   str[MAXL];
-  int8_t posPin[8] = { 0, 1, 2, 3, 4, 5, 6, 7};// pin for positive signal lead
-  int8_t negPin[8] = {-1,-1,-1,-1,-1,-1,-1,-1};// pin for negative signal lead
+  int8_t posPin[NUMCHNL] = { 0, 1, 2, 3, 4, 5, 6, 7};// pin for positive signal lead
+  int8_t negPin[NUMCHNL] = {-1,-1,-1,-1,-1,-1,-1,-1};// pin for negative signal lead
   int    chn, cst;
   float  rangeValue[NUMCHNL] = {5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0, 5.0}; 
   int    nConstants = 0;    // number of control constants
@@ -384,6 +596,23 @@ int read_configuration( int argc, char *argv[], char *title,
     fprintf(stderr,"Constant Description n                    : \n");
     fprintf(stderr,"D/A 0 data file name                      : optional e.g., DA-files/chirp0.dat\n");
     fprintf(stderr,"D/A 1 data file name                      : optional e.g., DA-files/chirp1.dat\n");
+    fprintf(stderr,"Controller data file name                 : optional e.g., ctrl.cfg\n");
+    fprintf(stderr,"Loopback latency test D/A and A/D channels: optional e.g., 0  3\n");
+    fprintf(stderr,"Strip chart window (seconds)              : optional e.g., 10.0\n");
+    fprintf(stderr,"Graphics [on, off]                        : optional e.g., off\n");
+    fprintf(stderr,"Stream data to socket (path or port)      : optional e.g., /tmp/HPGdaac.sock\n");
+    fprintf(stderr,"Shared memory ring name                   : optional e.g., /HPGdaac\n");
+    fprintf(stderr,"Calibration [cached, fresh, off]          : optional e.g., fresh\n");
+    fprintf(stderr,"Rate divisors (per channel)               : optional e.g., 1  1  10  100\n");
+    fprintf(stderr,"Conversions per scan (per channel)        : optional e.g., 1  1  4  16\n");
+    fprintf(stderr,"Pacing [timer, drdy]                      : optional e.g., drdy\n");
+    fprintf(stderr,"Align channels [off, on]                  : optional e.g., on\n");
+    fprintf(stderr,"Characterization scans (per setting)      : optional e.g., 1000\n");
+    fprintf(stderr,"Timing plan [check, auto]                 : optional e.g., auto\n");
+    fprintf(stderr,"Packed samples (24 bit) [off, on]         : optional e.g., on\n");
+    fprintf(stderr,"Huge pages [off, on]                      : optional e.g., on\n");
+    fprintf(stderr,"Converter of each channel [0 to 3]        : optional e.g., 0  0  1  1\n");
+    fprintf(stderr,"Pins of converters 1 to 3 (CS DRDY RESET) : optional e.g., 5 6 13  19 26 16\n");
 
     good_bye ( 0,0,0 );
   }
@@ -393,6 +622,12 @@ int read_configuration( int argc, char *argv[], char *title,
   scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%f", sr );
   scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%f", drate );
   scanLine ( fp, MAXL, str, ':' );   (void) fscanf ( fp, "%d", nChnl );
+  if ( *nChnl < 1 || *nChnl > NUMCHNL ) {
+    errorMsg("  read_configuration: Number of Channels out of range.");
+    fprintf(stderr,"  Number of Channels must be >= 1 and <= %d", NUMCHNL );
+    fclose(fp);
+    good_bye ( 0,0,0 );
+  }
   scanLine ( fp, MAXL, str, ':' ); 
   for (chn = 0; chn < *nChnl; chn++) (void) fscanf ( fp, "%hhd", &posPin[chn] );
   getLine  ( fp, MAXL, chnlDesc );    // clear line
@@ -408,12 +643,14 @@ int read_configuration( int argc, char *argv[], char *title,
     if ( posPin[chn] < 0 || 7 < posPin[chn] ) {
       errorMsg("  read_configuration: posPin out of range.");
       fprintf(stderr,"  posPin must be >= 0 and <= 7");
+      fclose(fp);
       good_bye ( 0,0,0 );
     }
   for (chn = 0; chn < *nChnl; chn++) 
     if ( negPin[chn] < -1 || 7 < negPin[chn] ) {
       errorMsg("  read_configuration: negPin out of range.");
       fprintf(stderr,"  negPin must be >= -1 and <= 7");
+      fclose(fp);
       good_bye ( 0,0,0 );
     }
 
@@ -423,6 +660,7 @@ int read_configuration( int argc, char *argv[], char *title,
   if ( nConstants > 15 ) {
    errorMsg("  Maximum Number of Control Constants = 15");
    printf("  Entered Number of Control Constants = %d\n",nConstants);
+   fclose(fp);
    good_bye ( 0,0,0 );
   }
   for (cst=1; cst <= nConstants; cst++ ) {
@@ -448,14 +686,16 @@ int read_configuration( int argc, char *argv[], char *title,
   }
 
   scanLine ( fp, MAXL, str , ':');
-  if ( fscanf(fp,"%s", da0fn ) == 1 )  *da0 = 1;
+  getLine  ( fp, MAXL, str );        // the rest of the line may be blank
+  if ( sscanf(str,"%s", da0fn ) == 1 )  *da0 = 1;
 
   scanLine ( fp, MAXL, str , ':');
-  if ( fscanf(fp,"%s", da1fn ) == 1 )   *da1 = 1;
+  getLine  ( fp, MAXL, str );        // the rest of the line may be blank
+  if ( sscanf(str,"%s", da1fn ) == 1 )   *da1 = 1;
 
-  fclose(fp);      /* close the configuration file  */
+  read_options ( fp, opts );         // optional lines 
 
-  if (*drate < 2 * (*nChnl) * (*sr))  *drate = 2 * (*nChnl) * (*sr);
+  fclose(fp);      /* close the configuration file  */
 
   /*
    set ADS1256 MUX for changing input pins for ADC 
@@ -501,6 +741,148 @@ int read_configuration( int argc, char *argv[], char *title,
 }
 
 
+/* READ_OPTIONS - read optional "label : value" lines that follow the D/A
+   file names in the configuration file.   A line is recognized by the first
+   word of its label, so the rest of the label may be edited freely.  19oct26
+
+Controller data file name                  : ctrl.cfg
+Loopback latency test D/A and A/D channels : 0  3
+Strip chart window (seconds)               : 10.0
+Graphics [on, off]                         : off
+Stream data to socket (path or port)       : /tmp/HPGdaac.sock
+Shared memory ring name                    : /HPGdaac
+Calibration [cached, fresh, off]           : cached
+Rate divisors (per channel)                : 1  1  10  100
+Conversions per scan (per channel)         : 1  1  4  16
+Pacing [timer, drdy]                       : drdy
+Align channels [off, on]                   : on
+Characterization scans (per setting)       : 1000
+Timing plan [check, auto]                  : auto
+Packed samples (24 bit) [off, on]          : on
+Huge pages [off, on]                       : on
+Converter of each channel [0 to 3]         : 0  0  1  1
+Pins of converters 1 to 3 (CS DRDY RESET)  : 5 6 13  19 26 16
+------------------------------------------------------------------------------*/
+int read_options ( FILE *fp, struct OPTIONS *opts )
+{
+  char   line[MAXL], key[MAXL], *val, *end;
+  int    k;
+  long   d;
+
+  opts->ctrlFilename[0] = '\0';
+  opts->loopDA = opts->loopChnl = -1;
+  opts->stripSec = 0.0;
+  opts->graphics = 1;
+  opts->streamAddr[0] = '\0';
+  opts->shmName[0] = '\0';
+  opts->calMode = CAL_CACHED;
+  opts->pacing = PACE_TIMER;
+  opts->align = 0;
+  opts->charScans = CHAR_SCANS;
+  opts->plan = PLAN_CHECK;
+  opts->packed = 0;
+  opts->huge = 0;
+  for (k=0; k<NUMCHNL; k++)  opts->rateDiv[k] = 1;
+  for (k=0; k<NUMCHNL; k++)  opts->convAvg[k] = 1;
+  for (k=0; k<NUMCHNL; k++)  opts->cnv[k] = 0;
+  opts->nCnv = 1;
+
+  while ( fgets ( line, MAXL, fp ) != NULL ) {
+    if ( (val = strchr ( line, ':' )) == NULL )  continue;  // not an option
+    *val++ = '\0';
+    if ( sscanf ( line, "%s", key ) != 1 )  continue;
+
+    if ( strcasecmp ( key, "Controller" ) == 0 )
+      (void) sscanf ( val, "%s", opts->ctrlFilename );
+    else
+    if ( strcasecmp ( key, "Loopback" ) == 0 )
+      (void) sscanf ( val, "%d %d", &opts->loopDA, &opts->loopChnl );
+    else
+    if ( strcasecmp ( key, "Strip" ) == 0 )
+      (void) sscanf ( val, "%f", &opts->stripSec );
+    else
+    if ( strcasecmp ( key, "Graphics" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->graphics = ( strcasecmp ( key, "off" ) != 0 &&
+                           strcasecmp ( key, "0" )   != 0 );
+    } else
+    if ( strcasecmp ( key, "Stream" ) == 0 )
+      (void) sscanf ( val, "%s", opts->streamAddr );
+    else
+    if ( strcasecmp ( key, "Shared" ) == 0 )
+      (void) sscanf ( val, "%s", opts->shmName );
+    else
+    if ( strcasecmp ( key, "Calibration" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 && cal_mode ( key ) >= 0 )
+        opts->calMode = cal_mode ( key );
+    } else
+    if ( strcasecmp ( key, "Pacing" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->pacing = ( strcasecmp ( key, "drdy" ) == 0 ) ? PACE_DRDY : PACE_TIMER;
+    } else
+    if ( strcasecmp ( key, "Characterization" ) == 0 ) {
+      if ( sscanf ( val, "%ld", &d ) == 1 )
+        opts->charScans = ( d < 1 ) ? 1 : (unsigned) d;
+    } else
+    if ( strcasecmp ( key, "Timing" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->plan = ( strcasecmp ( key, "auto" ) == 0 ) ? PLAN_AUTO : PLAN_CHECK;
+    } else
+    if ( strcasecmp ( key, "Packed" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->packed = ( strcasecmp ( key, "on" ) == 0 ||
+                         strcasecmp ( key, "1" )  == 0 );
+    } else
+    if ( strcasecmp ( key, "Huge" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->huge = ( strcasecmp ( key, "on" ) == 0 ||
+                       strcasecmp ( key, "1" )  == 0 );
+    } else
+    if ( strcasecmp ( key, "Align" ) == 0 ) {
+      if ( sscanf ( val, "%s", key ) == 1 )
+        opts->align = ( strcasecmp ( key, "on" ) == 0 ||
+                        strcasecmp ( key, "1" )  == 0 );
+    } else
+    if ( strcasecmp ( key, "Rate" ) == 0 ) {
+      for (k=0; k<NUMCHNL; k++, val=end) {
+        d = strtol ( val, &end, 10 );
+        if ( end == val )  break;
+        opts->rateDiv[k] = ( d < 1 ) ? 1 : (unsigned) d;
+      }
+    } else
+    if ( strcasecmp ( key, "Conversions" ) == 0 ) {
+      for (k=0; k<NUMCHNL; k++, val=end) {
+        d = strtol ( val, &end, 10 );
+        if ( end == val )  break;
+        opts->convAvg[k] = ( d < 1 ) ? 1 : ( d > 255 ) ? 255 : (uint8_t) d;
+      }
+    } else
+    if ( strcasecmp ( key, "Converter" ) == 0 ) {
+      for (k=0; k<NUMCHNL; k++, val=end) {
+        d = strtol ( val, &end, 10 );
+        if ( end == val )  break;
+        opts->cnv[k] = ( d < 0 ) ? 0 : ( d >= ACQ_MAXAD ) ? ACQ_MAXAD-1 : (uint8_t) d;
+      }
+    } else
+    if ( strcasecmp ( key, "Pins" ) == 0 ) {
+      int  pin[3];
+      for (opts->nCnv = 1; opts->nCnv < ACQ_MAXAD; opts->nCnv++, val += k) {
+        if ( sscanf ( val, "%d %d %d%n", &pin[0], &pin[1], &pin[2], &k ) != 3 )
+          break;
+        opts->cnvPins[opts->nCnv][0] = (uint8_t) pin[0];
+        opts->cnvPins[opts->nCnv][1] = (uint8_t) pin[1];
+        opts->cnvPins[opts->nCnv][2] = (uint8_t) pin[2];
+      }
+    } else {
+      color(1); color(33);
+      fprintf(stderr,"  read_options: '%s' is not an option ... ignored\n", key);
+    }
+  }
+
+  return(0);
+}
+
+
 /* READ_SENSITIVITY  - read sensitivity file 
 
     ---- SENSITIVITY  DATA  FILE  FORMAT ----  
@@ -563,7 +945,7 @@ int read_sensitivity ( char *argv[], char *sensiFilename, unsigned nChnl,
     (void) fscanf ( fp, "%d", &chnl[chn].D );
     (void) fscanf ( fp, "%f", &chnl[chn].S );
 
-    if (chn < 0 || chn > NUMCHNL ) {
+    if (chn < 0 || chn >= NUMCHNL ) {
     //putchar('\a');
       color ( 0 );  color ( 41 );
       fprintf(stderr,"error: sensitivity channel %d is out of range\n", chn );
@@ -571,12 +953,14 @@ int read_sensitivity ( char *argv[], char *sensiFilename, unsigned nChnl,
       fprintf(stderr,"correspond to \nthe data acquisition channels in ");
       fprintf(stderr,"configuration file '%s'\n", argv[1] );
       color(0); fprintf(stderr,"\n"); color(1); color(33);
+      fclose(fp);
       good_bye( 0,0,0 );
     }
     if ( chnl[chn].S > 1 || chnl[chn].S < 0 ) {
       fprintf(stderr,"error: channel %d ... \n", chn );
       fprintf(stderr," ... smoothing level must be between 0 and 1\n");
       fprintf(stderr,"     0 = no smoothing    1 = full smoothing \n");
+      fclose(fp);
       good_bye(0,0,0 );
     }
 
@@ -647,7 +1031,7 @@ void read_da_file ( int da, char *dafn, unsigned nScan, uint16_t  *daData)
   for ( i=1; i<= nScan; i++ ) { // check data range 
     if ( daData[i] < DA_LO || daData[i] > DA_HI ) {
       errorMsg ( "read_da_file: DA out of range" );
-      fprintf(stderr," %s DA[%d] = %d ", dafn, i, da0Data[i]);
+      fprintf(stderr," %s DA[%d] = %d ", dafn, i, daData[i]);
       fprintf(stderr,"  Limits are: %d <= DA[i] <= %d ", DA_LO, DA_HI);
       good_bye ( 1,da0,da1 );
     }
@@ -657,6 +1041,47 @@ void read_da_file ( int da, char *dafn, unsigned nScan, uint16_t  *daData)
 }
 
 
+/* OPEN_CONVERTERS - ad[0] the ADS1256 of the board, and ad[1..nCnv-1] the
+   others on the bus, opened on the pins of the Pins line           19oct26
+   returns 0: ok  1: abnormal
+---------------------------------------------------------------------------*/
+int open_converters ( struct ADS1256 *ad[], struct OPTIONS *opts )
+{
+  unsigned  k;
+
+  ad[0] = &ads1256;
+  for (k = 1; k < opts->nCnv; k++) {
+    ad[k] = &adsBus[k-1];
+    if ( ADS1256_Open ( ad[k], &hpadda_bcm2835, opts->cnvPins[k][0],
+                        opts->cnvPins[k][1], opts->cnvPins[k][2] ) )
+      return 1;
+  }
+  return 0;
+}
+
+
+/* SETUP_CONVERTERS - the data rate, the first gain, and the calibrations
+   of each converter ad[k] for the ranges of its channels, cnv[chn] == k
+   returns the data rate set, 0 if a calibration failed             19oct26
+---------------------------------------------------------------------------*/
+float setup_converters ( struct ADS1256 *ad[], unsigned nAd, unsigned nChnl,
+                         uint8_t cnv[], uint8_t rangeCode[], float drate,
+                         int calMode )
+{
+  uint8_t   range[NUMCHNL];
+  unsigned  k, chn, nRange;
+
+  for (k = 0; k < nAd; k++) {
+    for (chn = nRange = 0; chn < nChnl; chn++)
+      if ( cnv[chn] == k )  range[nRange++] = rangeCode[chn];
+    ADS1256_set_gain ( ad[k], nRange ? range[0] : rangeCode[0] );
+    drate = ADS1256_SetDigitizationRate ( ad[k], drate );
+    if ( cal_setup ( ad[k], nRange, range, drate, calMode ) )  return 0.0;
+  }
+  return drate;
+}
+
+
 /*
 PRETEST_DATA_STATS
       average of P points of data, at the test stample rate
@@ -664,13 +1089,17 @@ PRETEST_DATA_STATS
       This routine does not use Burst mode. If burst mode is enabled,
       ad_init() and ad_range() should be called before and after
       average() is called.  
+      The channels of each converter ad[cnv[chn]] are scanned together.
 ---------------------------------------------------------------------------*/
-void pretest_sample_stats( struct CHNL *chnl, unsigned nChnl, uint8_t muxCode[],  unsigned nScan)
+void pretest_sample_stats( struct ADS1256 *ad[], uint8_t cnv[], struct CHNL *chnl,
+                           unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[],
+                           unsigned nScan)
 { 
 
-  unsigned  scn, chn; 
+  unsigned  scn, chn, c, n; 
   double    dataValue = 0.0;
-  int32_t   adScan[NUMCHNL];
+  int32_t   adScan[NUMCHNL], adCnv[NUMCHNL];
+  uint8_t   mux[NUMCHNL], range[NUMCHNL];
 
   for ( chn=0; chn < NUMCHNL; chn++ ) chnl[chn].bias = 0.0;
   for ( chn=0; chn < NUMCHNL; chn++ ) chnl[chn].rms  = 0.0;
@@ -680,7 +1109,20 @@ void pretest_sample_stats( struct CHNL *chnl, unsigned nChnl, uint8_t muxCode[],
 //printf(" nScan = %u \n", nScan );
   for ( scn = 0; scn < nScan; scn++) {
 
-    ADS1256_ChannelScan(nChnl, muxCode, rangeCode, adScan);
+    for ( c = 0; c < ACQ_MAXAD; c++ ) {
+      for ( chn = n = 0; chn < nChnl; chn++ )
+        if ( cnv[chn] == c ) {
+          mux[n]     = muxCode[chn];
+          range[n++] = rangeCode[chn];
+        }
+      if ( n == 0 )  continue;
+      if ( ADS1256_ChannelScan(ad[c], n, mux, range, adCnv, NULL, NULL) ) {
+        errorMsg("  pretest: DRDY timeout, the ADS1256 is not converting");
+        good_bye ( 1,da0,da1 );
+      }
+      for ( chn = n = 0; chn < nChnl; chn++ )
+        if ( cnv[chn] == c )  adScan[chn] = adCnv[n++];
+    }
 
     for ( chn = 0; chn < nChnl;  chn++ ) {
 //    printf(" %3d: %6.0f  ", chn, dataValue );  
@@ -741,61 +1183,329 @@ float time_out ( struct time start, struct time stop )
 #endif  // TIME_OUT
 
 
+/* SORT_BY_GAIN - sort the channels order[0..n-1] by PGA gain, up or down,
+   keeping the order of the channels with the same gain             19oct26
+------------------------------------------------------------------------------*/
+static void sort_by_gain ( unsigned n, unsigned order[], uint8_t rangeCode[],
+                           int down )
+{
+  unsigned  i, j, c;
+
+  for (i = 1; i < n; i++) {
+    c = order[i];
+    for (j = i; j > 0; j--) {
+      int  g0 = rangeCode[order[j-1]] & 0x07,  g1 = rangeCode[c] & 0x07;
+      if ( down ? g0 >= g1 : g0 <= g1 )  break;
+      order[j] = order[j-1];
+    }
+    order[j] = c;
+  }
+}
+
+
+/* SORT_BY_CNV - sort the channels order[0..n-1] by converter, keeping the
+   order of the channels of the same converter                      19oct26
+------------------------------------------------------------------------------*/
+static void sort_by_cnv ( unsigned n, unsigned order[], uint8_t cnv[] )
+{
+  unsigned  i, j, c;
+
+  for (i = 1; i < n; i++) {
+    c = order[i];
+    for (j = i; j > 0 && cnv[order[j-1]] > cnv[c]; j--)
+      order[j] = order[j-1];
+    order[j] = c;
+  }
+}
+
+
+/* GAIN_CHANGES - the changes of PGA gain from one channel to the next, in
+   scans converted one after the other, in the order order[0..n-1]  19oct26
+------------------------------------------------------------------------------*/
+static unsigned gain_changes ( unsigned n, unsigned order[], uint8_t rangeCode[] )
+{
+  unsigned  k, changes = 0;
+
+  for (k = 0; k < n; k++)
+    if ( ( rangeCode[order[k]] & 0x07 ) != ( rangeCode[order[(k+1) % n]] & 0x07 ) )
+      ++changes;
+  return changes;
+}
+
+
+/* SET_SCAN_ORDER - order the scan with the controller input channels, or
+   the loopback channel, first, followed by the other channels.  Within
+   each part the channels are kept as configured, or grouped by voltage
+   range, up or down, whichever the timing plan (plan_order) converts in
+   the shortest time at the data rate drate, since a change of gain
+   rewrites the ADCON and calibration registers and a change of channel
+   only the MUX; of orders planned alike, the one with the fewest changes
+   of gain.  Every channel is planned as if it were in every scan.  The
+   channels of each part are then grouped by converter, cnv[], each group
+   one ChannelScan.  The data keeps the order of the channels.  Returns
+   the number of channels scanned before the D/A is written.         19oct26
+------------------------------------------------------------------------------*/
+unsigned set_scan_order ( unsigned nChnl, uint8_t muxCode[], uint8_t rangeCode[],
+                          uint8_t convAvg[], uint8_t cnv[], float drate, int calOn,
+                          unsigned scanOrder[], uint8_t muxOrder[], 
+                          uint8_t rangeOrder[] )
+{
+  int       first[NUMCHNL] = {0},
+            way, reordered = 0, grouped = 0;
+  unsigned  chn, k = 0, nFirst = 0,
+            order[NUMCHNL], changes, fewest = 0;
+  uint8_t   mux[NUMCHNL], range[NUMCHNL], avg[NUMCHNL], cnvk[NUMCHNL];
+  double    t, shortest = 0.0;              // planned scan, micro-seconds
+
+  if (control)  for (chn = 0; chn < ctrl.L; chn++)  first[ctrl.inChnl[chn]] = 1;
+  if (loopback) first[opts.loopChnl] = 1;
+
+  for (way = -1; way < 4; way++) {  // as configured, then each part up or down
+    k = 0;
+    for (chn = 0; chn < nChnl; chn++)  if (  first[chn] )  order[k++] = chn;
+    nFirst = k;
+    for (chn = 0; chn < nChnl; chn++)  if ( !first[chn] )  order[k++] = chn;
+    if ( way >= 0 ) {
+      sort_by_gain ( nFirst, order, rangeCode, way & 1 );
+      sort_by_gain ( nChnl - nFirst, order + nFirst, rangeCode, way & 2 );
+    }
+    sort_by_cnv ( nFirst, order, cnv );
+    sort_by_cnv ( nChnl - nFirst, order + nFirst, cnv );
+    for (k = 0; k < nChnl; k++) {
+      mux[k]   = muxCode[order[k]];
+      range[k] = rangeCode[order[k]];
+      avg[k]   = convAvg[order[k]];
+      cnvk[k]  = cnv[order[k]];
+    }
+    t = plan_order ( nChnl, nFirst, mux, range, avg, cnvk, drate, calOn );
+    changes = gain_changes ( nChnl, order, rangeCode );
+    if ( way < 0 || t < shortest - 0.5 ||
+         ( t < shortest + 0.5 && changes < fewest ) ) {
+      shortest = t;
+      fewest = changes;
+      reordered = ( way >= 0 );
+      memcpy ( scanOrder, order, nChnl * sizeof(unsigned) );
+    }
+  }
+
+  for (k = 0; k < nChnl; k++) {
+    muxOrder[k]   = muxCode[scanOrder[k]];
+    rangeOrder[k] = rangeCode[scanOrder[k]];
+    if ( cnv[k] )  grouped = 1;
+  }
+
+  if ( nFirst > 0 || reordered || grouped ) {
+    fprintf(stderr," scan order ");
+    for (k = 0; k < nChnl; k++)  fprintf(stderr," %d%s", scanOrder[k],
+                                          k == nFirst-1 ? " |" : "" );
+    if ( nFirst > 0 )  fprintf(stderr,"   (D/A written after | )");
+    if ( reordered )   fprintf(stderr,"   (grouped by voltage range, %.0f us planned)",
+                                shortest );
+    if ( grouped )     fprintf(stderr,"   (grouped by converter)");
+    fprintf(stderr,"\n");
+  }
+
+  return nFirst;
+}
+
+
 /* AD_WRITE_PROCESS_DA_PLOT -  data aquisition and control handler    02feb22
+   the interval timer signal handler ... one scan of the acquisition of the
+   test, acq                                                         19oct26
 ------------------------------------------------------------------------------*/
 void AD_write_process_DA_plot(int signum)
 {
-  int        chn;             // a data acquisition channel number
-//float      data, x;         // a data value
+  scan_acq ( &acq );
+}
+
+
+/* SCAN_RUNS - convert the n channels mux[], range[], avg[] of a scan list,
+   one ChannelScan of q->ad[cnv[k]] for each run of channels on the same
+   converter;  returns the conversions of converter 0, which paces, and ends
+   the test if a converter has stopped converting                    19oct26
+------------------------------------------------------------------------------*/
+static unsigned scan_runs ( struct ACQ *q, unsigned n, uint8_t *cnv,
+                            uint8_t *mux, uint8_t *range, uint8_t *avg,
+                            int32_t *adOut, uint64_t *tOut )
+{
+  unsigned  k, r, m, conv = 0;
+
+  for (k = 0; k < n; k += m) {
+    for (m = 1; k+m < n && cnv[k+m] == cnv[k]; m++) ;
+    if ( ADS1256_ChannelScan ( q->ad[cnv[k]], m, mux+k, range+k, adOut+k,
+                               tOut+k, avg ? avg+k : NULL ) ) { // HPADDAlib
+      errorMsg("  scan_acq: DRDY timeout, the ADS1256 is not converting");
+      good_bye ( 1,q->daFile[0],q->daFile[1] );
+    }
+    if ( cnv[k] == 0 )
+      for (r = k; r < k+m; r++)  conv += avg ? avg[r] : 1;
+  }
+  return conv;
+}
+
+
+/* SCAN_ACQ - one scan of the acquisition context q                   19oct26
+   The control path runs first ... the control channels are converted, the
+   controller is evaluated, and the D/A is written, before the other
+   channels are converted and the scan is stored and plotted.  The
+   channels of each converter on the bus are converted one after the
+   other, and only the conversions of ad[0] count for the pacing.  The
+   converters, the D/A and the backend of their bus, the scan list, the
+   controller, the D/A data and the latency histograms are those of q; the plot, the stream and the shared memory
+   ring are those of the process.
+------------------------------------------------------------------------------*/
+void scan_acq ( struct ACQ *q )
+{
+  int        chn, k;          // a data acquisition channel number
+  unsigned   f;               // the scan of the major frame
+  struct timespec  t0, t1, t2; // start of scan, A/D done, D/A done
+  uint64_t   tScan;           // start of scan, system timer, us
+
+  clock_gettime ( CLOCK_MONOTONIC, &t0 );
+  tScan = q->ad[0]->ops->st_read();
+  q->convScan = 0;
+
+  // control path: AtoD conversions of the control channels only ...
+  if ( q->nFirst > 0 ) {
+    q->convScan += scan_runs ( q, q->nFirst, q->cnvOrder, q->muxOrder,
+                               q->rangeOrder, q->avgOrder, q->adOrder, q->tConv );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    for ( k = 0; k < q->nFirst; k++ ) {
+      q->adScan[q->scanOrder[k]] = q->adOrder[k];
+      skew_add ( &q->skew, q->scanOrder[k], q->tConv[k], tScan );
+    }
+
+    // ... the control law, and the D/A, before anything else
+    if ( q->ctrl ) {
+      control_step ( q->ctrl, q->adScan, q->scan, q->daCtrl );
+      for ( chn = 0; chn < q->ctrl->M; chn++ )
+        DAC8532_Write ( q->da, q->ctrl->outDA[chn], q->daCtrl[chn] );
+      clock_gettime ( CLOCK_MONOTONIC, &t2 );
+      latency_add ( &q->latAdDa,   latency_ns ( &t1, &t2 ) );
+      latency_add ( &q->latScanDa, latency_ns ( &t0, &t2 ) );
+    }
 
-//printf(" . . . scan = %9u  smpl = %9u \n", scan, smpl ); // debug
-//bcm2835_gpio_write(PIN_38, HIGH);            // check for time delay 
+    // loopback test: step the D/A and convert until the A/D sees the step
+    if ( q->loopDA >= 0 && q->scan % LOOP_PERIOD == 0 ) {
+      int32_t  ref = q->adScan[q->loopChnl],  ad;
+      q->daLoop = ( q->daLoop == DA_00 ) ? DA_00 + q->daStep : DA_00;
+      DAC8532_Write ( q->da, q->loopDA, q->daLoop );
+      clock_gettime ( CLOCK_MONOTONIC, &t1 );
+      for ( k = 0; k < LOOP_TRIES; k++ ) {
+        if ( ADS1256_ChannelScan ( q->ad[q->cnv[q->loopChnl]], 1,
+                                   q->muxCode + q->loopChnl,
+                                   q->rangeCode + q->loopChnl, &ad, NULL, NULL ) ) {
+          errorMsg("  scan_acq: DRDY timeout, the ADS1256 is not converting");
+          good_bye ( 1,q->daFile[0],q->daFile[1] );
+        }
+        if ( q->cnv[q->loopChnl] == 0 )  ++q->convScan;
+        if ( abs ( ad - ref ) > q->adStep/2 ) {
+          clock_gettime ( CLOCK_MONOTONIC, &t2 );
+          latency_add ( &q->latLoop, latency_ns ( &t1, &t2 ) );
+          break;
+        }
+      }
+    }
+  }
 
-// AtoD conversions in a scan of the selected AD channels
-  ADS1256_ChannelScan(nChnl, muxCode, rangeCode, adScan); // HPADDAlib
+  // AtoD conversions of the remaining channels due in this scan, the
+  // others hold their latest conversion
+  f = q->scan % q->sched.nFrame;
+  q->convScan += scan_runs ( q, q->sched.n[f], q->sched.cnv[f], q->sched.mux[f],
+                             q->sched.range[f], q->sched.avg[f],
+                             q->adOrder+q->nFirst, q->tConv+q->nFirst );
+  for ( k = 0; k < q->sched.n[f]; k++ ) {
+    q->adScan[q->sched.chnl[f][k]] = q->adOrder[q->nFirst+k];
+    skew_add ( &q->skew, q->sched.chnl[f][k], q->tConv[q->nFirst+k], tScan );
+  }
+  q->convDone = q->ad[0]->ops->st_read();
+  if ( q->sched.nGroup )  sched_store ( &q->sched, q->scan, q->adScan );
 
 //ADS1256_GetAll(firstChnl, lastChnl, adScan); // WaveShare library
 //for (chn = firstChnl ; chn <= lastChnl ; chn++)
 //  adScan[chn] = ADS1256_ReadDataChn(chn);
-//printf("\33[8A");//Move the cursor up 8 lines
-
-  // copy the channel scan data to the adData array
-  for ( chn = 0; chn < nChnl; chn++ ) {
-    adData[smpl++] = adScan[chn];
-//  printf(" data[%2d] = %u \n", chn , data );             // debug
-  }
 
-/*
-     for(i=0;i<8;i++){
-       printf("%2d ... %zu ... %f\r\n",i,adScan[i],adScan[i]*5.0/0x7fffff);
-     }
-     //printf("\33[8A");//Move the cursor up 8 lines
-        
-     x = (adScan[0] >> 7)*5.0/0xffff;
-     printf(" %f \r\n", x);
-     printf(" %f \r\n", 3.3 - x);
-     printf("\33[10A");//Move the cursor up 10 lines
-*/
+  // copy the channel scan data to the adData store
+  store_scan ( &q->adData, q->scan, q->adScan );
+  q->smpl += q->nChnl;
+  skew_align ( &q->skew, q->scan, q->adScan ); // the scan SKEW_DELAY scans ago
 
-// Write_DAC8532( 0, data );  /               // check for time delay
+  // save the controller and loopback outputs with the scan
+  if ( q->ctrl )
+    for ( chn = 0; chn < q->ctrl->M; chn++ )
+      q->daData[q->ctrl->outDA[chn]][q->scan+1] = q->daCtrl[chn];
+  if ( q->loopDA >= 0 )
+    q->daData[q->loopDA][q->scan+1] = q->daLoop;
 
-#if CONTROL
-  control_rule ( &vOut, xc, y, constants )
-#endif
+  // send D/A file data to the DA channels 
+  if ( q->daFile[0] ) DAC8532_Write( q->da, 0, q->daData[0][q->scan+1] );
+  if ( q->daFile[1] ) DAC8532_Write( q->da, 1, q->daData[1][q->scan+1] );
 
-  // send analog output data to the DA channels 
-  if (da0 || CONTROL_DA0) DAC8532_Write( 0, da0Data[scan] );
-  if (da1 || CONTROL_DA1) DAC8532_Write( 1, da1Data[scan] );
+  // pass the scan to the stream subscribers, without waiting
+  stream_scan ( q->scan, q->adScan );
+  shm_ring_scan ( q->scan, q->adScan );
 
 #if GRAPHICS 
   // plot the data scan in real time
-  plot_data ( nChnl, sr, scan, adData, xo,yo, xu,yu, rangeCode );
+  if (graphics)  plot_data ( q->nChnl, q->sr, q->scan, q->adScan, xo,yo, xu,yu,
+                             q->rangeCode );
 #endif  // GRAPHICS
 
 //for (i=1; i<10000; i++) chn = i*i ;        // real time processing capacity
 
-  bcm2835_gpio_write(PIN_38, LOW);           // check for time delay 
-  ++scan;
+  q->ad[0]->ops->gpio_write(PIN_38, LOW);    // check for time delay 
+  ++q->scan;
+}
+
+
+/* PACE_DRDY - run the scans on the conversion clock of the ADS1256, which
+   converts continuously between scans.  Each falling edge of DRDY is one
+   conversion period; a scan starts at the edge that completes convPerScan
+   periods since the start of the last scan, counting the conversions of
+   the scan itself.  Edges missed while the handler or the plot was busy are
+   counted from the time between the edges, so the host need only start the
+   scan within a conversion period of its edge.  The scan rate measured from
+   the edges replaces the nominal scan rate in the data file.  The DRDY
+   edges are those of ad[0] of the acquisition context q.            19oct26
+------------------------------------------------------------------------------*/
+void pace_drdy ( struct ACQ *q, unsigned convPerScan, float drate )
+{
+  uint64_t  tEdge, tLast, tFirst = 0, tStart = 0;
+  double    T = 1.0e6 / drate,           // conversion period, micro-seconds
+            dt, dtMin = 1e12, dtMax = 0;
+  uint32_t  count = convPerScan,         // the first scan at once
+            missed, late = 0;
+
+  tLast = q->ad[0]->ops->st_read();
+  while ( q->scan < q->nScan ) {
+    if ( count >= convPerScan ) {        // start the next scan
+      if ( q->scan == 0 )  tFirst = tLast;
+      else {
+        dt = (double)( tLast - tStart );
+        if ( dt < dtMin )  dtMin = dt;
+        if ( dt > dtMax )  dtMax = dt;
+      }
+      tStart = tLast;
+      scan_acq ( q );
+      count = q->convScan;               // the conversions of the scan
+      tLast = q->convDone;               // edges after it are counted
+      continue;
+    }
+    if ( ADS1256_WaitDRDYEdge ( q->ad[0], ADS1256_DRDY_US, &tEdge ) ) {
+      errorMsg("  pace_drdy: DRDY timeout, the ADS1256 is not converting");
+      good_bye ( 1,q->daFile[0],q->daFile[1] );
+    }
+    missed = ( tEdge - tLast > 1.5*T ) ? (uint32_t)( (tEdge - tLast)/T + 0.5 ) - 1 : 0;
+    if ( missed )  ++late;
+    count += 1 + missed;
+    tLast = tEdge;
+  }
+
+  if ( q->nScan > 1 && tStart > tFirst )  // the measured scan rate
+    q->sr = (float)( 1.0e6 * (q->nScan-1) / (double)( tStart - tFirst ) );
+  color(1); color(33);
+  fprintf(stderr," DRDY pacing: %.3f scans per second, scan period %.1f to %.1f us, %u scans with missed edges\n",
+                  q->sr, dtMin, dtMax, late );
 }
 
 
@@ -828,6 +1538,9 @@ void save_data ( char *argv[], char *title, unsigned nChnl,
   char     ch = ';'; 
 
   double   data_value = 0;
+  int32_t  scanData[NUMCHNL],          // one scan from the adData store
+          *chnlData, *x;               // one block of it, by channel
+  unsigned b, n;                       // the block, and its scans
   double   max[NUMCHNL], min[NUMCHNL], // max and min values    
            avg[NUMCHNL], rms[NUMCHNL]; // average and rms values 
 
@@ -877,44 +1590,59 @@ void save_data ( char *argv[], char *title, unsigned nChnl,
       fprintf(fp,"  %8.0f",  chnl[chn].rms);
   }
   fprintf( fp, "\n");
+  if ( acq.sched.nFrame > 1 ) {
+    fprintf(fp, "%% rate divisors, channels hold their value between conversions \n");
+    for (chn = 0; chn < nChnl; chn++) {
+      if (chn == 0)
+        fprintf(fp,"%% %8u", acq.sched.div[chn] );
+      else
+        fprintf(fp,"  %8u",  acq.sched.div[chn] );
+    }
+    fprintf( fp, "\n");
+  }
+  for (chn = 0; chn < nChnl && opts.convAvg[chn] == 1; chn++) ;
+  if ( chn < nChnl ) {
+    fprintf(fp, "%% conversions averaged in each scan \n");
+    for (chn = 0; chn < nChnl; chn++)
+      fprintf(fp, chn == 0 ? "%% %8u" : "  %8u", opts.convAvg[chn] );
+    fprintf( fp, "\n");
+  }
+  fprintf(fp, "%% position of each channel in the scan order");
+  if ( acq.nFirst > 0 )  fprintf(fp, ", D/A written after position %u", acq.nFirst-1 );
+  fprintf(fp, " \n");
+  for (chn = 0; chn < nChnl; chn++) {
+    for (i = 0; acq.scanOrder[i] != chn; i++) ;
+    fprintf(fp, chn == 0 ? "%% %8d" : "  %8d", i );
+  }
+  fprintf( fp, "\n");
+  skew_header ( &acq.skew, fp );      // conversion instants of the channels
   for (chn = 0; chn < nChnl; chn++) {
       if (chn == 0)
       fprintf ( fp, "%%   chn %2d", chn );
     else
       fprintf ( fp, "    chn %2d",  chn );
   }
+  if (ctrlDA[0]) fprintf ( fp, "    D/A  0" );
+  if (ctrlDA[1]) fprintf ( fp, "    D/A  1" );
   fprintf( fp, "\n");
 
-  for (chn = 0; chn < NUMCHNL; chn++)  
-    avg[chn] = rms[chn] = max[chn] = min[chn] = 0.0;
-
   i = 0;
   for (scn=0; scn<nScan; scn++) {
+    store_read ( &acq.adData, scn, scanData );
     for (chn = 0; chn < nChnl; chn++) {
 
 //    data_value = adData[i];
-      data_value = (double) (adData[scn*nChnl+chn]);
+      data_value = (double) (scanData[chn]);
 //    data_value = data_value - chnl[chn].bias;
 //    data_value = data_value - ADMID; 
 //    if ( scn<=2*(lastChnl-firstChnl) && abs(data_value) > 32000 ) data_value = 0;
 
-      if ( scn <= 20 ) max[chn] = min[chn] += data_value/20;
-      avg[chn] += data_value;
-      rms[chn] += data_value * data_value;
-      if (data_value > max[chn]) max[chn] = data_value; 
-      if (data_value < min[chn]) min[chn] = data_value; 
-
       fprintf(fp,"%10d", (int)(data_value) );
       ++i;
     }
 
-#if CONTROL_DA0
-    fprintf(fp, "%10d\t", da0Data[p] - 0x000);
-#endif  // CONTROL_DA0
-
-#if CONTROL_DA1
-    fprintf(fp, "%10d\t", da1Data[p] - 0x000);
-#endif  // CONTROL_DA1
+    if (ctrlDA[0]) fprintf(fp, "%10d", da0Data[scn+1] - DA_00 );
+    if (ctrlDA[1]) fprintf(fp, "%10d", da1Data[scn+1] - DA_00 );
 
     fprintf(fp, "\n");
     chn = 0;
@@ -922,6 +1650,31 @@ void save_data ( char *argv[], char *title, unsigned nChnl,
 
   fclose(fp);
   chOwnGrpMod( adDataFilename, 0444 ); 
+  if ( acq.sched.nGroup )             // the slow channels, with their scans
+    sched_save ( &acq.sched, adDataFilename, title, sr, nScan );
+  skew_save ( &acq.skew, adDataFilename, title, sr ); // the aligned channels
+
+  /* data statistics, each channel contiguous in a block at a time */
+
+  for (chn = 0; chn < NUMCHNL; chn++)  
+    avg[chn] = rms[chn] = max[chn] = min[chn] = 0.0;
+
+  chnlData = i32vector ( 0, acq.adData.blockScans * nChnl );
+  for (scn = 0, b = 0; (n = store_channels ( &acq.adData, b, chnlData )) > 0; b++) {
+    for (chn = 0; chn < nChnl; chn++) {
+      x = chnlData + chn*n;
+      for (i = 0; i < n; i++) {
+        data_value = (double) x[i];
+        if ( scn+i <= 20 ) max[chn] = min[chn] += data_value/20;
+        avg[chn] += data_value;
+        rms[chn] += data_value * data_value;
+        if (data_value > max[chn]) max[chn] = data_value; 
+        if (data_value < min[chn]) min[chn] = data_value; 
+      }
+    }
+    scn += n;
+  }
+  free_i32vector ( chnlData, 0, 1 );
   
   /* display data statistics to screen */
 
@@ -982,6 +1735,9 @@ void save_data ( char *argv[], char *title, unsigned nChnl,
   color(1); color(37); fprintf(stderr,"/");
   color(1); color(31); fprintf(stderr,"n  ");
   color(1); color(37);
+  if ( daemon_running() )                        // hpgdaacd ... always keep
+    fprintf(stderr,"\n");
+  else
   while((ch = getchar()) != EOF ) {
     if (ch != ' ' && ch != '\t'  && ch != '\n' ) break; 
   }
@@ -992,6 +1748,8 @@ void save_data ( char *argv[], char *title, unsigned nChnl,
     color(1); color(35); fprintf(stderr,"\n");
     if (remove(adDataFilename) == 0) {
       fprintf(stderr,"  %s deleted successfully.", adDataFilename);
+      sched_remove ( &acq.sched, adDataFilename );
+      skew_remove ( &acq.skew, adDataFilename );
     } else {
       color(1); color(31); fprintf(stderr,"\n");
       fprintf(stderr,"  Unable to delete %s", adDataFilename);
@@ -1069,10 +1827,30 @@ void error_msg ( char err_string[] )
 ------------------------------------------------------------------------------*/
 void good_bye ( int de_alloc, int da0, int da1 )
 {
-  if ( de_alloc ) {
-    free_i32vector ( adData,  0, 1 );
-    if ( da0 || CONTROL_DA0)  free_u16vector ( da0Data, 1, 1 );
-    if ( da1 || CONTROL_DA1)  free_u16vector ( da1Data, 1, 1 );
+  if ( de_alloc || daemon_running() ) {
+    store_free ( &acq.adData );
+    if ( control )  free_controller ( &ctrl );
+    sched_free ( &acq.sched );
+    skew_free ( &acq.skew );
+    arena_close ( &arena );              // the samples, D/A, and groups
+    acq.daData[0] = acq.daData[1] = NULL;
+#if GRAPHICS
+    if (graphics)  plot_close ();
+#endif  // GRAPHICS
+  }
+  stream_close ();
+  shm_ring_close ();
+
+  if ( daemon_running() ) {    // hpgdaacd ... keep the board, next test
+    int  ok = testOK;
+    acq.daData[0] = acq.daData[1] = NULL;
+    acq.smpl = 0;  acq.scan = 1;  acq.nFirst = 0;
+    acq.ctrl = NULL;  acq.loopDA = acq.loopChnl = -1;
+    control = loopback = graphics = testOK = 0;
+    ctrlDA[0] = ctrlDA[1] = 0;
+    acq.daLoop = DA_00;
+    memset ( &ctrl, 0, sizeof(ctrl) );
+    daemon_next_test ( ok );
   }
 /*
   out_w ( DALO0, DA_00 << 4 );
@@ -1098,314 +1876,4 @@ void good_bye ( int de_alloc, int da0, int da1 )
 */
 
 
-#if GRAPHICS
-
-/* plot_setup 
- * set up axes scaled to volts and seconds
- * Jesse Hoagg, Fall 2001
- * --------------------------------------------------------------------------*/
-void plot_setup ( float *xunit,  float *yunit, float *xo, float *yo,
-                  float xmin, float xmax, uint8_t *rangeCode, 
-                  char title[], char Xlabel[], char Ylabel[],
-                  int8_t nChnl, struct CHNL chnl[] )
-{
-  float     ymax = +1.0,                //  ADMAX-ADMID, // fractional range
-            ymin = -0.0;                //  ADMIN-ADMID; // 0.0;   
-  uint8_t   i, chn; 
-  int16_t   XB = 25,  YB = 25,          // left and top border for plotting
-            dx, dy, xh, yh;             // hatch increments and locations
-  char      ht[NUMCHNL];                // hatch text label
-
-  xcb_screen_t        *screen;
-  xcb_segment_t        ll[] = { {0,0 , 0,0} };
-  xcb_generic_event_t *event;
-
-  uint32_t  gc_mask = 0;                  // graphic context mask
-  uint32_t  gc_value[2]  = { 0 , 0 };     // graphic context values
-  uint32_t  textClr = 0xecddc6e;          // text and background color
-  uint32_t  axisClr[2] = {0x73c4ba, 0x0}; // axis line color  
-  // empacher    0xecdc6e
-  // bruel+kjaer 0x73c4ba
-
-   if ( chnl[0].negPin >= 0 ) ymin = -1.0;  // differential inputs
-
-// Calculate the pixel size of each x and y unit, 
-// the placement of the axis, and size of axis divisions
-// The screen size is SCREEN_W by SCREEN_H.
-// The origin is in the upper left corner.
-  *xunit = (SCREEN_W-XB)/(xmax-xmin);     // display space / value space
-//*yunit = (SCREEN_H-YB)/(ymax-ymin);     // display space / value space (bp)
-  *yunit = (SCREEN_H-2*YB)/(ymax-ymin);   // display space / value space (up)
-
-// location of the coordinate system in the display space
-  *xo = XB + (*xunit)*(-xmin);         
-  *yo = YB + (*yunit)*(ymax);
-  dx = (int16_t)( MAX ( SCREEN_W - *xo , *xo - XB )/10.0 ); // x-hatch increment
-  dy = (int16_t)( MAX ( SCREEN_H - *yo , *yo - YB )/ 5.0 ); // y-hatch increment
-
-/* ------------------------------------------ 
-//  check values for setting up the graph
-printf("----------------------------\n");
-printf(" SCREEN_W = %d \n", SCREEN_W);
-printf(" xmin = %f \n", xmin );
-printf(" xmax = %f \n", xmax );
-printf(" xo = %f \n", *xo);
-printf(" xu = %f \n", *xunit);
-printf(" dx = %d \n", dx);
-printf("----------------------------\n");
-printf(" SCREEN_H = %d \n", SCREEN_H);
-printf(" ymin = %f \n", ymin );
-printf(" ymax = %f \n", ymax );
-printf(" yo = %f \n", *yo);
-printf(" yu = %f \n", *yunit);
-printf(" dy = %d \n", dy);
-printf("----------------------------\n");
-printf(" title = %s \n", title);
-printf(" x-axis label: %s \n", Xlabel );
-printf(" y-axis label: %s \n", Ylabel );
-printf("----------------------------\n\n");
- ------------------------------------------ */
-
-  // initialize XCB
-
-  // open the connection to the X server 
-  connection = xcb_connect (NULL, NULL);
-
-  // get the first screen, window, and foreground 
-  screen     = xcb_setup_roots_iterator (xcb_get_setup (connection)).data;
-  window     = screen->root;
-  foreground = xcb_generate_id (connection);
-
-  // create a graphic context with window foreground and exposure
-  gc_mask = XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES ;
-  gc_value[0] = 0xFF;
-  gc_value[1] = 0x0;
-  xcb_create_gc (connection, foreground, window, gc_mask, gc_value);
-
-  // get the window id 
-  window = xcb_generate_id (connection);
-
-  // create a graphic context for window background and events 
-  gc_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
-  gc_value[0] = screen->black_pixel;  
-  gc_value[1] = XCB_EVENT_MASK_EXPOSURE;
-
-  // create the window 
-  xcb_create_window ( connection,                    /* connection      */
-                      XCB_COPY_FROM_PARENT,          /* depth           */
-                      window,                        /* window Id       */
-                      screen->root,                  /* parent window   */
-                      0, SCREEN_H/2,                 /* x, y            */
-                      SCREEN_W, SCREEN_H,            /* width, height   */
-                      10,                            /* border_width    */
-                      XCB_WINDOW_CLASS_INPUT_OUTPUT, /* class           */
-                      screen->root_visual,           /* visual          */
-                      gc_mask, gc_value );           /* mask and values */
-
-  // map the window onto the connection and flush the connection
-  xcb_map_window (connection, window);
-
-  gc_mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y; /* window position */
-  gc_value[0] = SCREEN_X;
-  gc_value[1] = SCREEN_Y;
-
-  xcb_configure_window( connection, window, gc_mask, gc_value );
-
-  xcb_flush (connection);
-
-  // change the title of the window
-  xcb_change_property(connection,
-        XCB_PROP_MODE_REPLACE,
-        window,
-        XCB_ATOM_WM_NAME,
-        XCB_ATOM_STRING,
-        8,
-        strlen(title),
-        title);
-   xcb_flush (connection);
-
-  // wait (twice ?? (no 20240217) for an "event" and capture it
-  event = xcb_wait_for_event (connection);
-  event = xcb_wait_for_event (connection);
-
-  // change the graphic context for line colors
-  gc_mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND ;
-  xcb_change_gc  (connection, foreground, gc_mask, axisClr );
-
-  // x-axis coordinate line 
-  ll->x1 =  XB;
-  ll->y1 = (int16_t)(*yo); 
-  ll->x2 =  SCREEN_W; 
-  ll->y2 = (int16_t)(*yo);
-//printf(" lx = %d %d %d %d \n", (int)(ll->x1), (int)(ll->y1), (int)(ll->x2), (int)(ll->y2) ); // debug
-  xcb_poly_segment (connection, window, foreground, 1, ll );
-
-  // y-axis coordinate line 
-  ll->x1 = (int16_t)(*xo);
-  ll->y1 =  YB; 
-  ll->x2 = (int16_t)(*xo);
-  ll->y2 =  SCREEN_H-YB;
-//printf(" ly = %d %d %d %d \n", (int)(ll->x1), (int)(ll->y1), (int)(ll->x2), (int)(ll->y2) ); //debug
-  xcb_poly_segment (connection, window, foreground, 1, ll );
-
-  // hatch marks and numbering on the positive x axis
-  for (i=1; i<10; i++) {
-    xh = (int16_t)(*xo+i*dx); 
-    if (xh > SCREEN_W)  
-      break;
-    sprintf( ht, "%.1f", (xh-*xo)/(*xunit) );   // x-hatch text
-    ll->x1 = xh,
-    ll->y1 = (int16_t)(*yo-YB/5)  ; 
-    ll->x2 = xh,
-    ll->y2 = (int16_t)(*yo+YB/5);
-    xcb_poly_segment (connection, window, foreground, 1, ll );
-    draw_text (connection, screen, window, xh+3,(int16_t)(*yo+12), textClr,0x0, ht);
-  }
-  // hatch marks and numbering on the negative x axis
-  for (i=1; i<10; i++) {
-    xh = (int16_t)(*xo-i*dx); 
-    if (xh < XB)  
-      break;
-    sprintf( ht, "%.1f", (*xo-xh)/(*xunit) );   // x-hatch text
-    ll->x1 = xh,
-    ll->y1 = (int16_t)(*yo-YB/5)  ; 
-    ll->x2 = xh;
-    ll->y2 = (int16_t)(*yo+YB/5);
-    xcb_poly_segment (connection, window, foreground, 1, ll );
-    draw_text (connection, screen, window, xh+3,(int16_t)(*yo+12), textClr,0x0, ht);
-  }
-  // hatch marks and numbering on the positive y axis
-  for (i=1; i<5; i++) {
-    yh = (int16_t)(*yo-i*dy); 
-    if (yh < YB)  
-      break;
-    sprintf( ht, "%4.1f", (*yo-yh)/(*yunit) );   // y-hatch text
-    ll->x1 = (int16_t)(*xo-XB/5)  ; 
-    ll->y1 = yh,
-    ll->x2 = (int16_t)(*xo+XB/5);
-    ll->y2 = yh,
-    xcb_poly_segment (connection, window, foreground, 1, ll );
-    draw_text (connection, screen, window, (int16_t)(*xo-XB), yh-3, textClr,0x0,ht);
-  }
-  // hatch marks and numbering on the negative y axis
-  for (i=1; i<5; i++) {
-    yh = (int16_t)(*yo+i*dy); 
-    if (yh > SCREEN_H)  
-      break;
-    sprintf( ht, "%4.1f", (*yo-yh)/(*yunit) );   // y-hatch text
-    ll->x1 = (int16_t)(*xo-XB/5)  ; 
-    ll->y1 = yh,
-    ll->x2 = (int16_t)(*xo+XB/5);
-    ll->y2 = yh,
-    xcb_poly_segment (connection, window, foreground, 1, ll );
-    draw_text (connection, screen, window, (int16_t)(*xo-XB), yh-3, textClr,0x0,ht);
-  }
-
-// draw title and axis labels 
-//draw_text (connection,screen,window, SCREEN_W/4, YB/2, textClr,0x0, title );
-  draw_text (connection,screen,window, (int)(0.95*SCREEN_W),*yo+YB/2, textClr,0x0, Xlabel);
-  draw_text (connection,screen,window, (int)(XB/2),(int)(YB-6), textClr,0x0, "full scale" );
-
-  //  Display the channel labels in color of the lines.
-  gc_mask     = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
-  for ( chn = 0; chn < nChnl; chn++ ) {
-//  sprintf(chnl[chn].label, "channel %2d", chn); // debug
-    gc_value[0] = CHNL_COLR[chn];
-    xcb_change_gc  (connection, foreground, gc_mask, gc_value);
-    draw_text (connection, screen, window,
-            SCREEN_W-100, YB+15*(chn+1), CHNL_COLR[chn],0x0, chnl[chn].label );
-  }
-
-  fprintf(stderr," plot set up  . . . . . . . . . . . . . . . . . . . . . . . . . .  success \n"); 
-  return;
-}
-
-
-/*
- * plot_data - plot a scan of data points scaled to volts and seconds
- * -------------------------------------------------------------------------*/
-void plot_data ( int8_t nChnl, float sr, unsigned scn,  int32_t adData[],
-                 float xo, float yo, float xu, float yu, uint8_t *rangeCode)
-{
-  uint8_t        chn;
-  xcb_point_t    p = {0,0};
-  
-  uint32_t gc_mask     = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
-  uint32_t gc_value[2] = { 0x0 , 0x0 };
-
-//delay_us(10);
-  for (chn = 0; chn < nChnl; chn++) {
-
-    p.x = (int16_t)(xo+xu*(scn/sr));
-    p.y = (int16_t)(yo-yu*((adData[scn*nChnl+chn-1]))/ADMAX);
-//  p.y = (int16_t)(yo-yu*((ADMID)*voltRange/ADMAX));   // bi-polar AtoD
-
-//  fprintf(stderr," ... p.x = %5" PRId16 "  p.y = %5" PRId16 "\n", p.x, p.y );
-
-    gc_value[0] = CHNL_COLR[chn];
-    xcb_change_gc  (connection, foreground, gc_mask, gc_value);
-    xcb_poly_point (connection, XCB_COORD_MODE_ORIGIN, window, foreground,1,&p);
-
-/*
-    if ( scn>0 ) line( display,
-    (int)(y_axis+xu*((scn-1)/sr-xoff)) ,
-    (int)(x_axis-yu*((adData[scn*nChnl+i-nChnl]-0x8000)*voltRange/32567-yoff)) ,
-    (int)(y_axis+xu*(scn/sr-xoff)) , 
-    (int)(x_axis-yu*((adData[scn*nChnl+i]-0x8000)*voltRange/32576-yoff)) , i );
-*/
-  }             
-  xcb_flush (connection);      // wait for all N_smpls samples before flushing
-  return;
-}
-
-
-/*
- * plot_bffr_data - plot a scan of data points scaled to volts and seconds
- * -------------------------------------------------------------------------*/
-void plot_bffr_data ( int8_t firstChnl, int8_t lastChnl, unsigned nChnl,
-                     float sr, unsigned nBffr, unsigned spl,  uint16_t adData[],
-                     float xo, float yo, float xu, float yu, uint8_t *rangeCode)
-{
-  unsigned       firstScn = (unsigned)((float)(spl-nBffr)/nChnl),
-                 lastScn  = (unsigned)((float)spl/nChnl),
-                 scn, chn,sp;
-  xcb_point_t    p = {0,0};
-  
-  uint32_t gc_mask     = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
-  uint32_t gc_value[2] = { 0x0 , 0x0 };
-
-//delay_us(10);
-  sp=0;
-  for (scn = firstScn; scn <= lastScn; scn++) {
-    p.x = (int16_t)(xo+xu*(scn/sr));
-    for (chn = firstChnl; chn <= lastChnl; chn++) {
-
-//    p.y = (int16_t)(yo-yu*((adData[scn*nChnl+chn])*voltRange/ADMAX));
-//    p.y = (int16_t)(yo-yu*((ADMID)*voltRange/ADMAX));   // bi-polar AtoD
-      p.y = (int16_t)(yo-yu*((float)(adData[spl-nBffr+sp])/ADMID-1.0)); // bi-polar AtoD
-
-//rintf(stderr," scn= %4d chn= %4d sp=%4d  data=%d ... p.x= %6d  p.y= %6d \n", scn, chn,  spl-nBffr+sp, adData[scn*nChnl+chn], p.x, p.y );
-
-      gc_value[0] = CHNL_COLR[chn];
-      xcb_change_gc  (connection, foreground, gc_mask, gc_value);
-      xcb_poly_point (connection, XCB_COORD_MODE_ORIGIN, window, foreground,1,&p);
-      ++sp;
-
-/*
-      if ( scan>0 ) line( display,
-      (int)(y_axis+xu*((scan-1)/sr-xoff)) ,
-      (int)(x_axis-yu*((adData[scan*nChnl+i-nChnl]-0x8000)*voltRange/32567-yoff)) ,
-      (int)(y_axis+xu*(scan/sr-xoff)) , 
-      (int)(x_axis-yu*((adData[scan*nChnl+i]-0x8000)*voltRange/32576-yoff)) , i );
-*/
-    }
-    if ( sp >= nBffr )  break; 
-  }             
-  xcb_flush (connection);      // wait for all N_smpls samples before flushing
-  return;
-}
-
-#endif  // GRAPHICS
-
-
 #undef  MAXL
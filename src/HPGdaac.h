@@ -12,6 +12,7 @@
 
 #ifndef _HPADDAGC_H_
 #define _HPADDAGC_H_
+#include <time.h>             // time_t
 #include "HPADDAlib.h"        // High-Performance AD/DA library files
 
 // coordinates of screen position and screen dimentions
@@ -21,8 +22,10 @@
 #define SCREEN_H   590
 
 #define MAXL       256   /* maximum line length allowed for title & sens */
+#define ACQ_MAXAD (NUMCHNL/8) /* ADS1256 on the SPI bus, the board's and others */
 
 #define MAX(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a > _b ? _a : _b; })
+#define MIN(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a < _b ? _a : _b; })
 
   struct CHNL {        // channel information
          char label[MAXL];     // channel description
@@ -40,13 +43,82 @@
 
   extern struct CHNL chnl[NUMCHNL];
 
-  struct CTRLCNST {     // control constants for feedback control
-         char label[MAXL];     // control constant label
-         float val;            // control constant value
-      };
+#include "HPGplugin.h"       // struct CTRLCNST, controller plug-in interface
 
   extern struct CTRLCNST ctrlCnst[16];
 
+  struct OPTIONS {      // optional "label : value" lines of the configuration
+         char ctrlFilename[MAXL];  // controller data file name, "" for none
+         int  loopDA, loopChnl;    // loopback latency test D/A and A/D, or -1
+         float stripSec;           // strip chart window, seconds, 0 for none
+         int  graphics;            // 1: plot in real time, 0: headless
+         char streamAddr[MAXL];    // stream socket path or port, "" for none
+         char shmName[MAXL];       // shared memory ring name, "" for none
+         int  calMode;             // CAL_OFF, CAL_CACHED, or CAL_FRESH
+         unsigned rateDiv[NUMCHNL];// rate divisor of each channel, 1: every scan
+         uint8_t  convAvg[NUMCHNL];// conversions averaged in each scan, 1: none
+         uint8_t  cnv[NUMCHNL];    // ADS1256 of each channel, 0: the board's
+         unsigned nCnv;            // ADS1256 on the bus, 1 + the Pins triples
+         uint8_t  cnvPins[ACQ_MAXAD][3]; // CS, DRDY, RESET of ADS1256 1, 2, ...
+         int  pacing;              // PACE_TIMER or PACE_DRDY
+         int  align;               // 1: channels aligned in time, .aln file
+         unsigned charScans;       // scans at each setting of HPGdaac -c
+         int  plan;                // PLAN_CHECK or PLAN_AUTO
+         int  packed;              // 1: samples packed in 24 bits, HPGstore
+         int  huge;                // 1: the buffers on huge pages, HPGarena
+      };
+
+#define PACE_TIMER   0    /* scans started by the interval timer, ualarm     */
+#define PACE_DRDY    1    /* scans started by the ADS1256 conversion clock   */
+
+  extern struct OPTIONS opts;
+
+#include "HPGsched.h"        // struct SCHED, multi-rate scan schedule
+#include "HPGskew.h"         // struct SKEW, conversion instants
+#include "HPGstore.h"        // struct STORE, blocks of samples
+#include "HPGlatency.h"      // struct LATENCY, control path latency
+
+  struct ACQ {          // the acquisition of a test on one or more ADS1256
+         struct ADS1256 *ad[ACQ_MAXAD]; // the converters, ad[0] paces the scans
+         struct DAC8532 *da;            // the D/A converter
+         unsigned nAd;                  // number of converters
+         unsigned nChnl;                // number of channels
+         uint8_t  muxCode[NUMCHNL],     // mux code of each channel
+                  rangeCode[NUMCHNL],   // voltage range code of each channel
+                  cnv[NUMCHNL];         // converter of each channel, in ad[]
+         unsigned nFirst,               // control channels, scanned first
+                  scanOrder[NUMCHNL];   // channel numbers in the order scanned
+         uint8_t  muxOrder[NUMCHNL],    // mux codes in the order scanned
+                  rangeOrder[NUMCHNL],  // range codes in the order scanned
+                  avgOrder[NUMCHNL],    // conversions averaged, in the order scanned
+                  cnvOrder[NUMCHNL];    // converters, in the order scanned
+         int32_t  adOrder[NUMCHNL];     // A-to-D data in the order scanned
+         uint64_t tConv[NUMCHNL];       // conversion instants in the order scanned
+         struct SCHED sched;            // channels converted in each scan
+         struct SKEW  skew;             // conversion instants, aligned channels
+         struct STORE adData;           // A-to-D data, in blocks of scans
+         int32_t  adScan[NUMCHNL];      // A-to-D data in a single scan
+         uint32_t smpl,                 // current sample number
+                  scan;                 // current scan   number
+         unsigned convScan;             // conversions in the last scan
+         uint64_t convDone;             // system timer at its last conversion, us
+         unsigned nScan;                // scans of the test
+         float    sr;                   // scan rate, measured with DRDY pacing
+         uint16_t *daData[2];           // D-to-A data of each D/A, 1 to nScan
+         int      daFile[2];            // 1: the D/A written from its file
+         struct CTRL *ctrl;             // feedback controller, NULL for none
+         uint16_t daCtrl[2];            // controller outputs for the D/A
+         int      loopDA, loopChnl;     // loopback D/A and A/D channel, or -1
+         uint16_t daLoop,               // loopback D/A value
+                  daStep;               // loopback D/A step
+         int32_t  adStep;               // expected loopback A/D step
+         struct LATENCY latAdDa,        // end of control A/D to D/A written
+                        latScanDa,      // start of scan to D/A written
+                        latLoop;        // D/A written to A/D conversion, loopback
+      };
+
+  extern struct ACQ acq;
+
 /* read configuration file, open output data file  */
 int read_configuration( int argc, 
                         char *argv[], 
@@ -64,7 +136,12 @@ int read_configuration( int argc,
                         char *da0fn, 
                         char *da1fn,
                         char *sensiFilename, 
-                        struct CTRLCNST *ctrlCnst ); 
+                        struct CTRLCNST *ctrlCnst,
+                        struct OPTIONS *opts ); 
+
+/* read the optional lines at the end of the configuration file  */
+int read_options ( FILE *fp, 
+                   struct OPTIONS *opts );
 
 /* read sensor sensitivity data file        */
 int read_sensitivity ( char *argv[], 
@@ -82,16 +159,57 @@ void read_da_file ( int da,
                     unsigned nScan, 
                     uint16_t  *daData );
 
-/* sample statistics of  nScan pretest data scans */
-void pretest_sample_stats( struct CHNL *chnl, 
+/* ad[0] the board's ADS1256, and ad[1..nCnv-1] the others on the bus,
+   opened on the pins of the Pins line.  returns 0: ok  1: abnormal */
+int  open_converters ( struct ADS1256 *ad[],
+                       struct OPTIONS *opts );
+
+/* the data rate, the first gain and the calibrations of each converter
+   ad[k] for the ranges of its channels, cnv[chn] == k;  returns the data
+   rate set, 0 if a calibration failed */
+float setup_converters ( struct ADS1256 *ad[],
+                         unsigned nAd,
+                         unsigned nChnl,
+                         uint8_t cnv[],
+                         uint8_t rangeCode[],
+                         float drate,
+                         int calMode );
+
+/* sample statistics of  nScan pretest data scans, channel chn on the
+   converter ad[cnv[chn]] */
+void pretest_sample_stats( struct ADS1256 *ad[],
+                           uint8_t cnv[],
+                           struct CHNL *chnl, 
                            unsigned nChnl, 
                            uint8_t muxCode[],
+                           uint8_t rangeCode[],
                            unsigned nScan );
 
 
+/* scan order with the control channels first, and the shortest planned
+   scan at data rate drate, the channels of each converter together */
+unsigned set_scan_order ( unsigned nChnl,
+                          uint8_t muxCode[],
+                          uint8_t rangeCode[],
+                          uint8_t convAvg[],
+                          uint8_t cnv[],
+                          float drate,
+                          int calOn,
+                          unsigned scanOrder[],
+                          uint8_t muxOrder[],
+                          uint8_t rangeOrder[] );
+
 /* collect an observation, store it, process it, output controls, plot */
 void AD_write_process_DA_plot(int signum);
 
+/* one scan of acquisition q ... convert, control, store, and plot */
+void scan_acq ( struct ACQ *q );
+
+/* run the scans of acquisition q on the conversion clock of its ad[0] */
+void pace_drdy ( struct ACQ *q,
+                 unsigned convPerScan,
+                 float drate );
+
 /* write analog-to-digital (A-to-D) data files       */
 void save_data ( char *argv[], 
                  char *title, 
@@ -121,86 +239,4 @@ void good_bye ( int de_alloc,
 
 // float time_out ( struct time start, struct time stop );
 
-/* compute state matrices      */
-void state_matrices ( float *xc, 
-                      float *xc1, 
-                      float *dxcdt, 
-                      float *y,
-                      float *constants, 
-                      float csr );
-
-/* continuous time to discrete time */
-void c2d ( float **Ac, 
-           float **Bc, 
-           float csr );
-
-/* compute state derivative    */
-void state_deriv ( float *y, 
-                   float *xc, 
-                   float *dxcdt );
-
-/* 4th Order Runge-Kutta Method */
-void rk4 ( float *y, 
-           float *dydx, 
-           int n, 
-           float h, 
-           float vi, 
-           float *yout,
-	   void (*derivs)() );
-
-/* simulate discrete time systm */
-void DT_sim ( float *xc1, 
-              float *xc, 
-              float *y );
-
-/* control rule                 */
-void control_rule ( float V_out, 
-                    float *xc1, 
-                    float *y, 
-                    float *constants );
-
-/* sign of a value */
-float   sgn( float x );
-
-
-/* set up a plot screen */
-void plot_setup ( float    *xunit,
-                  float    *yunit,
-                  float    *xo,
-                  float    *yo,
-                  float     xmin,
-                  float     xmax,
-                  uint8_t  *rangeCode,
-                  char      title[],
-                  char      xLabel[],
-                  char      yLabel[],
-                  int8_t    nChnl,
-                  struct CHNL chnl[] );
-
-/* plot a scan of data points */
-void plot_data ( int8_t     nChnl,
-                 float      sr,
-                 unsigned   scan,
-                 int32_t    adData[],
-                 float      xo,
-                 float      yo,
-                 float      xu,
-                 float      yu,
-                 uint8_t   *rangeCode );
-
-/* plot a buffer of data points */
-void plot_bffr_data ( int8_t     firstChnl,
-                      int8_t     lastChnl,
-                      unsigned   nChnl,
-                      float      sr,
-                      unsigned   nBffr,
-                      unsigned   spl,
-                      uint16_t   adData[],
-                      float      xo,
-                      float      yo,
-                      float      xu,
-                      float      yu,
-                      uint8_t   *rangeCode );
-
-
 #endif // _HPADDAGC_H_ 
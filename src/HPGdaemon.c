@@ -0,0 +1,337 @@
+/*******************************************************************************
+HPGdaemon.c
+hpgdaacd, a resident HPGdaac that keeps the board ready between tests
+
+    sudo HPGdaac -d [socket]                       start the daemon
+    HPGdaac -r [-s socket] test1.cfg data1.out [test2.cfg data2.out ...]
+
+The daemon initializes the bcm2835 library and the ADS1256 once, then
+accepts run requests on a Unix-domain socket, one at a time, so requests
+from one or more clients run back-to-back.  For each request it changes to
+the working directory of the client, runs the test with the output of
+HPGdaac sent to the client, and ends with the line HPGD_OK or HPGD_FAILED.
+A client that does not send its request within HPGD_WAIT_S seconds is
+dropped, and while the test runs the socket does not block, so output a
+client is too slow to read is lost rather than holding up the test.
+
+Any user may send a request; the client gives up root before it connects,
+and the daemon takes the user and group of the client from the socket
+(SO_PEERCRED).  The test runs with that user as the real user and reaches
+the file system as that user (HPGuser.c), so it reads and writes only the
+files that user could, and its data files belong to that user.  The
+socket is created by the daemon, which refuses to start if something other
+than the socket of an earlier daemon that has stopped is at its path.
+Tests run by the daemon do not ask "ready?" or "keep file?", do not plot
+(use the stream or the shared memory ring for live displays), and leave
+both D/A outputs at zero volts.
+
+An error that would end HPGdaac calls good_bye(), which, in the daemon,
+releases the memory of the test and returns here with longjmp, so one bad
+configuration file does not stop the daemon.  SIGINT or SIGTERM stops the
+daemon between tests.  The daemon stays in the foreground, for systemd.
+*******************************************************************************/
+
+#define _GNU_SOURCE                   // struct ucred
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // getenv
+#include <string.h>         // standard string handling library
+#include <errno.h>          // errno
+#include <signal.h>         // sigaction
+#include <setjmp.h>         // setjmp, longjmp
+#include <unistd.h>         // dup, dup2, chdir, getcwd
+#include <fcntl.h>          // fcntl, O_NONBLOCK
+#include <sys/socket.h>     // socket, bind, listen, accept
+#include <time.h>           // time
+#include <sys/time.h>       // struct timeval
+#include <sys/stat.h>       // lstat, umask
+#include <sys/un.h>         // struct sockaddr_un
+
+// local libraries .. .
+#include "HPGdaac.h"                  // MAXL, HPADDAlib
+#include "HPGdaemon.h"                // header for hpgdaacd
+#include "HPGuser.h"                  // user_set, user_fs
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+static jmp_buf               testEnv;     // the daemon, between tests
+static int                   inTest = 0;  // 1: a test is running
+static volatile sig_atomic_t stop = 0;    // SIGINT or SIGTERM received
+
+
+/* DAEMON_RUNNING - 1 while hpgdaacd is running a test               19oct26
+---------------------------------------------------------------------------*/
+int daemon_running ( void )
+{
+  return inTest;
+}
+
+
+/* DAEMON_NEXT_TEST - return from good_bye() to the daemon           19oct26
+---------------------------------------------------------------------------*/
+void daemon_next_test ( int ok )
+{
+  longjmp ( testEnv, ok ? 1 : 2 );
+}
+
+
+/* STOP_DAEMON - SIGINT and SIGTERM handler
+---------------------------------------------------------------------------*/
+static void stop_daemon ( int signum )
+{
+  (void) signum;
+  stop = 1;
+}
+
+
+/* READ_REQUEST - one line "cwd<TAB>config<TAB>data" from the client,
+   within HPGD_WAIT_S seconds    0: ok, 1: not a request, or too late  19oct26
+---------------------------------------------------------------------------*/
+static int read_request ( int fd, char *cwd, char *cfg, char *data )
+{
+  char     line[3*MAXL+4], *f[3], *p;
+  size_t   n = 0;
+  ssize_t  r;
+  int      k;
+  time_t   late = time ( NULL ) + HPGD_WAIT_S;
+
+  while ( n < sizeof(line)-1 ) {           // to the end of the line
+    if ( (r = read ( fd, line+n, 1 )) <= 0 || time ( NULL ) > late )  return 1;
+    if ( line[n++] == '\n' )  break;
+  }
+  line[n] = '\0';
+  line[strcspn ( line, "\n" )] = '\0';
+
+  for (p=line, k=0; k<3; k++) {
+    f[k] = p;
+    if ( (p = strchr ( p, '\t' )) != NULL )  *p++ = '\0';
+    else if ( k < 2 )  return 1;
+  }
+  for (k=0; k<3; k++)
+    if ( f[k][0] == '\0' || strlen ( f[k] ) >= MAXL )  return 1;
+  strcpy ( cwd, f[0] );   strcpy ( cfg, f[1] );   strcpy ( data, f[2] );
+  return 0;
+}
+
+
+/* STALE_SOCKET - 1 if there is a socket of root at the path of un that no
+   daemon answers, left by an earlier daemon that stopped            19oct26
+---------------------------------------------------------------------------*/
+static int stale_socket ( struct sockaddr_un *un )
+{
+  struct stat  st;
+  int          fd, stale;
+
+  if ( lstat ( un->sun_path, &st ) || !S_ISSOCK ( st.st_mode ) ||
+       st.st_uid != 0 )  return 0;
+  if ( (fd = socket ( AF_UNIX, SOCK_STREAM, 0 )) < 0 )  return 0;
+  stale = connect ( fd, (struct sockaddr *) un, sizeof(*un) ) &&
+          errno == ECONNREFUSED;
+  close ( fd );
+  return stale;
+}
+
+
+/* CLIENT_BLOCKS - make the client socket fd block, with reads and writes
+   that give up after HPGD_WAIT_S seconds (on = 1), or not block at all
+   (on = 0), while a test writes to it                               19oct26
+---------------------------------------------------------------------------*/
+static void client_blocks ( int fd, int on )
+{
+  struct timeval  tv = { HPGD_WAIT_S, 0 };
+  int             flags = fcntl ( fd, F_GETFL );
+
+  setsockopt ( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+  setsockopt ( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv) );
+  fcntl ( fd, F_SETFL, on ? flags & ~O_NONBLOCK : flags | O_NONBLOCK );
+}
+
+
+/* DAEMON_SERVE - initialize the board once, then run the requested tests
+   until SIGINT or SIGTERM.   0: stopped by a signal, 1: failed       19oct26
+---------------------------------------------------------------------------*/
+int daemon_serve ( char *sockPath )
+{
+  struct sockaddr_un  un;
+  struct sigaction    sa;
+  struct stat         st;
+  struct ucred        peer;
+  socklen_t peerLen;
+  mode_t    mask;
+  int       listenFd, fd, outFd, errFd, status;
+  unsigned  nTest = 0;
+  char      cwd[MAXL], cfg[MAXL], data[MAXL];
+  char     *argv[4];
+
+  if ( strlen ( sockPath ) >= sizeof(un.sun_path) ) {
+    errorMsg ( "  hpgdaacd: the socket path is too long" );
+    return 1;
+  }
+
+  memset ( &sa, 0, sizeof(sa) );            // no SA_RESTART, so accept()
+  sa.sa_handler = stop_daemon;              // returns on a signal
+  sigaction ( SIGINT,  &sa, NULL );
+  sigaction ( SIGTERM, &sa, NULL );
+  signal ( SIGPIPE, SIG_IGN );              // a client that went away
+
+  memset ( &un, 0, sizeof(un) );
+  un.sun_family = AF_UNIX;
+  strcpy ( un.sun_path, sockPath );
+  if ( lstat ( sockPath, &st ) == 0 ) {
+    if ( !stale_socket ( &un ) ) {          // another daemon, or not ours
+      errorMsg ( "  hpgdaacd: the socket path is in use" );
+      fprintf(stderr,"  %s\n", sockPath );
+      return 1;
+    }
+    unlink ( sockPath );                    // left over from an earlier daemon
+  }
+  mask = umask ( 0111 );                    // 0666, any user may ask for a test
+  if ( (listenFd = socket ( AF_UNIX, SOCK_STREAM, 0 )) < 0 ||
+       bind ( listenFd, (struct sockaddr *) &un, sizeof(un) ) ||
+       listen ( listenFd, 16 ) ) {
+    umask ( mask );
+    errorMsg ( "  hpgdaacd: cannot open the socket" );
+    fprintf(stderr,"  %s  %s\n", sockPath, strerror ( errno ) );
+    if ( listenFd >= 0 )  close ( listenFd );
+    return 1;
+  }
+  umask ( mask );
+
+  if ( initHPADDAboard() ) {                // once, for every test
+    close ( listenFd );
+    unlink ( sockPath );
+    return 1;
+  }
+  DAC8532_Write ( &dac8532, 0, DA_00 );
+  DAC8532_Write ( &dac8532, 1, DA_00 );
+
+  color(1); color(32);
+  fprintf(stderr," hpgdaacd ready on %s\n", sockPath );
+
+  outFd = dup ( 1 );                        // the daemon's own output
+  errFd = dup ( 2 );
+  setvbuf ( stdout, NULL, _IOLBF, 0 );      // in order with stderr
+
+  while ( !stop ) {
+    if ( (fd = accept ( listenFd, NULL, NULL )) < 0 )  continue;  // EINTR
+    client_blocks ( fd, 1 );                // a silent client is dropped
+
+    peerLen = sizeof(peer);                 // the user who asked, as that user
+    if ( getsockopt ( fd, SOL_SOCKET, SO_PEERCRED, &peer, &peerLen ) ||
+         user_set ( peer.uid, peer.gid ) ) {
+      user_set ( geteuid(), getegid() );
+      (void) !write ( fd, HPGD_FAILED, strlen ( HPGD_FAILED ) );
+      close ( fd );
+      continue;
+    }
+    user_fs ( 1 );
+
+    if ( read_request ( fd, cwd, cfg, data ) || chdir ( cwd ) ) {
+      user_fs ( 0 );
+      user_set ( geteuid(), getegid() );
+      (void) !write ( fd, HPGD_FAILED, strlen ( HPGD_FAILED ) );
+      close ( fd );
+      continue;
+    }
+
+    fprintf(stderr," hpgdaacd test %u: user %u %s/%s -> %s\n", ++nTest,
+                    (unsigned) peer.uid, cwd, cfg, data );
+    fflush(stdout);  fflush(stderr);
+    client_blocks ( fd, 0 );                // a slow client loses output
+    dup2 ( fd, 1 );                         // HPGdaac output to the client
+    dup2 ( fd, 2 );
+
+    argv[0] = "HPGdaac";  argv[1] = cfg;  argv[2] = data;  argv[3] = NULL;
+    inTest = 1;
+    if ( (status = setjmp ( testEnv )) == 0 )
+      status = run_test ( 3, argv ) ? 2 : 1;   // returns only via good_bye()
+    inTest = 0;
+    user_fs ( 0 );                          // root again, between tests
+    user_set ( geteuid(), getegid() );
+    (void) !chdir ( "/" );
+
+    DAC8532_Write ( &dac8532, 0, DA_00 );   // zero volts between tests
+    DAC8532_Write ( &dac8532, 1, DA_00 );
+
+    client_blocks ( fd, 1 );                // the rest, as it can, in time
+    color(0);
+    fflush(stdout);  fflush(stderr);
+    clearerr(stdout);  clearerr(stderr);
+    if ( status == 1 )  (void) !write ( fd, HPGD_OK,     strlen ( HPGD_OK ) );
+    else                (void) !write ( fd, HPGD_FAILED, strlen ( HPGD_FAILED ) );
+    dup2 ( outFd, 1 );
+    dup2 ( errFd, 2 );
+    close ( fd );
+
+    fprintf(stderr," hpgdaacd test %u: %s\n", nTest, status == 1 ? "complete" : "stopped" );
+  }
+
+  close ( listenFd );
+  unlink ( sockPath );
+  closeHPADDAboard();
+  color(0); color(36);
+  fprintf(stderr," hpgdaacd stopped after %u tests\n", nTest );
+  return 0;
+}
+
+
+/* DAEMON_CLIENT - send each configuration file and data file pair to
+   hpgdaacd in turn, display the output of each test as it runs, and stop
+   at the first test that does not complete.   0: all complete       19oct26
+---------------------------------------------------------------------------*/
+int daemon_client ( char *sockPath, int nRun, char *runs[] )
+{
+  struct sockaddr_un  un;
+  char      cwd[MAXL], buf[4096], tail[64] = "";
+  ssize_t   n;
+  size_t    t;
+  int       fd, k;
+
+  if ( nRun < 1 || nRun % 2 ) {
+    errorMsg ( "  usage: HPGdaac -r [-s socket] <config file> <data file> ..." );
+    return 1;
+  }
+  if ( setgid ( getgid() ) || setuid ( getuid() ) ) {  // the daemon sees who
+    errorMsg ( "  HPGdaac -r: cannot give up root" );   // asks, not root
+    return 1;
+  }
+  if ( getcwd ( cwd, MAXL ) == NULL ) {
+    errorMsg ( "  HPGdaac -r: the working directory name is too long" );
+    return 1;
+  }
+  memset ( &un, 0, sizeof(un) );
+  un.sun_family = AF_UNIX;
+  strncpy ( un.sun_path, sockPath, sizeof(un.sun_path)-1 );
+
+  for (k=0; k<nRun; k+=2) {
+    if ( (fd = socket ( AF_UNIX, SOCK_STREAM, 0 )) < 0 ||
+         connect ( fd, (struct sockaddr *) &un, sizeof(un) ) ) {
+      errorMsg ( "  HPGdaac -r: hpgdaacd is not running" );
+      fprintf(stderr,"  %s  %s\n", sockPath, strerror ( errno ) );
+      return 1;
+    }
+    dprintf ( fd, "%s\t%s\t%s\n", cwd, runs[k], runs[k+1] );
+
+    tail[0] = '\0';
+    while ( (n = read ( fd, buf, sizeof(buf) )) > 0 ) {
+      (void) !write ( 2, buf, n );
+      t = strlen ( tail );                  // keep the last few characters
+      if ( n >= (ssize_t) sizeof(tail)-1 ) {
+        memcpy ( tail, buf + n - (sizeof(tail)-1), sizeof(tail)-1 );
+        tail[sizeof(tail)-1] = '\0';
+      } else {
+        if ( t + n > sizeof(tail)-1 ) {
+          memmove ( tail, tail + t + n - (sizeof(tail)-1), sizeof(tail)-1 - n );
+          t = sizeof(tail)-1 - n;
+        }
+        memcpy ( tail + t, buf, n );
+        tail[t+n] = '\0';
+      }
+    }
+    close ( fd );
+
+    t = strlen ( tail );
+    if ( t < strlen ( HPGD_OK ) || strcmp ( tail + t - strlen ( HPGD_OK ), HPGD_OK ) )
+      return 1;                             // stopped, or the daemon went away
+  }
+  return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGdaemon.h
+ *
+ *    Description:  header file for HPGdaemon.c
+ *                  hpgdaacd, a resident HPGdaac that keeps the board ready
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGDAEMON_H_
+#define _HPGDAEMON_H_
+
+#define HPGD_SOCKET  "/run/HPGdaacd.sock"  /* run requests, by default       */
+#define HPGD_OK      "HPGdaacd: test complete\n"  /* the last line of a run  */
+#define HPGD_FAILED  "HPGdaacd: test stopped\n"
+#define HPGD_WAIT_S  5      /* seconds a client may take to send or read   */
+
+/* run one test, the body of HPGdaac, in HPGdaac.c */
+int  run_test ( int argc,
+                char *argv[] );
+
+/* initialize the board once, then run tests on request until signalled */
+int  daemon_serve ( char *sockPath );
+
+/* send run requests to hpgdaacd and display their progress */
+int  daemon_client ( char *sockPath,
+                     int nRun,
+                     char *runs[] );
+
+/* 1 while hpgdaacd is running a test */
+int  daemon_running ( void );
+
+/* return from good_bye() to hpgdaacd, for the next test */
+void daemon_next_test ( int ok );
+
+#endif // _HPGDAEMON_H_
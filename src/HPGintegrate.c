@@ -0,0 +1,170 @@
+/*******************************************************************************
+HPGintegrate.c
+fixed step integrators for the real time control path
+
+All storage is allocated once, before the test, by ode_work_alloc() and
+ode_lti_setup().  The stepping functions ode_rk4(), ode_rk2(), and
+ode_lti_step() do not allocate memory, so they may be called from the
+scan handler.   Vectors and matrices are 0-indexed and matrices are
+stored row-major.  The state-space controller of HPGcontrol.c steps its
+own discrete matrices, so these are linked only into the benchmark,
+HPGintegrate_bench (make bench), not into HPGdaac.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <math.h>           // standard mathematics library
+
+// local libraries .. .
+#include "HPGintegrate.h"             // header for the integrators
+#include "HPGc2d.h"                   // continuous to discrete time
+#include "../../HPGnumlib/NRutil.h"   // memory allocation routines
+
+
+/* ODE_WORK_ALLOC - allocate an integrator workspace in one block     19oct26
+   returns 0: successful  1: abnormal
+---------------------------------------------------------------------------*/
+int ode_work_alloc ( struct ODEWORK *w, int n, int m )
+{
+  int  i, size = 5*n + n*n + n*m;
+
+  if ( n < 1 || m < 0 )  return 1;
+
+  w->n  = n;
+  w->m  = m;
+  w->k1 = vector ( 0, size-1 );
+  w->k2 = w->k1 + n;
+  w->k3 = w->k2 + n;
+  w->k4 = w->k3 + n;
+  w->xt = w->k4 + n;
+  w->Ad = w->xt + n;
+  w->Bd = w->Ad + n*n;
+  for (i=0; i<size; i++)  w->k1[i] = 0.0;   // touch every page now
+
+  return 0;
+}
+
+
+/* ODE_WORK_FREE - de-allocate an integrator workspace                19oct26
+---------------------------------------------------------------------------*/
+void ode_work_free ( struct ODEWORK *w )
+{
+  if ( w->k1 )  free_vector ( w->k1, 0, 5*w->n + w->n*w->n + w->n*w->m - 1 );
+  w->k1 = w->k2 = w->k3 = w->k4 = w->xt = w->Ad = w->Bd = NULL;
+}
+
+
+/* ODE_LTI_DERIVS - dx/dt = A x + B u,  data points to a struct ODELTI 19oct26
+---------------------------------------------------------------------------*/
+void ode_lti_derivs ( float t, const float *x, const float *u, float *dxdt,
+                      void *data )
+{
+  const struct ODELTI *sys = (const struct ODELTI *) data;
+  const int  n = sys->n,  m = sys->m;
+  const float *a = sys->A,  *b = sys->B;
+  float  s;
+  int    i, j;
+
+  for (i=0; i<n; i++, a += n, b += m) {
+    s = 0.0;
+    for (j=0; j<n; j++)  s += a[j] * x[j];
+    for (j=0; j<m; j++)  s += b[j] * u[j];
+    dxdt[i] = s;
+  }
+}
+
+
+/* ODE_RK4  -  4th Order Runge-Kutta, ``Numerical Recipes In C,''    19oct26
+   x is replaced by x(t+h) with u held constant over the step
+---------------------------------------------------------------------------*/
+void ode_rk4 ( ODE_DERIVS f, void *data, float t, float h, float *x,
+               const float *u, struct ODEWORK *w )
+{
+  const int  n = w->n;
+  const float hh = 0.5*h,  h6 = h/6.0;
+  float *k1 = w->k1, *k2 = w->k2, *k3 = w->k3, *k4 = w->k4, *xt = w->xt;
+  int  i;
+
+  (*f)( t, x, u, k1, data );
+  for (i=0; i<n; i++)  xt[i] = x[i] + hh*k1[i];
+
+  (*f)( t+hh, xt, u, k2, data );
+  for (i=0; i<n; i++)  xt[i] = x[i] + hh*k2[i];
+
+  (*f)( t+hh, xt, u, k3, data );
+  for (i=0; i<n; i++)  xt[i] = x[i] + h*k3[i];
+
+  (*f)( t+h, xt, u, k4, data );
+  for (i=0; i<n; i++)  x[i] += h6*( k1[i] + 2.0*(k2[i] + k3[i]) + k4[i] );
+}
+
+
+/* ODE_RK2  -  2nd Order (mid-point) Runge-Kutta                      19oct26
+   x is replaced by x(t+h) with u held constant over the step
+---------------------------------------------------------------------------*/
+void ode_rk2 ( ODE_DERIVS f, void *data, float t, float h, float *x,
+               const float *u, struct ODEWORK *w )
+{
+  const int  n = w->n;
+  const float hh = 0.5*h;
+  float *k1 = w->k1, *k2 = w->k2, *xt = w->xt;
+  int  i;
+
+  (*f)( t, x, u, k1, data );
+  for (i=0; i<n; i++)  xt[i] = x[i] + hh*k1[i];
+
+  (*f)( t+hh, xt, u, k2, data );
+  for (i=0; i<n; i++)  x[i] += h*k2[i];
+}
+
+
+/* ODE_LTI_SETUP - discrete time matrices for dx/dt = A x + B u with
+   time step h and u held constant over the step                     19oct26
+   ODE_TUSTIN:  Ad = (I - A h/2)^-1 (I + A h/2) ,  Bd = (I - A h/2)^-1 B h
+   ODE_ZOH:     [ Ad Bd ; 0 I ] = expm ( [ A B ; 0 0 ] h )
+   by c2d() in HPGc2d.c
+   Called once before the test.  returns 0: successful  1: abnormal
+---------------------------------------------------------------------------*/
+int ode_lti_setup ( struct ODEWORK *w, const float *A, const float *B,
+                    float h, int method )
+{
+  const int  n = w->n,  m = w->m,  p = n+m;
+  double    *S;
+  int        i, j, ok;
+
+  S = dvector ( 0, n*p - 1 );                   // setup only, not real time
+  for (i=0; i<n; i++) {                         // S = [ A B ]
+    for (j=0; j<n; j++)  S[i*p+j]   = A[i*n+j];
+    for (j=0; j<m; j++)  S[i*p+n+j] = B[i*m+j];
+  }
+
+  ok = c2d ( S, n, m, 0, h, method == ODE_TUSTIN ? C2D_TUSTIN :
+                            method == ODE_ZOH    ? C2D_ZOH    : 0 );
+  if ( ok == 0 )
+    for (i=0; i<n; i++) {
+      for (j=0; j<n; j++)  w->Ad[i*n+j] = S[i*p+j];
+      for (j=0; j<m; j++)  w->Bd[i*m+j] = S[i*p+n+j];
+    }
+
+  free_dvector ( S, 0, n*p - 1 );
+  return ok;
+}
+
+
+/* ODE_LTI_STEP - x <- Ad x + Bd u  with the matrices from ode_lti_setup()
+---------------------------------------------------------------------------*/
+void ode_lti_step ( float *x, const float *u, struct ODEWORK *w )
+{
+  const int  n = w->n,  m = w->m;
+  const float *a = w->Ad,  *b = w->Bd;
+  float *xt = w->xt,  s;
+  int    i, j;
+
+  for (i=0; i<n; i++, a += n, b += m) {
+    s = 0.0;
+    for (j=0; j<n; j++)  s += a[j] * x[j];
+    for (j=0; j<m; j++)  s += b[j] * u[j];
+    xt[i] = s;
+  }
+  for (i=0; i<n; i++)  x[i] = xt[i];
+}
@@ -0,0 +1,96 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGintegrate.h
+ *
+ *    Description:  header file for HPGintegrate.c
+ *                  fixed step integrators for the real time control path
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGINTEGRATE_H_
+#define _HPGINTEGRATE_H_
+
+#define ODE_RK4     1    /* 4th order Runge-Kutta                         */
+#define ODE_RK2     2    /* 2nd order Runge-Kutta (mid-point)             */
+#define ODE_TUSTIN  3    /* bilinear (trapezoidal) for L.T.I. systems     */
+#define ODE_ZOH     4    /* exact, zero order hold, for L.T.I. systems    */
+
+/*
+ * derivative callback ... dxdt = f ( t, x, u )
+ * x[0..n-1] states, u[0..m-1] inputs held constant over the time step,
+ * data points to whatever the callback needs (e.g., the system matrices)
+ */
+typedef void (*ODE_DERIVS) ( float t,
+                             const float *x,
+                             const float *u,
+                             float *dxdt,
+                             void *data );
+
+/*
+ * integrator workspace, allocated once, before the test, in one block
+ */
+  struct ODEWORK {
+         int    n, m;              // number of states and inputs
+         float *k1, *k2, *k3, *k4; // Runge-Kutta stage derivatives
+         float *xt;                // Runge-Kutta trial state
+         float *Ad, *Bd;           // n x n and n x m discrete time matrices
+      };
+
+/*
+ * continuous time L.T.I. system for ode_lti_derivs ... dx/dt = A x + B u
+ */
+  struct ODELTI {
+         int    n, m;              // number of states and inputs
+         const float *A, *B;       // n x n and n x m, row-major
+      };
+
+/* allocate an integrator workspace for n states and m inputs */
+int  ode_work_alloc ( struct ODEWORK *w,
+                      int n,
+                      int m );
+
+/* de-allocate an integrator workspace */
+void ode_work_free ( struct ODEWORK *w );
+
+/* derivative of a continuous time L.T.I. system, an ODE_DERIVS */
+void ode_lti_derivs ( float t,
+                      const float *x,
+                      const float *u,
+                      float *dxdt,
+                      void *data );
+
+/* one 4th order Runge-Kutta step, x is replaced by x(t+h) */
+void ode_rk4 ( ODE_DERIVS f,
+               void *data,
+               float t,
+               float h,
+               float *x,
+               const float *u,
+               struct ODEWORK *w );
+
+/* one 2nd order Runge-Kutta step, x is replaced by x(t+h) */
+void ode_rk2 ( ODE_DERIVS f,
+               void *data,
+               float t,
+               float h,
+               float *x,
+               const float *u,
+               struct ODEWORK *w );
+
+/* discrete time matrices Ad, Bd for ODE_TUSTIN or ODE_ZOH, before the test */
+int  ode_lti_setup ( struct ODEWORK *w,
+                     const float *A,
+                     const float *B,
+                     float h,
+                     int method );
+
+/* one L.T.I. step ... x <- Ad x + Bd u */
+void ode_lti_step ( float *x,
+                    const float *u,
+                    struct ODEWORK *w );
+
+#endif // _HPGINTEGRATE_H_
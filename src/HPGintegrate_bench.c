@@ -0,0 +1,217 @@
+/*******************************************************************************
+HPGintegrate_bench.c - per-step cost and jitter of the control path integrators
+
+Compares the Numerical Recipes rk4 that allocated and freed its work space
+on every call (as formerly in HPGcontrol.c) with the pre-allocated
+integrators of HPGintegrate.c, on a chain of n/2 lightly damped
+oscillators sampled at 1 kHz.
+
+to compile:   make bench
+
+to run:       ./HPGintegrate_bench [number of states] [number of steps]
+              sudo chrt -f 80 ./HPGintegrate_bench 8 100000
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // atoi, qsort
+#include <string.h>         // standard string handling library
+#include <math.h>           // standard mathematics library
+#include <time.h>           // clock_gettime
+
+// local libraries .. .
+#include "HPGintegrate.h"             // header for the integrators
+#include "../../HPGnumlib/NRutil.h"   // memory allocation routines
+
+static struct ODELTI  sys;            // the benchmark system
+static float          u0[1] = { 1.0 };
+
+
+/* NR_DERIVS - derivative function with the 1-indexed rk4 argument list
+---------------------------------------------------------------------------*/
+static void nr_derivs ( float t, float *x, float *dxdt )
+{
+  ode_lti_derivs ( t, x+1, u0, dxdt+1, &sys );
+}
+
+
+/* RK4_NR - 4th Order Runge-Kutta, ``Numerical Recipes In C,'' 17julyo1
+   with a work space allocated and freed on every call
+---------------------------------------------------------------------------*/
+static void rk4_nr ( float *y, float *dydx, int n, float h, float vi,
+                     float *yout, void (*derivs)(float, float *, float *) )
+{
+  int  i;
+  float  hh, h6, *dym, *dyt, *yt;
+
+  dym = vector(1,n);
+  dyt = vector(1,n);
+  yt  = vector(1,n);
+
+  hh = h/2.0;
+  h6 = h/6.0;
+
+  for(i=1;i<=n;i++)
+    yt[i] = y[i]+hh*dydx[i];
+
+  (*derivs)(vi,yt,dyt);
+  for(i=1;i<=n;i++)
+    yt[i] = y[i]+hh*dyt[i];
+
+  (*derivs)(vi,yt,dym);
+  for(i=1;i<=n;i++) {
+    yt[i] = y[i]+h*dym[i];
+    dym[i] += dyt[i];
+  }
+
+  (*derivs)(vi,yt,dyt);
+  for(i=1;i<=n;i++)
+    yout[i] = y[i]+h6*(dydx[i]+dyt[i]+2.0*dym[i]);
+
+  free_vector(yt,1,n);
+  free_vector(dyt,1,n);
+  free_vector(dym,1,n);
+  return;
+}
+
+
+/* ELAPSED_NS - nano-seconds between two time stamps
+---------------------------------------------------------------------------*/
+static double elapsed_ns ( struct timespec *t0, struct timespec *t1 )
+{
+  return 1e9*(t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec);
+}
+
+
+static int cmp_double ( const void *a, const void *b )
+{
+  double  d = *(const double *)a - *(const double *)b;
+  return ( d > 0 ) - ( d < 0 );
+}
+
+
+/* REPORT - mean, standard deviation (jitter), median, 99.9 percentile,
+   and maximum of the step times
+---------------------------------------------------------------------------*/
+static void report ( char *name, double *dt, int nStep, float *x, int n )
+{
+  double  avg = 0.0, var = 0.0;
+  int     i;
+
+  for (i=0; i<nStep; i++)  avg += dt[i];
+  avg /= nStep;
+  for (i=0; i<nStep; i++)  var += (dt[i]-avg)*(dt[i]-avg);
+  var /= nStep;
+  qsort ( dt, nStep, sizeof(double), cmp_double );
+
+  printf(" %-16s %9.1f %9.1f %9.1f %9.1f %10.1f   %+10.6f\n", name,
+         avg, sqrt(var), dt[nStep/2], dt[(int)(0.999*nStep)], dt[nStep-1],
+         x[n-2] );
+}
+
+
+int main ( int argc, char *argv[] )
+{
+  int     n = 8, nStep = 100000, i, k;
+  float   h = 1.0e-3,  *A, *B, *x, *xnr, *dxdt;
+  double *dt;
+
+  struct ODEWORK  w;
+  struct timespec t0, t1;
+
+  if ( argc > 1 )  n     = 2*(atoi(argv[1])/2);
+  if ( argc > 2 )  nStep = atoi(argv[2]);
+  if ( n < 2 )     n     = 2;
+  if ( nStep < 1 ) nStep = 1;
+
+  A    = vector ( 0, n*n-1 );
+  B    = vector ( 0, n-1 );
+  x    = vector ( 0, n-1 );
+  xnr  = vector ( 1, n );
+  dxdt = vector ( 1, n );
+  dt   = dvector ( 0, nStep-1 );
+
+  // a chain of oscillators, 1 Hz to n/2 Hz, 2 percent damping, forced by u
+  for (i=0; i<n*n; i++)  A[i] = 0.0;
+  for (i=0; i<n; i++)    B[i] = 0.0;
+  for (k=0; k<n/2; k++) {
+    float  wn = 2.0*M_PI*(k+1);
+    A[(2*k)*n + 2*k+1]   = 1.0;
+    A[(2*k+1)*n + 2*k]   = -wn*wn;
+    A[(2*k+1)*n + 2*k+1] = -2.0*0.02*wn;
+    if ( k > 0 )  A[(2*k+1)*n + 2*k-2] = 0.1*wn*wn;   // coupling
+  }
+  B[n-1] = 1.0;
+  sys.n = n;  sys.m = 1;  sys.A = A;  sys.B = B;
+
+  if ( ode_work_alloc ( &w, n, 1 ) ) {
+    fprintf(stderr," ode_work_alloc failed\n");
+    return 1;
+  }
+
+  printf("\n %d states, %d steps, h = %g s, step times in nano-seconds\n\n",
+          n, nStep, h );
+  printf(" %-16s %9s %9s %9s %9s %10s   %10s\n",
+         "integrator", "mean", "jitter", "median", "99.9%", "max", "x[n-2]");
+
+  // Numerical Recipes rk4, allocating on every step
+  for (i=1; i<=n; i++)  xnr[i] = 0.0;
+  for (k=0; k<nStep; k++) {
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    nr_derivs ( k*h, xnr, dxdt );
+    rk4_nr ( xnr, dxdt, n, h, k*h, xnr, nr_derivs );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    dt[k] = elapsed_ns ( &t0, &t1 );
+  }
+  report ( "rk4 (NR, malloc)", dt, nStep, xnr+1, n );
+
+  // pre-allocated Runge-Kutta integrators
+  for (i=0; i<n; i++)  x[i] = 0.0;
+  for (k=0; k<nStep; k++) {
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    ode_rk4 ( ode_lti_derivs, &sys, k*h, h, x, u0, &w );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    dt[k] = elapsed_ns ( &t0, &t1 );
+  }
+  report ( "ode_rk4", dt, nStep, x, n );
+
+  for (i=0; i<n; i++)  x[i] = 0.0;
+  for (k=0; k<nStep; k++) {
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    ode_rk2 ( ode_lti_derivs, &sys, k*h, h, x, u0, &w );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    dt[k] = elapsed_ns ( &t0, &t1 );
+  }
+  report ( "ode_rk2", dt, nStep, x, n );
+
+  // discrete time L.T.I. steps
+  ode_lti_setup ( &w, A, B, h, ODE_TUSTIN );
+  for (i=0; i<n; i++)  x[i] = 0.0;
+  for (k=0; k<nStep; k++) {
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    ode_lti_step ( x, u0, &w );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    dt[k] = elapsed_ns ( &t0, &t1 );
+  }
+  report ( "tustin", dt, nStep, x, n );
+
+  ode_lti_setup ( &w, A, B, h, ODE_ZOH );
+  for (i=0; i<n; i++)  x[i] = 0.0;
+  for (k=0; k<nStep; k++) {
+    clock_gettime ( CLOCK_MONOTONIC, &t0 );
+    ode_lti_step ( x, u0, &w );
+    clock_gettime ( CLOCK_MONOTONIC, &t1 );
+    dt[k] = elapsed_ns ( &t0, &t1 );
+  }
+  report ( "zoh (exact)", dt, nStep, x, n );
+  printf("\n");
+
+  ode_work_free ( &w );
+  free_vector ( A, 0, n*n-1 );
+  free_vector ( B, 0, n-1 );
+  free_vector ( x, 0, n-1 );
+  free_vector ( xnr, 1, n );
+  free_vector ( dxdt, 1, n );
+  free_dvector ( dt, 0, nStep-1 );
+
+  return 0;
+}
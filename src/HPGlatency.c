@@ -0,0 +1,109 @@
+/*******************************************************************************
+HPGlatency.c
+latency histograms for the real time control path
+
+latency_add() is called from the scan handler; it does not allocate memory
+or call the library, so it is safe in a signal handler.  The histogram has
+1 micro-second bins up to LAT_BINS micro-seconds.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+
+// local libraries .. .
+#include "HPGlatency.h"               // header for latency histograms
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* LATENCY_INIT - clear a latency histogram                          19oct26
+---------------------------------------------------------------------------*/
+void latency_init ( struct LATENCY *lat, char *name )
+{
+  memset ( lat, 0, sizeof(struct LATENCY) );
+  strncpy ( lat->name, name, sizeof(lat->name)-1 );
+  lat->min = INT64_MAX;
+}
+
+
+/* LATENCY_NS - nano-seconds from t0 to t1                           19oct26
+---------------------------------------------------------------------------*/
+int64_t latency_ns ( struct timespec *t0, struct timespec *t1 )
+{
+  return (int64_t)(t1->tv_sec - t0->tv_sec)*1000000000 +
+                  (t1->tv_nsec - t0->tv_nsec);
+}
+
+
+/* LATENCY_ADD - add one measurement to a latency histogram          19oct26
+---------------------------------------------------------------------------*/
+void latency_add ( struct LATENCY *lat, int64_t ns )
+{
+  int64_t  us = ns / 1000;
+
+  if ( us < 0 )          us = 0;
+  if ( us >= LAT_BINS )  us = LAT_BINS-1;
+  ++lat->bin[us];
+  ++lat->n;
+  lat->sum += (double) ns;
+  if ( ns < lat->min )  lat->min = ns;
+  if ( ns > lat->max )  lat->max = ns;
+}
+
+
+/* PERCENTILE - the bin (micro-seconds) below which a fraction p of the
+   measurements lie
+---------------------------------------------------------------------------*/
+static int percentile ( struct LATENCY *lat, double p )
+{
+  uint32_t  count = 0,  target = (uint32_t)( p * lat->n );
+  int       us;
+
+  for (us=0; us<LAT_BINS; us++)
+    if ( (count += lat->bin[us]) > target )  break;
+  return ( us < LAT_BINS ) ? us : LAT_BINS-1;
+}
+
+
+/* LATENCY_REPORT - display the distribution of a latency histogram  19oct26
+   with a ten row histogram from the minimum to the 99.9 percentile
+---------------------------------------------------------------------------*/
+void latency_report ( struct LATENCY *lat )
+{
+  uint32_t  count, peak = 0, rows[10];
+  int       lo, hi, width, r, us, k;
+
+  if ( lat->n == 0 )  return;
+
+  lo = (int)( lat->min / 1000 );
+  hi = percentile ( lat, 0.999 ) + 1;
+  width = ( hi - lo + 9 ) / 10;
+  if ( width < 1 )  width = 1;
+
+  for (r=0; r<10; r++) {
+    count = 0;
+    for (us = lo + r*width; us < lo + (r+1)*width && us < LAT_BINS; us++)
+      count += lat->bin[us];
+    rows[r] = count;
+    if ( count > peak )  peak = count;
+  }
+
+  color(0); color(1); color(32);
+  fprintf(stderr,"\n %s latency, %u measurements, micro-seconds\n",
+                  lat->name, lat->n );
+  color(36);
+  fprintf(stderr,"   min %7.1f   median %5d   99%% %5d   99.9%% %5d   max %7.1f   mean %7.1f\n",
+                  lat->min/1e3, percentile ( lat, 0.5 ), percentile ( lat, 0.99 ),
+                  percentile ( lat, 0.999 ), lat->max/1e3, lat->sum/lat->n/1e3 );
+  for (r=0; r<10; r++) {
+    color(32); fprintf(stderr,"   %5d - %5d  %8u  ",
+                       lo + r*width, lo + (r+1)*width, rows[r] );
+    color(33);
+    for (k=0; k < (int)( 50.0 * rows[r] / peak + 0.5 ); k++)  fprintf(stderr,"*");
+    fprintf(stderr,"\n");
+  }
+  if ( lat->bin[LAT_BINS-1] ) {
+    color(31); fprintf(stderr,"   %u measurements over %d us\n",
+                                lat->bin[LAT_BINS-1], LAT_BINS-1 );
+  }
+  color(0); color(1); color(36);
+}
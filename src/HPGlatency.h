@@ -0,0 +1,48 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGlatency.h
+ *
+ *    Description:  header file for HPGlatency.c
+ *                  latency histograms for the real time control path
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGLATENCY_H_
+#define _HPGLATENCY_H_
+
+#include <stdint.h>         // int64_t, uint32_t
+#include <time.h>           // struct timespec
+
+#define LAT_BINS  2000      /* 1 micro-second bins, the last for overflow   */
+
+/*
+ * a latency histogram, filled from the scan handler without allocation
+ */
+  struct LATENCY {
+         char      name[40];        // what is measured
+         uint32_t  n;               // number of measurements
+         int64_t   min, max;        // extreme values, nano-seconds
+         double    sum;             // sum of values, nano-seconds
+         uint32_t  bin[LAT_BINS];   // counts in 1 us bins
+      };
+
+/* clear a latency histogram */
+void latency_init ( struct LATENCY *lat,
+                    char *name );
+
+/* nano-seconds from t0 to t1 */
+int64_t latency_ns ( struct timespec *t0,
+                     struct timespec *t1 );
+
+/* add one measurement, in nano-seconds, to a latency histogram */
+void latency_add ( struct LATENCY *lat,
+                   int64_t ns );
+
+/* display the distribution of a latency histogram */
+void latency_report ( struct LATENCY *lat );
+
+#endif // _HPGLATENCY_H_
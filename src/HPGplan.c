@@ -0,0 +1,254 @@
+/*******************************************************************************
+HPGplan.c
+timing plan of a test ... the time to convert, control, and write a scan,
+from a model of ADS1256_ChannelScan, checked against the scan period before
+the board is touched
+
+Each channel of a scan costs the SPI bytes and the fixed delays of
+ADS1256_ChannelScan before its conversion starts: the WREG of the registers
+that change (only the MUX between channels of the same gain, the MUX, the
+ADCON and, when calibrated, the OFC and FSC registers at a change of gain),
+the SYNC, the t11 delay, and the WAKEUP.  The conversion then settles in the
+time t18 of the data rate (ADS1256 datasheet, table 13), while the data of
+the previous channel is read with RDATA; the last channel is read after its
+conversion.  A channel that averages several conversions is read before the
+next MUX is written, and each further conversion takes one conversion period,
+1 / data rate, or its RDATA if that is longer.  A byte takes 8 SPI clocks plus
+the overhead of the library call.
+The scan adds the D/A writes, and the controller, a state space controller
+by its multiply-adds or a plug-in by its time budget.  Plotting, streaming
+and the system are not modeled; they are left the part 1 - PLAN_LOAD of the
+scan period.
+
+plan_test() finds the longest scan of the major frame of the schedule.  A
+test whose longest scan does not fit in the scan period is rejected before
+the board is initialized; one that fits, but not within PLAN_LOAD of the
+period, is reported.  With PLAN_AUTO the slowest data rate, with the least
+noise, whose scans fit within PLAN_LOAD of the period is used instead of the
+data rate of the configuration.
+
+plan_order() gives the time of one scan of all the channels in a given
+order, converted back to back, so set_scan_order() in HPGdaac.c can choose,
+among the orders it considers, the one with the shortest planned scan.
+
+With several ADS1256 on the bus, each run of consecutive channels on one
+converter is one ADS1256_ChannelScan, with the registers left in that
+converter by its last run, and the runs are converted one after the other.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // memset
+
+// local libraries .. .
+#include "HPGplan.h"                  // header for the timing plan
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+// the data rates of ADS1256_CSPEED, and the settling times t18, micro-sec
+static const float  planRate[16]   = { 30000, 15000, 7500, 3750, 2000, 1000,
+                                       500, 100, 60, 50, 30, 25, 15, 10, 5, 2.5 };
+static const double planSettle[16] = { 210, 250, 310, 440, 680, 1180, 2180,
+                                       10180, 16840, 20180, 33510, 40180,
+                                       66840, 100180, 200180, 400180 };
+
+
+/* PLAN_RATE - the data rate set by ADS1256_SetDigitizationRate      19oct26
+---------------------------------------------------------------------------*/
+float plan_rate ( float drate )
+{
+  int  k;
+
+  for (k=15; k>0; k--)  if ( drate <= planRate[k] )  return planRate[k];
+  return planRate[0];
+}
+
+
+/* SETTLE_US - the settling time of a conversion at a data rate
+---------------------------------------------------------------------------*/
+static double settle_us ( float rate )
+{
+  int  k;
+
+  for (k=0; k<16; k++)  if ( rate >= planRate[k] )  return planSettle[k];
+  return planSettle[15];
+}
+
+
+/* BYTES_US - the time to transfer n bytes over SPI
+---------------------------------------------------------------------------*/
+static double bytes_us ( unsigned n )
+{
+  return n * ( 8.0e6 / PLAN_SPI_HZ + PLAN_CALL_US );
+}
+
+
+/* CALL_US - the time of one ADS1256_ChannelScan of n channels, with the
+   MUX and gain left by the last conversion in *mux0 and *range0, and avg
+   conversions of each channel, one conversion period conv apart     19oct26
+---------------------------------------------------------------------------*/
+static double call_us ( unsigned n, uint8_t *mux, uint8_t *range, uint8_t *avg,
+                        uint8_t *mux0, uint8_t *range0, double settle,
+                        double conv, int calOn )
+{
+  double    t = 0.0,
+            rdata = bytes_us(1) + 10 + bytes_us(3) + 2*SPI_DELAY,
+            more  = ( conv > rdata ) ? conv : rdata;   // a further conversion
+  unsigned  k, first, last, a = 1;
+
+  if ( n == 0 )  return 0.0;
+  for (k=0; k<n; k++) {
+    if ( a > 1 )                                        // the last channel,
+      t += rdata + ( a - 1 ) * more;                    // averaged
+    t += SPI_DELAY;
+    if ( mux[k] != *mux0 || ( range[k] & 0x07 ) != ( *range0 & 0x07 ) ) {
+      first = ( mux[k] != *mux0 ) ? 0 : 1;              // MUX or ADCON
+      last  = ( ( range[k] & 0x07 ) == ( *range0 & 0x07 ) ) ? 0 :
+              ( calOn ? 9 : 1 );                        // ADCON .. FSC2
+      t += bytes_us ( 2 + last - first + 1 ) + 5;       // the WREG
+    }
+    t += bytes_us(1) + 4 + bytes_us(1) + SPI_DELAY;     // SYNC, WAKEUP
+    t += ( k > 0 && a == 1 && rdata > settle ) ? rdata : settle; // and RDATA
+    *mux0 = mux[k];  *range0 = range[k];
+    a = avg ? avg[k] : 1;
+  }
+  return t + rdata + ( a - 1 ) * more;                  // the last channel
+}
+
+
+/* RUNS_US - the time of n channels, one ADS1256_ChannelScan for each run
+   of channels on the same converter, cnv, or one with cnv NULL, with the
+   MUX and gain left in each converter in mux0[] and range0[]        19oct26
+---------------------------------------------------------------------------*/
+static double runs_us ( unsigned n, uint8_t *mux, uint8_t *range, uint8_t *avg,
+                        uint8_t *cnv, uint8_t mux0[], uint8_t range0[],
+                        double settle, double conv, int calOn )
+{
+  double    t = 0.0;
+  unsigned  k, j, c;
+
+  for (k=0; k<n; k=j) {
+    c = cnv ? cnv[k] : 0;
+    for (j=k+1; j<n && ( cnv ? cnv[j] : 0 ) == c; j++) ;
+    t += call_us ( j-k, mux+k, range+k, avg ? avg+k : NULL, &mux0[c], &range0[c],
+                   settle, conv, calOn );
+  }
+  return t;
+}
+
+
+/* FRAME_US - the longest scan of the major frame, at one data rate
+---------------------------------------------------------------------------*/
+static double frame_us ( struct SCHED *s, unsigned nFirst,
+                         uint8_t *muxOrder, uint8_t *rangeOrder,
+                         uint8_t *avgOrder, uint8_t *cnvOrder, double settle,
+                         double conv, int calOn, double fixed )
+{
+  uint8_t   mux0[ACQ_MAXAD], range0[ACQ_MAXAD];
+  unsigned  f, pass;
+  double    t, worst = 0.0;
+
+  memset ( mux0, 0xFF, sizeof(mux0) );
+  memset ( range0, 0xFF, sizeof(range0) );
+  for (pass=0; pass<2; pass++)        // the registers of the frame before
+    for (f=0; f<s->nFrame; f++) {
+      t  = runs_us ( nFirst, muxOrder, rangeOrder, avgOrder, cnvOrder, mux0, range0,
+                     settle, conv, calOn );
+      t += runs_us ( s->n[f], s->mux[f], s->range[f], s->avg[f], s->cnv[f],
+                     mux0, range0, settle, conv, calOn );
+      t += fixed;
+      if ( pass == 1 && t > worst )  worst = t;
+    }
+  return worst;
+}
+
+
+/* PLAN_ORDER - the time of a scan of the n channels in the order of mux,
+   range and avg, on the converters cnv, in ChannelScan calls split after
+   nFirst, after a scan in the same order, at the data rate drate    19oct26
+---------------------------------------------------------------------------*/
+double plan_order ( unsigned n, unsigned nFirst, uint8_t *mux, uint8_t *range,
+                    uint8_t *avg, uint8_t *cnv, float drate, int calOn )
+{
+  uint8_t   mux0[ACQ_MAXAD], range0[ACQ_MAXAD];
+  float     rate = plan_rate ( drate );
+  double    t = 0.0;
+  unsigned  pass;
+
+  memset ( mux0, 0xFF, sizeof(mux0) );
+  memset ( range0, 0xFF, sizeof(range0) );
+  for (pass=0; pass<2; pass++) {      // the registers of the scan before
+    t  = runs_us ( nFirst, mux, range, avg, cnv, mux0, range0,
+                   settle_us ( rate ), 1.0e6 / rate, calOn );
+    t += runs_us ( n - nFirst, mux + nFirst, range + nFirst,
+                   avg ? avg + nFirst : NULL, cnv ? cnv + nFirst : NULL,
+                   mux0, range0, settle_us ( rate ), 1.0e6 / rate, calOn );
+  }
+  return t;
+}
+
+
+/* PLAN_TEST - the timing plan of the scans of a test, at the data rate
+   drate, or with PLAN_AUTO, at the slowest data rate that fits.
+   returns 0: the scans fit in the scan period  1: they do not      19oct26
+---------------------------------------------------------------------------*/
+int plan_test ( struct PLAN *p, int mode, float sr, float drate,
+                struct SCHED *s, unsigned nFirst, uint8_t *muxOrder,
+                uint8_t *rangeOrder, uint8_t *avgOrder, uint8_t *cnvOrder,
+                int calOn, struct CTRL *ctrl,
+                unsigned nDA, unsigned loopTries )
+{
+  double  fixed, loop1;
+  int     k;
+
+  // the D/A writes and the controller, in every scan
+  fixed = nDA * ( bytes_us(3) + 3*SPI_DELAY );
+  if ( ctrl )
+    fixed += ctrl->dl ? ctrl->budget_ns / 1e3 :
+             1.0 + PLAN_MAC_US * (ctrl->N + ctrl->M) * (ctrl->N + ctrl->L);
+
+  p->period_us = 1.0e6 / sr;
+  p->drate     = plan_rate ( drate );
+  if ( mode == PLAN_AUTO )            // the slowest data rate that fits
+    for (k=15; k>=0; k--) {
+      p->drate = planRate[k];
+      if ( frame_us ( s, nFirst, muxOrder, rangeOrder, avgOrder, cnvOrder,
+                      planSettle[k], 1.0e6 / planRate[k], calOn, fixed )
+           <= PLAN_LOAD * p->period_us )  break;
+    }
+
+  p->settle_us   = settle_us ( p->drate );
+  p->scan_us     = frame_us ( s, nFirst, muxOrder, rangeOrder, avgOrder,
+                              cnvOrder, p->settle_us, 1.0e6 / p->drate,
+                              calOn, fixed );
+  p->headroom_us = p->period_us - p->scan_us;
+  p->maxSr       = PLAN_LOAD * 1.0e6 / p->scan_us;
+
+  // a loopback scan converts the loopback channel until it sees the step
+  loop1 = SPI_DELAY + bytes_us(1) + 4 + bytes_us(1) + SPI_DELAY +
+          p->settle_us + bytes_us(1) + 10 + bytes_us(3) + 2*SPI_DELAY;
+  p->loop_us = loopTries ? p->scan_us + loopTries * loop1 : 0.0;
+
+  return ( p->scan_us > p->period_us );
+}
+
+
+/* PLAN_REPORT - display the timing plan                             19oct26
+---------------------------------------------------------------------------*/
+void plan_report ( struct PLAN *p )
+{
+  color(1); color(33);
+  fprintf(stderr," timing plan: scans of %.0f us in a %.0f us period at %.1f cps, headroom %.0f us, highest safe scan rate %.1f sps\n",
+                  p->scan_us, p->period_us, p->drate, p->headroom_us, p->maxSr );
+  if ( p->loop_us > p->period_us )
+    fprintf(stderr," timing plan: a loopback scan may take up to %.0f us, and delay the next scan\n",
+                    p->loop_us );
+  if ( p->scan_us > p->period_us ) {
+    color(1); color(31);
+    fprintf(stderr," timing plan: the scans do not fit in the scan period\n");
+  } else
+  if ( p->scan_us > PLAN_LOAD * p->period_us ) {
+    color(1); color(31);
+    fprintf(stderr," timing plan: less than %.0f%% of the scan period is left for plotting and the system\n",
+                    100*(1-PLAN_LOAD) );
+  }
+  color(1); color(37);
+}
@@ -0,0 +1,76 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGplan.h
+ *
+ *    Description:  header file for HPGplan.c
+ *                  timing plan of a test, the time to convert, control,
+ *                  and write a scan, checked against the scan period
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGPLAN_H_
+#define _HPGPLAN_H_
+
+#include <stdint.h>         // uint8_t
+#include "HPGsched.h"       // struct SCHED
+#include "HPGcontrol.h"     // struct CTRL
+
+#define PLAN_CHECK     0   /* reject a test whose scans do not fit           */
+#define PLAN_AUTO      1   /* ... and choose the slowest data rate that fits */
+
+#define PLAN_SPI_HZ  6.25e6 /* SPI clock, BCM2835_SPI_CLOCK_DIVIDER_64       */
+#define PLAN_CALL_US   1.0  /* overhead of one bcm2835_spi_transfer, us      */
+#define PLAN_MAC_US  0.004  /* one multiply-add of a state space controller  */
+#define PLAN_LOAD      0.8  /* fraction of the scan period for the scan, the */
+                            /* rest is left for plotting and the system      */
+
+  struct PLAN {         // the timing plan of a test
+         float   drate;         // data rate of the ADS1256, cps, as set
+         double  settle_us;     // settling time of a conversion, t18
+         double  scan_us;       // the longest scan, micro-seconds
+         double  loop_us;       // the longest loopback scan, micro-seconds
+         double  period_us;     // the scan period, micro-seconds
+         double  headroom_us;   // period_us - scan_us
+         float   maxSr;         // the highest safe scan rate, PLAN_LOAD
+      };
+
+/* the data rate set in the ADS1256 for a requested data rate */
+float plan_rate ( float drate );
+
+/* the time of a scan of n channels in the order of mux, range and avg, on
+   the converters cnv (NULL: one), at data rate drate, to compare scan
+   orders, micro-seconds */
+double plan_order ( unsigned n,
+                    unsigned nFirst,
+                    uint8_t *mux,
+                    uint8_t *range,
+                    uint8_t *avg,
+                    uint8_t *cnv,
+                    float drate,
+                    int calOn );
+
+/* plan the scans of a test, at data rate drate, or, with PLAN_AUTO, at
+   the slowest data rate that fits;  returns 0: fits  1: does not fit */
+int  plan_test ( struct PLAN *p,
+                 int mode,
+                 float sr,
+                 float drate,
+                 struct SCHED *s,
+                 unsigned nFirst,
+                 uint8_t *muxOrder,
+                 uint8_t *rangeOrder,
+                 uint8_t *avgOrder,
+                 uint8_t *cnvOrder,
+                 int calOn,
+                 struct CTRL *ctrl,
+                 unsigned nDA,
+                 unsigned loopTries );
+
+/* display the plan */
+void plan_report ( struct PLAN *p );
+
+#endif // _HPGPLAN_H_
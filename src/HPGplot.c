@@ -0,0 +1,585 @@
+/*******************************************************************************
+HPGplot.c
+real time plotting of the scanned data with xcb
+
+Each channel has its own graphic context in its own color.  
+
+plot_data() decimates the data to the pixel columns of the window: for each
+channel and each pixel column it keeps the first, last, minimum and maximum
+value.  A finished column becomes at most two line segments, a vertical
+segment from the minimum to the maximum, and a segment joining the last
+value of the previous column to the first value of this column, so peaks
+and clipping remain visible however many scans fall in a column.  Once per
+frame (PLOT_FPS frames per second) plot_flush() draws each channel with a
+single xcb_poly_segment and flushes the connection, so the X traffic is
+proportional to the width of the window, not to the number of scans.
+
+All drawing goes to an off-screen pixmap.  Each frame copies only the
+columns that changed to the window, and the window is restored from the
+pixmap when it is exposed, without re-reading the data.  In strip chart
+mode the x axis spans a rolling time window; when the traces reach the
+right edge, the plot area of the pixmap is scrolled left by a tenth of its
+width with one copy, rather than re-plotting the history.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // calloc, free
+#include <string.h>         // standard string handling library
+#include <math.h>           // ceil
+
+// local libraries .. .
+#include <xcb/xcb.h>
+#include "HPGplot.h"                  // header for real time plotting
+#include "../../HPGxcblib/HPGxcb.h"   // HPG xcb gracphics functions
+
+static uint32_t CHNL_COLR[8] = {0xffffff, 0xff9205, 0x02ce2a, 0x02c3c4, 0x2201c4, 0xe0ee02, 0xce02c7, 0xf2031d};  // bruel+kjaer
+
+static xcb_gcontext_t  chnlGC[NUMCHNL];   // one graphic context per channel
+static xcb_segment_t  *segs[NUMCHNL];     // segments of one frame, per channel
+static unsigned        nSegs[NUMCHNL],    // number of segments in the frame
+                       frameScans = 1,    // scans per frame
+                       scansInFrame = 0,  // scans since the last frame
+                       plotChnl = 0;      // number of channels plotted
+
+  struct COLUMN {       // the values of one channel in one pixel column
+         int16_t  x;           // pixel column, -1 before the first scan
+         int16_t  first, last; // first and last value in the column
+         int16_t  min, max;    // extreme values in the column
+         int16_t  xPrev, yPrev;// pixel column and last value of the column before
+      };
+
+static struct COLUMN   col[NUMCHNL];      // the current column, per channel
+
+static xcb_screen_t   *scr;               // the screen
+static xcb_pixmap_t    pixmap;            // off-screen copy of the window
+static xcb_gcontext_t  copyGC,            // copies, without exposure events
+                       clearGC;           // background color
+static int16_t         dmgLo = SCREEN_W,  // columns changed since the last
+                       dmgHi = -1;        //   copy to the window
+static float           stripSec = 0.0;    // strip chart window, 0: fixed axis
+static int32_t         xShift = 0;        // pixels scrolled in strip mode
+static float           xOrig, xUnit, yOrig, hatchSec; // axes and x-hatches
+static struct CHNL    *legend;            // channel labels
+static char           *xLabelText;        // x axis label
+
+#define XB  25          /* left border for plotting                         */
+#define YB  25          /* top border for plotting                          */
+
+
+/* plot_setup 
+ * set up axes scaled to volts and seconds
+ * one graphic context per channel color, the per-channel segment arrays
+ * for one frame of scans, and the off-screen pixmap of the window   19oct26
+ * the x axis spans strip seconds in strip chart mode (strip > 0)     19oct26
+ * returns 1 without plotting if there is no X display, and does not wait
+ * for the window to be mapped; plot_flush() draws it when exposed   19oct26
+ * Jesse Hoagg, Fall 2001
+ * --------------------------------------------------------------------------*/
+int  plot_setup ( float *xunit,  float *yunit, float *xo, float *yo,
+                  float xmin, float xmax, uint8_t *rangeCode, 
+                  char title[], char Xlabel[], char Ylabel[],
+                  int8_t nChnl, struct CHNL chnl[], float sr, float strip )
+{
+  float     ymax = +1.0,                //  ADMAX-ADMID, // fractional range
+            ymin = -0.0;                //  ADMIN-ADMID; // 0.0;   
+  uint8_t   i, chn; 
+  int16_t   dx, dy, xh, yh;             // hatch increments and locations
+  char      ht[NUMCHNL];                // hatch text label
+
+  xcb_screen_t        *screen;
+  xcb_segment_t        ll[] = { {0,0 , 0,0} };
+
+  uint32_t  gc_mask = 0;                  // graphic context mask
+  uint32_t  gc_value[2]  = { 0 , 0 };     // graphic context values
+  uint32_t  textClr = 0xecddc6e;          // text and background color
+  uint32_t  axisClr[2] = {0x73c4ba, 0x0}; // axis line color  
+  // empacher    0xecdc6e
+  // bruel+kjaer 0x73c4ba
+
+   if ( chnl[0].negPin >= 0 ) ymin = -1.0;  // differential inputs
+
+   stripSec = strip;
+   if ( stripSec > 0.0 )  xmax = xmin + stripSec;  // rolling time window
+
+// Calculate the pixel size of each x and y unit, 
+// the placement of the axis, and size of axis divisions
+// The screen size is SCREEN_W by SCREEN_H.
+// The origin is in the upper left corner.
+  *xunit = (SCREEN_W-XB)/(xmax-xmin);     // display space / value space
+//*yunit = (SCREEN_H-YB)/(ymax-ymin);     // display space / value space (bp)
+  *yunit = (SCREEN_H-2*YB)/(ymax-ymin);   // display space / value space (up)
+
+// location of the coordinate system in the display space
+  *xo = XB + (*xunit)*(-xmin);         
+  *yo = YB + (*yunit)*(ymax);
+  dx = (int16_t)( MAX ( SCREEN_W - *xo , *xo - XB )/10.0 ); // x-hatch increment
+  dy = (int16_t)( MAX ( SCREEN_H - *yo , *yo - YB )/ 5.0 ); // y-hatch increment
+
+/* ------------------------------------------ 
+//  check values for setting up the graph
+printf("----------------------------\n");
+printf(" SCREEN_W = %d \n", SCREEN_W);
+printf(" xmin = %f \n", xmin );
+printf(" xmax = %f \n", xmax );
+printf(" xo = %f \n", *xo);
+printf(" xu = %f \n", *xunit);
+printf(" dx = %d \n", dx);
+printf("----------------------------\n");
+printf(" SCREEN_H = %d \n", SCREEN_H);
+printf(" ymin = %f \n", ymin );
+printf(" ymax = %f \n", ymax );
+printf(" yo = %f \n", *yo);
+printf(" yu = %f \n", *yunit);
+printf(" dy = %d \n", dy);
+printf("----------------------------\n");
+printf(" title = %s \n", title);
+printf(" x-axis label: %s \n", Xlabel );
+printf(" y-axis label: %s \n", Ylabel );
+printf("----------------------------\n\n");
+ ------------------------------------------ */
+
+  // initialize XCB
+
+  // open the connection to the X server, if there is one
+  if ( getenv ( "DISPLAY" ) == NULL )  return 1;    // headless
+  connection = xcb_connect (NULL, NULL);
+  if ( xcb_connection_has_error (connection) ) {
+    xcb_disconnect (connection);
+    return 1;
+  }
+
+  // get the first screen, window, and foreground 
+  screen     = xcb_setup_roots_iterator (xcb_get_setup (connection)).data;
+  window     = screen->root;
+  foreground = xcb_generate_id (connection);
+
+  // create a graphic context with window foreground and exposure
+  gc_mask = XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES ;
+  gc_value[0] = 0xFF;
+  gc_value[1] = 0x0;
+  xcb_create_gc (connection, foreground, window, gc_mask, gc_value);
+
+  // get the window id 
+  window = xcb_generate_id (connection);
+
+  // create a graphic context for window background and events 
+  gc_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+  gc_value[0] = screen->black_pixel;  
+  gc_value[1] = XCB_EVENT_MASK_EXPOSURE;
+
+  // create the window 
+  xcb_create_window ( connection,                    /* connection      */
+                      XCB_COPY_FROM_PARENT,          /* depth           */
+                      window,                        /* window Id       */
+                      screen->root,                  /* parent window   */
+                      0, SCREEN_H/2,                 /* x, y            */
+                      SCREEN_W, SCREEN_H,            /* width, height   */
+                      10,                            /* border_width    */
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, /* class           */
+                      screen->root_visual,           /* visual          */
+                      gc_mask, gc_value );           /* mask and values */
+
+  // map the window onto the connection and flush the connection
+  xcb_map_window (connection, window);
+
+  gc_mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y; /* window position */
+  gc_value[0] = SCREEN_X;
+  gc_value[1] = SCREEN_Y;
+
+  xcb_configure_window( connection, window, gc_mask, gc_value );
+
+  xcb_flush (connection);
+
+  // change the title of the window
+  xcb_change_property(connection,
+        XCB_PROP_MODE_REPLACE,
+        window,
+        XCB_ATOM_WM_NAME,
+        XCB_ATOM_STRING,
+        8,
+        strlen(title),
+        title);
+   xcb_flush (connection);
+
+  // don't wait for the window to be mapped ... the expose events are
+  // served from the pixmap by plot_flush()
+
+  // draw into an off-screen pixmap, copied to the window frame by frame
+  scr    = screen;
+  pixmap = xcb_generate_id (connection);
+  xcb_create_pixmap (connection, screen->root_depth, pixmap, window,
+                     SCREEN_W, SCREEN_H );
+  gc_value[0] = 0;                        // no exposure events from copies
+  copyGC = xcb_generate_id (connection);
+  xcb_create_gc (connection, copyGC, pixmap, XCB_GC_GRAPHICS_EXPOSURES, gc_value);
+  gc_value[0] = screen->black_pixel;
+  gc_value[1] = 0;
+  clearGC = xcb_generate_id (connection);
+  xcb_create_gc (connection, clearGC, pixmap,
+                 XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES, gc_value );
+  {
+    xcb_rectangle_t  all = { 0, 0, SCREEN_W, SCREEN_H };
+    xcb_poly_fill_rectangle (connection, pixmap, clearGC, 1, &all );
+  }
+
+  // change the graphic context for line colors
+  gc_mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND ;
+  xcb_change_gc  (connection, foreground, gc_mask, axisClr );
+
+  // x-axis coordinate line 
+  ll->x1 =  XB;
+  ll->y1 = (int16_t)(*yo); 
+  ll->x2 =  SCREEN_W; 
+  ll->y2 = (int16_t)(*yo);
+//printf(" lx = %d %d %d %d \n", (int)(ll->x1), (int)(ll->y1), (int)(ll->x2), (int)(ll->y2) ); // debug
+  xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+
+  // y-axis coordinate line 
+  ll->x1 = (int16_t)(*xo);
+  ll->y1 =  YB; 
+  ll->x2 = (int16_t)(*xo);
+  ll->y2 =  SCREEN_H-YB;
+//printf(" ly = %d %d %d %d \n", (int)(ll->x1), (int)(ll->y1), (int)(ll->x2), (int)(ll->y2) ); //debug
+  xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+
+  // hatch marks and numbering on the positive x axis
+  for (i=1; i<10; i++) {
+    xh = (int16_t)(*xo+i*dx); 
+    if (xh > SCREEN_W)  
+      break;
+    sprintf( ht, "%.1f", (xh-*xo)/(*xunit) );   // x-hatch text
+    ll->x1 = xh,
+    ll->y1 = (int16_t)(*yo-YB/5)  ; 
+    ll->x2 = xh,
+    ll->y2 = (int16_t)(*yo+YB/5);
+    xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+    draw_text (connection, screen, pixmap, xh+3,(int16_t)(*yo+12), textClr,0x0, ht);
+  }
+  // hatch marks and numbering on the negative x axis
+  for (i=1; i<10; i++) {
+    xh = (int16_t)(*xo-i*dx); 
+    if (xh < XB)  
+      break;
+    sprintf( ht, "%.1f", (*xo-xh)/(*xunit) );   // x-hatch text
+    ll->x1 = xh,
+    ll->y1 = (int16_t)(*yo-YB/5)  ; 
+    ll->x2 = xh;
+    ll->y2 = (int16_t)(*yo+YB/5);
+    xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+    draw_text (connection, screen, pixmap, xh+3,(int16_t)(*yo+12), textClr,0x0, ht);
+  }
+  // hatch marks and numbering on the positive y axis
+  for (i=1; i<5; i++) {
+    yh = (int16_t)(*yo-i*dy); 
+    if (yh < YB)  
+      break;
+    sprintf( ht, "%4.1f", (*yo-yh)/(*yunit) );   // y-hatch text
+    ll->x1 = (int16_t)(*xo-XB/5)  ; 
+    ll->y1 = yh,
+    ll->x2 = (int16_t)(*xo+XB/5);
+    ll->y2 = yh,
+    xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+    draw_text (connection, screen, pixmap, (int16_t)(*xo-XB), yh-3, textClr,0x0,ht);
+  }
+  // hatch marks and numbering on the negative y axis
+  for (i=1; i<5; i++) {
+    yh = (int16_t)(*yo+i*dy); 
+    if (yh > SCREEN_H)  
+      break;
+    sprintf( ht, "%4.1f", (*yo-yh)/(*yunit) );   // y-hatch text
+    ll->x1 = (int16_t)(*xo-XB/5)  ; 
+    ll->y1 = yh,
+    ll->x2 = (int16_t)(*xo+XB/5);
+    ll->y2 = yh,
+    xcb_poly_segment (connection, pixmap, foreground, 1, ll );
+    draw_text (connection, screen, pixmap, (int16_t)(*xo-XB), yh-3, textClr,0x0,ht);
+  }
+
+// draw title and axis labels 
+//draw_text (connection,screen,pixmap, SCREEN_W/4, YB/2, textClr,0x0, title );
+  draw_text (connection,screen,pixmap, (int)(0.95*SCREEN_W),*yo+YB/2, textClr,0x0, Xlabel);
+  draw_text (connection,screen,pixmap, (int)(XB/2),(int)(YB-6), textClr,0x0, "full scale" );
+
+  //  Display the channel labels in color of the lines, and create one
+  //  graphic context per channel so the color is never changed while plotting
+  gc_mask     = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
+  for ( chn = 0; chn < nChnl; chn++ ) {
+//  sprintf(chnl[chn].label, "channel %2d", chn); // debug
+    gc_value[0] = CHNL_COLR[chn % 8];
+    chnlGC[chn] = xcb_generate_id (connection);
+    xcb_create_gc (connection, chnlGC[chn], window, gc_mask, gc_value);
+    draw_text (connection, screen, pixmap,
+            SCREEN_W-100, YB+15*(chn+1), CHNL_COLR[chn % 8],0x0, chnl[chn].label );
+  }
+
+  // segment arrays for one frame of scans ... each scan may finish at most
+  // one column of two segments, and the open column adds two more
+  frameScans = (unsigned)( sr / PLOT_FPS );
+  if ( frameScans < 1 )  frameScans = 1;
+  for ( chn = 0; chn < nChnl; chn++ ) {
+    segs[chn] = (xcb_segment_t *) calloc ( 2*frameScans+2, sizeof(xcb_segment_t) );
+    nSegs[chn] = 0;
+    col[chn].x = col[chn].xPrev = -1;
+  }
+  plotChnl = nChnl;
+
+  xOrig = *xo;   xUnit = *xunit;   yOrig = *yo;
+  hatchSec = dx / (*xunit);
+  legend = chnl;
+  xLabelText = Xlabel;
+  xShift = 0;
+
+  xcb_copy_area (connection, pixmap, window, copyGC, 0,0, 0,0, SCREEN_W,SCREEN_H);
+  xcb_flush (connection);
+
+  fprintf(stderr," plot set up  . . . . . . . . . . . . . . . . . . . . . . . . . .  success \n"); 
+  return 0;
+}
+
+
+/*
+ * x_hatches - x axis line, hatch marks and numbering over the pixel columns
+ * x1 to x2 of the pixmap, and the legend and labels, after a scroll 19oct26
+ * -------------------------------------------------------------------------*/
+static void x_hatches ( int16_t x1, int16_t x2 )
+{
+  xcb_segment_t  ll = { x1, (int16_t) yOrig, x2, (int16_t) yOrig };
+  uint32_t       textClr = 0xecddc6e;
+  char           ht[16];
+  int16_t        xh;
+  int            k, chn;
+
+  xcb_poly_segment (connection, pixmap, foreground, 1, &ll );
+
+  for ( k = (int) ceil ( (x1 - 40 + xShift - xOrig) / xUnit / hatchSec );
+        ( xh = (int16_t)( xOrig + k*hatchSec*xUnit - xShift ) ) <= x2; k++ ) {
+    if ( k < 1 )  continue;
+    sprintf( ht, "%.1f", k*hatchSec );          // x-hatch text
+    ll.x1 = ll.x2 = xh;
+    ll.y1 = (int16_t)(yOrig-YB/5);
+    ll.y2 = (int16_t)(yOrig+YB/5);
+    xcb_poly_segment (connection, pixmap, foreground, 1, &ll );
+    draw_text (connection, scr, pixmap, xh+3,(int16_t)(yOrig+12), textClr,0x0, ht);
+  }
+
+  draw_text (connection,scr,pixmap, (int)(0.95*SCREEN_W),yOrig+YB/2, textClr,0x0, xLabelText);
+  draw_text (connection,scr,pixmap, (int)(XB/2),(int)(YB-6), textClr,0x0, "full scale" );
+  for ( chn = 0; chn < plotChnl; chn++ )
+    draw_text (connection, scr, pixmap,
+            SCREEN_W-100, YB+15*(chn+1), CHNL_COLR[chn % 8],0x0, legend[chn].label );
+}
+
+
+/*
+ * plot_scroll - scroll the plot area of the pixmap left by step pixels,
+ * and clear and re-label the columns uncovered at the right.  The legend
+ * and the x label, which stay in place, are scrolled with the traces, so
+ * their scrolled copies are cleared before they are drawn again     19oct26
+ * -------------------------------------------------------------------------*/
+static void plot_scroll ( int16_t step )
+{
+  int16_t          xLabel = (int16_t)(0.95*SCREEN_W);  // x label column
+  xcb_rectangle_t  clear[3] = {
+         { SCREEN_W-step, 0, step, SCREEN_H },              // uncovered
+         { SCREEN_W-100-step, YB, 100, 15*plotChnl+5 },     // scrolled legend
+         { xLabel-step, (int16_t)(yOrig+1), SCREEN_W-xLabel, YB/2+4 } };
+                                                            // ... and x label
+  uint8_t          chn;
+
+  plot_flush ();                              // finish what is pending
+
+  xcb_copy_area (connection, pixmap, pixmap, copyGC,
+                 XB+1+step, 0,  XB+1, 0,  SCREEN_W-(XB+1)-step, SCREEN_H );
+  xcb_poly_fill_rectangle (connection, pixmap, clearGC, 3, clear );
+
+  xShift += step;
+  for (chn = 0; chn < plotChnl; chn++) {
+    col[chn].x -= step;
+    if ( col[chn].xPrev >= 0 )  col[chn].xPrev -= step;
+  }
+
+  x_hatches ( xLabel-step, SCREEN_W );       // with the hatches cleared
+  dmgLo = XB+1;                               // the whole plot area changed
+  dmgHi = SCREEN_W-1;
+}
+
+
+/*
+ * column_segments - append the segments of a pixel column to seg[] and
+ * return the number appended                                        19oct26
+ * -------------------------------------------------------------------------*/
+static unsigned column_segments ( struct COLUMN *c, xcb_segment_t *seg )
+{
+  unsigned  n = 0;
+
+  if ( c->xPrev >= 0 ) {                     // join to the column before
+    seg[n].x1 = c->xPrev;  seg[n].y1 = c->yPrev;
+    seg[n].x2 = c->x;      seg[n].y2 = c->first;
+    ++n;
+  }
+  if ( c->max != c->min || n == 0 ) {         // the range of this column
+    seg[n].x1 = c->x;      seg[n].y1 = c->min;
+    seg[n].x2 = c->x;      seg[n].y2 = c->max;
+    ++n;
+  }
+  if ( c->xPrev >= 0 && c->xPrev < dmgLo )  dmgLo = c->xPrev;
+  if ( c->x < dmgLo )  dmgLo = c->x;
+  if ( c->x > dmgHi )  dmgHi = c->x;
+  return n;
+}
+
+
+/*
+ * plot_data - decimate a scan of data points, scaled to volts and seconds,
+ * into pixel columns, and draw the frame when it is full; adScan holds the
+ * channels of scan scn                                              19oct26
+ * -------------------------------------------------------------------------*/
+void plot_data ( int8_t nChnl, float sr, unsigned scn,  int32_t adScan[],
+                 float xo, float yo, float xu, float yu, uint8_t *rangeCode)
+{
+  uint8_t        chn;
+  int32_t        xs = (int32_t)(xo+xu*(scn/sr)) - xShift;
+  int16_t        x, y;
+  struct COLUMN *c;
+
+  if ( plotChnl == 0 )  return;              // headless
+
+  if ( stripSec > 0.0 && xs >= SCREEN_W ) {  // strip chart ... scroll
+    int16_t  step = (int16_t) MAX ( xs - SCREEN_W + 1, (SCREEN_W-XB)/10 );
+    plot_scroll ( step );
+    xs -= step;
+  }
+  x = (int16_t) xs;
+
+  for (chn = 0; chn < plotChnl; chn++) {
+    c = &col[chn];
+    y = (int16_t)(yo-yu*((adScan[chn]))/ADMAX);
+    if ( x == c->x ) {                       // the same pixel column
+      if ( y < c->min )  c->min = y;
+      if ( y > c->max )  c->max = y;
+      c->last = y;
+    } else {                                 // a new pixel column
+      if ( c->x >= 0 ) {
+        nSegs[chn] += column_segments ( c, segs[chn] + nSegs[chn] );
+        c->xPrev = c->x;
+        c->yPrev = c->last;
+      }
+      c->x = x;
+      c->first = c->last = c->min = c->max = y;
+    }
+  }
+
+  if ( ++scansInFrame >= frameScans )  plot_flush ();
+
+  return;
+}
+
+
+/*
+ * plot_flush - draw the finished columns and the open column of each
+ * channel with one poly segment into the pixmap, copy the changed columns
+ * to the window, restore exposed parts of the window, and flush     19oct26
+ * -------------------------------------------------------------------------*/
+void plot_flush ( void )
+{
+  uint8_t        chn;
+  unsigned       n;
+  xcb_generic_event_t *event;
+  xcb_expose_event_t  *expose;
+
+  if ( plotChnl == 0 )  return;
+
+  for (chn = 0; chn < plotChnl; chn++) {
+    n = nSegs[chn];
+    if ( col[chn].x >= 0 )                   // the open column, so far
+      n += column_segments ( &col[chn], segs[chn] + n );
+    if ( n > 0 )
+      xcb_poly_segment (connection, pixmap, chnlGC[chn], n, segs[chn] );
+    nSegs[chn] = 0;
+  }
+  scansInFrame = 0;
+
+  if ( dmgHi >= dmgLo ) {                    // copy only the changed columns
+    xcb_copy_area (connection, pixmap, window, copyGC,
+                   dmgLo-1, 0,  dmgLo-1, 0,  dmgHi-dmgLo+3, SCREEN_H );
+    dmgLo = SCREEN_W;
+    dmgHi = -1;
+  }
+
+  while ( (event = xcb_poll_for_event (connection)) != NULL ) {
+    if ( (event->response_type & ~0x80) == XCB_EXPOSE ) {
+      expose = (xcb_expose_event_t *) event;  // restore from the pixmap
+      xcb_copy_area (connection, pixmap, window, copyGC,
+                     expose->x, expose->y,  expose->x, expose->y,
+                     expose->width, expose->height );
+    }
+    free ( event );
+  }
+
+  xcb_flush (connection);      // once per frame
+  return;
+}
+
+
+/*
+ * plot_close - release the pixmap, graphic contexts and segment arrays 19oct26
+ * -------------------------------------------------------------------------*/
+void plot_close ( void )
+{
+  uint8_t        chn;
+
+  if ( plotChnl > 0 ) {
+    xcb_free_pixmap (connection, pixmap);
+    xcb_free_gc (connection, copyGC);
+    xcb_free_gc (connection, clearGC);
+  }
+  for (chn = 0; chn < plotChnl; chn++) {
+    xcb_free_gc (connection, chnlGC[chn]);
+    free ( segs[chn] );
+    segs[chn] = NULL;
+  }
+  plotChnl = 0;
+  return;
+}
+
+
+/*
+ * plot_bffr_data - plot a scan of data points scaled to volts and seconds
+ * -------------------------------------------------------------------------*/
+void plot_bffr_data ( int8_t firstChnl, int8_t lastChnl, unsigned nChnl,
+                     float sr, unsigned nBffr, unsigned spl,  uint16_t adData[],
+                     float xo, float yo, float xu, float yu, uint8_t *rangeCode)
+{
+  unsigned       firstScn = (unsigned)((float)(spl-nBffr)/nChnl),
+                 lastScn  = (unsigned)((float)spl/nChnl),
+                 scn, chn,sp;
+  xcb_point_t    p = {0,0};
+
+//delay_us(10);
+  sp=0;
+  for (scn = firstScn; scn <= lastScn; scn++) {
+    p.x = (int16_t)(xo+xu*(scn/sr));
+    for (chn = firstChnl; chn <= lastChnl; chn++) {
+
+//    p.y = (int16_t)(yo-yu*((adData[scn*nChnl+chn])*voltRange/ADMAX));
+//    p.y = (int16_t)(yo-yu*((ADMID)*voltRange/ADMAX));   // bi-polar AtoD
+      p.y = (int16_t)(yo-yu*((float)(adData[spl-nBffr+sp])/ADMID-1.0)); // bi-polar AtoD
+
+//rintf(stderr," scn= %4d chn= %4d sp=%4d  data=%d ... p.x= %6d  p.y= %6d \n", scn, chn,  spl-nBffr+sp, adData[scn*nChnl+chn], p.x, p.y );
+
+      xcb_poly_point (connection, XCB_COORD_MODE_ORIGIN, window, chnlGC[chn],1,&p);
+      ++sp;
+
+/*
+      if ( scan>0 ) line( display,
+      (int)(y_axis+xu*((scan-1)/sr-xoff)) ,
+      (int)(x_axis-yu*((adData[scan*nChnl+i-nChnl]-0x8000)*voltRange/32567-yoff)) ,
+      (int)(y_axis+xu*(scan/sr-xoff)) , 
+      (int)(x_axis-yu*((adData[scan*nChnl+i]-0x8000)*voltRange/32576-yoff)) , i );
+*/
+    }
+    if ( sp >= nBffr )  break; 
+  }             
+  xcb_flush (connection);      // wait for all N_smpls samples before flushing
+  return;
+}
@@ -0,0 +1,68 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGplot.h
+ *
+ *    Description:  header file for HPGplot.c
+ *                  real time plotting of the scanned data with xcb
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGPLOT_H_
+#define _HPGPLOT_H_
+
+#include "HPGdaac.h"         // struct CHNL, SCREEN_W, SCREEN_H, NUMCHNL
+
+#define PLOT_FPS   30        /* frames drawn per second                      */
+
+/* set up a plot screen, 1 if there is no X display */
+int  plot_setup ( float    *xunit,
+                  float    *yunit,
+                  float    *xo,
+                  float    *yo,
+                  float     xmin,
+                  float     xmax,
+                  uint8_t  *rangeCode,
+                  char      title[],
+                  char      xLabel[],
+                  char      yLabel[],
+                  int8_t    nChnl,
+                  struct CHNL chnl[],
+                  float     sr,
+                  float     strip );
+
+/* decimate a scan of data points to pixel columns, draw the frame when it is full */
+void plot_data ( int8_t     nChnl,
+                 float      sr,
+                 unsigned   scan,
+                 int32_t    adScan[],
+                 float      xo,
+                 float      yo,
+                 float      xu,
+                 float      yu,
+                 uint8_t   *rangeCode );
+
+/* draw the segments of the current frame and flush the connection */
+void plot_flush ( void );
+
+/* release the graphic contexts and segment arrays */
+void plot_close ( void );
+
+/* plot a buffer of data points */
+void plot_bffr_data ( int8_t     firstChnl,
+                      int8_t     lastChnl,
+                      unsigned   nChnl,
+                      float      sr,
+                      unsigned   nBffr,
+                      unsigned   spl,
+                      uint16_t   adData[],
+                      float      xo,
+                      float      yo,
+                      float      xu,
+                      float      yu,
+                      uint8_t   *rangeCode );
+
+#endif // _HPGPLOT_H_
@@ -0,0 +1,87 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGplugin.h
+ *
+ *    Description:  controller plug-in interface for HPGdaac
+ *
+ *   A controller plug-in is a shared object, named in the configuration
+ *   file in place of a controller data file, that exports
+ *
+ *     int  hpg_plugin_abi = HPG_PLUGIN_ABI;
+ *     int  hpg_init   ( struct HPG_PLUGIN_INFO *info );
+ *     void hpg_step   ( const float *y, float *u,
+ *                       const struct CTRLCNST *ctrlCnst,
+ *                       uint32_t scan, void *state );
+ *     void hpg_finish ( void *state );
+ *
+ *   hpg_init() is called once, before the test.  It describes the plug-in
+ *   in *info, may allocate and initialize its own state, and returns 0, or
+ *   1 to stop the test.
+ *
+ *   hpg_step() is called once per scan from the scan handler, in real time.
+ *   y[0..nIn-1] are the inputs in the sensor units of the sensitivity file,
+ *   relative to the pre-test average, and u[0..nOut-1] are the outputs in
+ *   volts.  Both arrays are allocated by HPGdaac.  ctrlCnst[1..15] are the
+ *   control constants of the configuration file.  hpg_step() must not
+ *   allocate memory, do input or output, or wait, and should return within
+ *   info->budget_us micro-seconds.  The step time is measured every scan;
+ *   outputs that are not finite are written to the D/A as zero volts, even
+ *   below uMin, and a plug-in that overruns its budget on
+ *   info->overrunLimit consecutive scans is stopped and its D/A outputs are
+ *   set to zero volts for the rest of the test.
+ *
+ *   hpg_finish() is called once, after the test, to release the state.
+ *
+ *   to compile a plug-in:   make plugins
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGPLUGIN_H_
+#define _HPGPLUGIN_H_
+
+#include <stdint.h>
+
+#define HPG_PLUGIN_ABI    1     /* change when this interface changes       */
+#define HPG_PLUGIN_MAXIO  8     /* maximum number of inputs or outputs      */
+
+#ifndef MAXL
+#define MAXL            256     /* maximum line length allowed for labels   */
+#endif
+
+  struct CTRLCNST {     // control constants for feedback control
+         char label[MAXL];     // control constant label
+         float val;            // control constant value
+      };
+
+  struct HPG_PLUGIN_INFO {
+         // set by HPGdaac before hpg_init()
+         int    abi;                         // HPG_PLUGIN_ABI of HPGdaac
+         int    nChnl;                       // number of A/D channels scanned
+         float  dt;                          // scan period, seconds
+         // set by hpg_init()
+         char   title[MAXL];                 // plug-in description
+         int    nIn;                         // number of inputs
+         int    inChnl[HPG_PLUGIN_MAXIO];    // A/D channel of each input
+         int    nOut;                        // number of outputs, 1 or 2
+         int    outDA[HPG_PLUGIN_MAXIO];     // D/A channel of each output
+         float  uMin, uMax;                  // output limits, volts
+         float  budget_us;                   // step time budget, 0: dt/4
+         int    overrunLimit;                // consecutive overruns, 0: 10
+         void  *state;                       // plug-in state, passed to step
+      };
+
+typedef int  (*HPG_PLUGIN_INIT)   ( struct HPG_PLUGIN_INFO *info );
+
+typedef void (*HPG_PLUGIN_STEP)   ( const float *y,
+                                    float *u,
+                                    const struct CTRLCNST *ctrlCnst,
+                                    uint32_t scan,
+                                    void *state );
+
+typedef void (*HPG_PLUGIN_FINISH) ( void *state );
+
+#endif // _HPGPLUGIN_H_
@@ -0,0 +1,266 @@
+/*******************************************************************************
+HPGsched.c
+multi-rate scan schedule ... control and acceleration channels in every scan,
+slow channels such as temperatures and strains in every d-th scan
+
+Each channel has a rate divisor d (1 by default) and is converted in the
+scans for which  scan % d == phase .  The phases of the channels with the
+same divisor are chosen, one channel at a time, to keep the number of
+conversions in the busiest scan of the major frame as small as possible, so
+slow channels are spread evenly over the scans instead of converted all in
+the same scan.  The scan rate is then limited by the conversions in the
+busiest scan, maxConv, rather than by the number of channels.  A channel
+that averages several conversions in each scan it is converted in counts as
+that many conversions.
+
+The conversions of each rate group (the channels with the same divisor
+d > 1) are also stored in a buffer of their own, one row per d scans, and
+saved to the file <data file>.r<d>, with the scan number of each row.  In
+the data file itself, a slow channel holds its latest conversion between
+the scans in which it is converted, so the data file keeps one value of
+every channel in every scan.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+
+// local libraries .. .
+#include "HPGsched.h"                 // header for the scan schedule
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* GCD - the greatest common divisor of a and b
+---------------------------------------------------------------------------*/
+static unsigned gcd ( unsigned a, unsigned b )
+{
+  unsigned  t;
+
+  while ( b ) { t = a % b;  a = b;  b = t; }
+  return a;
+}
+
+
+/* SCHED_BUILD - choose the phase of each channel, and list the channels
+   converted in each scan of the major frame, after the first nFirst
+   channels of the scan order, which are converted in every scan.
+   returns 0: successful  1: abnormal                                 19oct26
+---------------------------------------------------------------------------*/
+int sched_build ( struct SCHED *s, unsigned nChnl, unsigned *div,
+                  uint8_t *avg, uint8_t *cnv, unsigned nFirst, unsigned *scanOrder,
+                  uint8_t *muxOrder, uint8_t *rangeOrder )
+{
+  unsigned  load[SCHED_MAXFRAME],      // conversions in each scan
+            chn, c, d, f, k, p, g,
+            best, worst, sum, bestWorst, bestSum;
+  unsigned long  frame = 1;
+
+  memset ( s, 0, sizeof(*s) );
+  s->nChnl = nChnl;
+
+  for (chn=0; chn<nChnl; chn++) {
+    if ( div[chn] < 1 )  div[chn] = 1;
+    s->div[chn] = div[chn];
+    frame = frame / gcd ( frame, div[chn] ) * div[chn];
+    if ( frame > SCHED_MAXFRAME ) {
+      errorMsg("  sched_build: the rate divisors repeat in more than 1000 scans");
+      return 1;
+    }
+  }
+  for (k=0; k<nFirst; k++)
+    if ( s->div[scanOrder[k]] != 1 ) {
+      errorMsg("  sched_build: control and loopback channels need rate divisor 1");
+      return 1;
+    }
+  s->nFrame = (unsigned) frame;
+
+  // the phases, from the smallest divisor to the largest
+  for (f=0; f<s->nFrame; f++)  load[f] = 0;
+  for (d=1; d<=s->nFrame; d++)
+    for (chn=0; chn<nChnl; chn++) {
+      if ( s->div[chn] != d )  continue;
+      best = 0;  bestWorst = bestSum = ~0u;
+      for (p=0; p<d; p++) {                  // the least loaded phase
+        for (worst=sum=0, f=p; f<s->nFrame; f+=d) {
+          if ( load[f] > worst )  worst = load[f];
+          sum += load[f];
+        }
+        if ( worst < bestWorst || ( worst == bestWorst && sum < bestSum ) ) {
+          bestWorst = worst;  bestSum = sum;  best = p;
+        }
+      }
+      s->phase[chn] = best;
+      for (f=best; f<s->nFrame; f+=d)  load[f] += avg[chn];
+    }
+
+  // the channels of each scan of the major frame, in the scan order
+  for (f=0; f<s->nFrame; f++) {
+    if ( load[f] > s->maxConv )  s->maxConv = load[f];
+    for (k=nFirst; k<nChnl; k++) {
+      c = scanOrder[k];
+      if ( f % s->div[c] != s->phase[c] )  continue;
+      s->chnl[f][s->n[f]]  = c;
+      s->mux[f][s->n[f]]   = muxOrder[k];
+      s->range[f][s->n[f]] = rangeOrder[k];
+      s->avg[f][s->n[f]]   = avg[c];
+      s->cnv[f][s->n[f]]   = cnv ? cnv[c] : 0;
+      ++s->n[f];
+    }
+  }
+
+  // the rate groups, channels with the same divisor > 1
+  for (d=2; d<=s->nFrame; d++)
+    for (chn=0; chn<nChnl; chn++) {
+      if ( s->div[chn] != d )  continue;
+      for (g=0; g<s->nGroup && s->grp[g].div != d; g++) ;
+      if ( g == s->nGroup )  s->grp[s->nGroup++].div = d;
+      s->group[chn] = g;
+      s->col[chn]   = s->grp[g].nChnl;
+      s->grp[g].chnl[s->grp[g].nChnl++] = chn;
+    }
+
+  if ( s->nFrame > 1 ) {
+    fprintf(stderr," rate divisors");
+    for (chn=0; chn<nChnl; chn++)  fprintf(stderr," %u", s->div[chn] );
+    fprintf(stderr,"   %u scans per major frame, at most %u conversions per scan\n",
+                     s->nFrame, s->maxConv );
+  }
+
+  return 0;
+}
+
+
+/* SCHED_BYTES - the bytes of the arena for the buffers of the rate groups
+---------------------------------------------------------------------------*/
+size_t sched_bytes ( struct SCHED *s, unsigned nScan )
+{
+  struct SCHED_GROUP *g;
+  size_t    bytes = 0;
+  unsigned  k;
+
+  for (k=0; k<s->nGroup; k++) {
+    g = &s->grp[k];
+    bytes += ARENA_ROUND ( ( (size_t)( nScan + g->div - 1 ) / g->div * g->nChnl + 1 )
+                           * sizeof(int32_t) );
+  }
+  return bytes;
+}
+
+
+/* SCHED_ALLOC - the buffers of the rate groups, from the arena
+   returns 0: successful  1: the arena is full                       19oct26
+---------------------------------------------------------------------------*/
+int sched_alloc ( struct SCHED *s, unsigned nScan, struct ARENA *a )
+{
+  struct SCHED_GROUP *g;
+  unsigned  k;
+
+  for (k=0; k<s->nGroup; k++) {
+    g = &s->grp[k];
+    g->nRow = ( nScan + g->div - 1 ) / g->div;
+    g->data = (int32_t *) arena_alloc ( a, ( (size_t) g->nRow * g->nChnl + 1 )
+                                           * sizeof(int32_t) );
+    if ( g->data == NULL ) {
+      errorMsg("  sched_alloc: the arena is full, no room for the rate groups");
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+/* SCHED_STORE - copy the conversions of the slow channels in this scan to
+   the buffers of their rate groups, from the scan handler            19oct26
+---------------------------------------------------------------------------*/
+void sched_store ( struct SCHED *s, uint32_t scan, int32_t *adScan )
+{
+  struct SCHED_GROUP *g;
+  unsigned  f = scan % s->nFrame, k, c, row;
+
+  for (k=0; k<s->n[f]; k++) {
+    c = s->chnl[f][k];
+    if ( s->div[c] == 1 )  continue;
+    g = &s->grp[s->group[c]];
+    row = scan / g->div;
+    if ( row < g->nRow )  g->data[row * g->nChnl + s->col[c]] = adScan[c];
+  }
+}
+
+
+/* SCHED_SAVE - write each rate group to its own file, dataFilename.r<div>,
+   one row of every d scans, starting with the scan number of the row.
+   returns 0: successful  1: abnormal                                 19oct26
+---------------------------------------------------------------------------*/
+int sched_save ( struct SCHED *s, char *dataFilename, char *title,
+                 float sr, unsigned nScan )
+{
+  struct SCHED_GROUP *g;
+  FILE     *fp;
+  char      filename[512];
+  unsigned  k, j, row, nRow, maxPhase;
+
+  for (k=0; k<s->nGroup; k++) {
+    g = &s->grp[k];
+    for (maxPhase=0, j=0; j<g->nChnl; j++)
+      if ( s->phase[g->chnl[j]] > maxPhase )  maxPhase = s->phase[g->chnl[j]];
+    for (nRow=0; nRow < g->nRow && nRow*g->div + maxPhase < nScan; nRow++) ;
+
+    snprintf ( filename, sizeof(filename), "%s.r%u", dataFilename, g->div );
+    if ( (fp = fopen ( filename, "w" )) == NULL ) {
+      color(0); color(41);
+      fprintf(stderr,"  cannot open rate group file '%s'  ", filename );
+      color(0); fprintf(stderr,"\n"); color(1); color(33);
+      return 1;
+    }
+    fprintf(fp, "%% %s\n", title );
+    fprintf(fp, "%% rate group of data file '%s'\n", dataFilename );
+    fprintf(fp, "%%  %u scans of %u channels every %u scans at %8.3f sps\n",
+                     nRow, g->nChnl, g->div, sr / g->div );
+    fprintf(fp, "%% scan offset, each channel is converted in scan = row scan + offset\n");
+    fprintf(fp, "%%         ");
+    for (j=0; j<g->nChnl; j++)  fprintf(fp, "  %8u", s->phase[g->chnl[j]] );
+    fprintf(fp, "\n");
+    fprintf(fp, "%%     scan");
+    for (j=0; j<g->nChnl; j++)  fprintf(fp, "    chn %2u", g->chnl[j] );
+    fprintf(fp, "\n");
+
+    for (row=0; row<nRow; row++) {
+      fprintf(fp, "%10u", row * g->div );
+      for (j=0; j<g->nChnl; j++)
+        fprintf(fp, "%10d", g->data[row * g->nChnl + j] );
+      fprintf(fp, "\n");
+    }
+    fclose(fp);
+    chOwnGrpMod( filename, 0444 );
+
+    fprintf(stderr,"  chn");
+    for (j=0; j<g->nChnl; j++)  fprintf(stderr," %u", g->chnl[j] );
+    fprintf(stderr,", every %u scans, saved to file '%s'\n", g->div, filename );
+  }
+
+  return 0;
+}
+
+
+/* SCHED_REMOVE - remove the files of the rate groups                 19oct26
+---------------------------------------------------------------------------*/
+void sched_remove ( struct SCHED *s, char *dataFilename )
+{
+  char      filename[512];
+  unsigned  k;
+
+  for (k=0; k<s->nGroup; k++) {
+    snprintf ( filename, sizeof(filename), "%s.r%u", dataFilename, s->grp[k].div );
+    (void) remove ( filename );
+  }
+}
+
+
+/* SCHED_FREE - forget the buffers of the rate groups, freed with the
+   arena                                                             19oct26
+---------------------------------------------------------------------------*/
+void sched_free ( struct SCHED *s )
+{
+  unsigned  k;
+
+  for (k=0; k<s->nGroup; k++)  s->grp[k].data = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGsched.h
+ *
+ *    Description:  header file for HPGsched.c
+ *                  multi-rate scan schedule, channels at sr / divisor
+ *
+ *   A channel with rate divisor d is converted in every d-th scan, in the
+ *   scans  scan % d == phase .  The pattern of conversions repeats every
+ *   nFrame scans (the major frame), the least common multiple of the
+ *   divisors; each scan of the major frame is a minor frame.  Channels
+ *   with the same divisor form a rate group, stored in its own buffer
+ *   with one row per d scans.
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGSCHED_H_
+#define _HPGSCHED_H_
+
+#include <stdint.h>         // uint8_t, int32_t
+#include <stddef.h>         // size_t
+#include "HPGarena.h"       // struct ARENA
+
+#define SCHED_MAXCHNL    32 /* most channels, NUMCHNL                       */
+#define SCHED_MAXFRAME 1000 /* most scans in a major frame                  */
+
+  struct SCHED_GROUP {  // the channels with one rate divisor > 1
+         unsigned  div;                   // converted every div scans
+         unsigned  nChnl;                 // channels in the group
+         unsigned  chnl[SCHED_MAXCHNL];   // channel numbers
+         unsigned  nRow;                  // rows of the buffer, one per div scans
+         int32_t  *data;                  // nRow rows of nChnl A/D values
+      };
+
+  struct SCHED {        // the multi-rate scan schedule
+         unsigned  nChnl;                 // channels in the test
+         unsigned  nFrame;                // scans in the major frame
+         unsigned  maxConv;               // most conversions in one scan
+         unsigned  div[SCHED_MAXCHNL];    // rate divisor of each channel
+         unsigned  phase[SCHED_MAXCHNL];  // first scan of each channel
+         unsigned  group[SCHED_MAXCHNL];  // rate group of a channel with div > 1
+         unsigned  col[SCHED_MAXCHNL];    // ... and its column in the group
+         uint8_t   n[SCHED_MAXFRAME];     // channels after the first, each scan
+         uint8_t   chnl[SCHED_MAXFRAME][SCHED_MAXCHNL]; // ... in scan order
+         uint8_t   mux[SCHED_MAXFRAME][SCHED_MAXCHNL];  // ... their mux codes
+         uint8_t   range[SCHED_MAXFRAME][SCHED_MAXCHNL];// ... their range codes
+         uint8_t   avg[SCHED_MAXFRAME][SCHED_MAXCHNL];  // ... their conversions averaged
+         uint8_t   cnv[SCHED_MAXFRAME][SCHED_MAXCHNL];  // ... their converters
+         unsigned  nGroup;                // rate groups with div > 1
+         struct SCHED_GROUP grp[SCHED_MAXCHNL];
+      };
+
+/* spread the channels of each divisor over the scans of the major frame,
+   the first nFirst channels of the scan order must have divisor 1,
+   a channel averaging avg conversions counts as avg conversions, and is
+   converted by the converter cnv, or the only one with cnv NULL */
+int  sched_build ( struct SCHED *s,
+                   unsigned nChnl,
+                   unsigned *div,
+                   uint8_t *avg,
+                   uint8_t *cnv,
+                   unsigned nFirst,
+                   unsigned *scanOrder,
+                   uint8_t *muxOrder,
+                   uint8_t *rangeOrder );
+
+/* the bytes of the arena for the buffers of the rate groups */
+size_t sched_bytes ( struct SCHED *s,
+                     unsigned nScan );
+
+/* the buffers of the rate groups for nScan scans, from the arena,
+   returns 0: successful  1: the arena is full */
+int  sched_alloc ( struct SCHED *s,
+                   unsigned nScan,
+                   struct ARENA *a );
+
+/* store the conversions of the rate groups in one scan, from the handler */
+void sched_store ( struct SCHED *s,
+                   uint32_t scan,
+                   int32_t *adScan );
+
+/* write each rate group to its own file, dataFilename.r<div> */
+int  sched_save ( struct SCHED *s,
+                  char *dataFilename,
+                  char *title,
+                  float sr,
+                  unsigned nScan );
+
+/* remove the files of the rate groups */
+void sched_remove ( struct SCHED *s,
+                    char *dataFilename );
+
+/* forget the buffers of the rate groups, freed with the arena */
+void sched_free ( struct SCHED *s );
+
+#endif // _HPGSCHED_H_
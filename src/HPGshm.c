@@ -0,0 +1,170 @@
+/*******************************************************************************
+HPGshm.c
+live data ring in POSIX shared memory, the writer
+
+shm_ring_open() creates a named shared memory object, e.g. /HPGdaac, that
+describes the test and the channels and holds a ring of SHM_BLOCKS blocks
+of SHM_BLOCK_SEC seconds of scans.  The scan handler writes each scan
+directly into the ring with shm_ring_scan(), which makes no system calls
+and never waits for a reader, and marks each block with a sequence number
+so that readers in other processes use the scans in place, with no copy
+and no system call per block, and detect when they have been lapped.
+The reader functions are in HPGshm_read.c, and the layout in HPGshm.h.
+The name is removed and created as the user running HPGdaac, not as root
+(HPGuser.c), so only a ring the user could remove is replaced, and the new
+ring is owned by the user.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <errno.h>          // errno
+#include <fcntl.h>          // O_CREAT, O_RDWR
+#include <unistd.h>         // ftruncate, close
+#include <sys/mman.h>       // shm_open, mmap
+
+// local libraries .. .
+#include "HPGdaac.h"                  // struct CHNL, ADMAX, MAX
+#include "HPGshm.h"                   // header for the shared memory ring
+#include "HPGuser.h"                  // user_fs
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+static struct SHM_HEADER *ring = NULL;     // the mapped ring
+static size_t     ringBytes = 0;           // size of the mapping
+static char       ringName[MAXL] = "";
+static uint32_t   blockNum = 0,            // the block being written
+                  blockFill = 0;           // scans in the block so far
+
+#define ROUND64(n)  ( ((n) + 63) & ~(size_t)63 )  /* whole cache lines   */
+
+
+/* BLOCK - the slot of block k                                       19oct26
+---------------------------------------------------------------------------*/
+static struct SHM_BLOCK *block ( uint32_t k )
+{
+  return (struct SHM_BLOCK *) ( (char *) ring + SHM_HDR_BYTES +
+                                (size_t)( k % ring->nBlocks ) * ring->blockBytes );
+}
+
+
+/* SHM_RING_OPEN - create the named shared memory ring, describe the test
+   and the channels, and touch every page before the test.
+   0: ok, 1: the ring could not be created                           19oct26
+---------------------------------------------------------------------------*/
+int shm_ring_open ( char *name, char *title, unsigned nChnl, struct CHNL *chnl,
+                    uint8_t *rangeCode, float sr, unsigned nScan )
+{
+  int       fd, asUser;
+  unsigned  chn, blockScans;
+  size_t    blockBytes;
+
+  blockScans = (unsigned) MAX ( 1.0, sr * SHM_BLOCK_SEC + 0.5 );
+  blockBytes = ROUND64 ( sizeof(struct SHM_BLOCK) + blockScans*nChnl*sizeof(int32_t) );
+  ringBytes  = SHM_HDR_BYTES + SHM_BLOCKS * blockBytes;
+
+  asUser = user_fs ( 1 );                   // only what the user may remove
+  shm_unlink ( name );                      // left over from an earlier test
+  if ( (fd = shm_open ( name, O_CREAT | O_EXCL | O_RDWR, 0644 )) < 0 ||
+       ftruncate ( fd, ringBytes ) ) {
+    errorMsg ( "  shm_ring_open: cannot create the shared memory ring" );
+    fprintf(stderr,"  %s  %s\n", name, strerror ( errno ) );
+    if ( fd >= 0 )  { close ( fd );  shm_unlink ( name ); }
+    user_fs ( asUser );
+    return 1;
+  }
+  ring = mmap ( NULL, ringBytes, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, 0 );
+  close ( fd );
+  if ( ring == MAP_FAILED ) {
+    errorMsg ( "  shm_ring_open: cannot map the shared memory ring" );
+    shm_unlink ( name );
+    user_fs ( asUser );
+    ring = NULL;
+    return 1;
+  }
+  user_fs ( asUser );
+  memset ( ring, 0, ringBytes );            // no page faults in the handler
+
+  ring->version    = SHM_VERSION;
+  ring->nChnl      = nChnl;
+  ring->blockScans = blockScans;
+  ring->nBlocks    = SHM_BLOCKS;
+  ring->blockBytes = blockBytes;
+  ring->nScan      = nScan;
+  ring->sr         = sr;
+  ring->adMax      = ADMAX;
+  strncpy ( ring->title, title, SHM_TEXT-1 );
+  for (chn=0; chn<nChnl && chn<SHM_MAXCHNL; chn++) {
+    strncpy ( ring->chnl[chn].label, chnl[chn].label, SHM_TEXT-1 );
+    strncpy ( ring->chnl[chn].units, chnl[chn].units, SHM_TEXT-1 );
+    ring->chnl[chn].range = ADS1256_range_value ( rangeCode[chn] );
+    ring->chnl[chn].sensi = chnl[chn].sensi;
+    ring->chnl[chn].bias  = chnl[chn].bias;
+    ring->chnl[chn].rms   = chnl[chn].rms;
+  }
+  atomic_store ( &ring->written, 0 );
+  atomic_store ( &ring->done, 0 );
+  atomic_thread_fence ( memory_order_release );
+  ring->magic = SHM_MAGIC;                  // readers may start now
+
+  strncpy ( ringName, name, MAXL-1 );
+  blockNum = blockFill = 0;
+
+  fprintf(stderr," shared memory ring %-16s %4d blocks of %4d scans . . .  success \n",
+                  name, SHM_BLOCKS, blockScans );
+  return 0;
+}
+
+
+/* PUBLISH - mark the block being written complete                   19oct26
+---------------------------------------------------------------------------*/
+static void publish ( void )
+{
+  struct SHM_BLOCK  *b = block ( blockNum );
+
+  b->nScan = blockFill;
+  atomic_store_explicit ( &b->seq, 2*blockNum+2, memory_order_release );
+  atomic_store_explicit ( &ring->written, blockNum+1, memory_order_release );
+  ++blockNum;
+  blockFill = 0;
+}
+
+
+/* SHM_RING_SCAN - write one scan into the ring, from the scan handler.
+   A block is marked odd (being written) before its first scan, and even
+   (complete) after its last.                                         19oct26
+---------------------------------------------------------------------------*/
+void shm_ring_scan ( uint32_t scan, int32_t *adScan )
+{
+  struct SHM_BLOCK  *b;
+
+  if ( ring == NULL )  return;
+
+  b = block ( blockNum );
+  if ( blockFill == 0 ) {
+    atomic_store_explicit ( &b->seq, 2*blockNum+1, memory_order_relaxed );
+    atomic_thread_fence ( memory_order_release );
+    b->scan = scan;
+  }
+  memcpy ( b->data + blockFill*ring->nChnl, adScan, ring->nChnl*sizeof(int32_t) );
+  if ( ++blockFill == ring->blockScans )  publish ();
+}
+
+
+/* SHM_RING_CLOSE - publish the last, partial, block, mark the test
+   complete, and remove the name.  Readers that have the ring mapped keep
+   it until they unmap it.  Safe to call more than once.             19oct26
+---------------------------------------------------------------------------*/
+void shm_ring_close ( void )
+{
+  int  asUser;
+
+  if ( ring == NULL )  return;
+
+  if ( blockFill > 0 )  publish ();
+  atomic_store_explicit ( &ring->done, 1, memory_order_release );
+  munmap ( ring, ringBytes );
+  asUser = user_fs ( 1 );
+  shm_unlink ( ringName );
+  user_fs ( asUser );
+  ring = NULL;
+}
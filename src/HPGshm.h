@@ -0,0 +1,119 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGshm.h
+ *
+ *    Description:  header file for HPGshm.c and HPGshm_read.c
+ *                  live data ring in POSIX shared memory
+ *
+ *   The shared memory object holds a SHM_HEADER followed by nBlocks blocks
+ *   of blockBytes bytes each.  Block k (k = 0, 1, 2, ... for the whole
+ *   test) is stored in slot k % nBlocks.  While block k is being written
+ *   its seq is 2k+1; when it is complete its seq is 2k+2, and
+ *   header.written is k+1.  A reader uses a block in place, then checks
+ *   that its seq has not changed; if it has, the writer has lapped the
+ *   reader and the block must be discarded.  This header does not depend
+ *   on the rest of HPGdaac, so readers need only HPGshm.h and HPGshm_read.c
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGSHM_H_
+#define _HPGSHM_H_
+
+#include <stdint.h>         // uint32_t, int32_t
+#include <stdatomic.h>      // atomic_uint
+
+#define SHM_MAGIC      0x6D475048 /* "HPGm"                                 */
+#define SHM_VERSION    2
+
+#define SHM_BLOCK_SEC  0.01 /* seconds of scans per block                   */
+#define SHM_BLOCKS     1024 /* blocks in the ring                           */
+#define SHM_MAXCHNL      32 /* most channels, NUMCHNL                       */
+#define SHM_TEXT        128 /* length of the title, labels and units        */
+
+#define SHM_OK            0 /* shm_reader_next() return values              */
+#define SHM_WAIT          1 /* the next block is not yet written            */
+#define SHM_OVERRUN       2 /* blocks were lost, the reader was lapped      */
+#define SHM_DONE          3 /* the test is complete and all blocks are read */
+
+  struct SHM_CHNL {     // description of one channel
+         char    label[SHM_TEXT];  // channel description
+         char    units[SHM_TEXT];  // sensitivity units
+         float   range;            // full scale range, volts
+         float   sensi;            // sensitivity, volts per unit
+         double  bias, rms;        // pre-test average and rms, A/D counts
+      };
+
+  struct SHM_HEADER {   // the start of the shared memory object
+         uint32_t     magic;       // SHM_MAGIC
+         uint32_t     version;     // SHM_VERSION
+         uint32_t     nChnl;       // number of channels in each scan
+         uint32_t     blockScans;  // scans in a complete block
+         uint32_t     nBlocks;     // blocks in the ring
+         uint32_t     blockBytes;  // bytes from one block to the next
+         uint32_t     nScan;       // scans in the test
+         float        sr;          // scans per second
+         int32_t      adMax;       // A/D value at full scale
+         char         title[SHM_TEXT];
+         struct SHM_CHNL chnl[SHM_MAXCHNL];
+         atomic_uint  written;     // complete blocks, since the start
+         atomic_uint  done;        // 1: the test is complete
+      };
+
+/* bytes from the start of the ring to the first block, whole cache lines */
+#define SHM_HDR_BYTES  ( ( sizeof(struct SHM_HEADER) + 63 ) & ~(size_t)63 )
+
+  struct SHM_BLOCK {    // one block of consecutive scans
+         atomic_uint  seq;         // 2k+1 while written, 2k+2 when complete
+         uint32_t     scan;        // the first scan of the block
+         uint32_t     nScan;       // scans in the block, <= blockScans
+         uint32_t     pad;
+         int32_t      data[];      // nScan scans of nChnl A/D values
+      };
+
+  struct SHM_READER {   // the state of one reader
+         int          fd;
+         size_t       bytes;       // size of the mapping
+         const struct SHM_HEADER *hdr;
+         uint32_t     next;        // the next block to read
+         uint32_t     seq;         // seq of the block last returned
+         uint32_t     lost;        // blocks lost to overruns
+      };
+
+struct CHNL;
+
+/* create the ring and describe the channels, 0: ok, 1: failed */
+int  shm_ring_open ( char *name,
+                     char *title,
+                     unsigned nChnl,
+                     struct CHNL *chnl,
+                     uint8_t *rangeCode,
+                     float sr,
+                     unsigned nScan );
+
+/* write one scan into the ring, from the scan handler, never blocks */
+void shm_ring_scan ( uint32_t scan,
+                     int32_t *adScan );
+
+/* publish the last block, mark the test complete, remove the name */
+void shm_ring_close ( void );
+
+/* map an existing ring, from its first available block, 0: ok, 1: failed */
+int  shm_reader_open ( const char *name,
+                       struct SHM_READER *r );
+
+/* the next block, in place: SHM_OK, SHM_WAIT, SHM_OVERRUN, or SHM_DONE */
+int  shm_reader_next ( struct SHM_READER *r,
+                       const struct SHM_BLOCK **blk );
+
+/* 1 if the block last returned was not overwritten while it was used */
+int  shm_reader_valid ( struct SHM_READER *r,
+                        const struct SHM_BLOCK *blk );
+
+/* unmap the ring */
+void shm_reader_close ( struct SHM_READER *r );
+
+#endif // _HPGSHM_H_
@@ -0,0 +1,120 @@
+/*******************************************************************************
+HPGshm_read.c
+live data ring in POSIX shared memory, the readers
+
+A reader maps the ring read-only and follows the blocks written by HPGdaac,
+using each block in place:
+
+    struct SHM_READER        r;
+    const struct SHM_BLOCK  *blk;
+
+    shm_reader_open ( "/HPGdaac", &r );
+    while ( (status = shm_reader_next ( &r, &blk )) != SHM_DONE ) {
+      if ( status == SHM_WAIT )  { usleep ( 1000 );  continue; }
+      ... use blk->data[0 .. blk->nScan*r.hdr->nChnl-1] ...
+      if ( !shm_reader_valid ( &r, blk ) )  ... discard, it was overwritten
+    }
+    shm_reader_close ( &r );
+
+Any number of readers may follow the same ring; none of them can slow the
+writer.  A reader more than SHM_BLOCKS-1 blocks behind gets SHM_OVERRUN,
+skips ahead to the oldest block still in the ring, and r.lost counts the
+blocks it missed.  This file depends only on HPGshm.h.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <fcntl.h>          // O_RDONLY
+#include <unistd.h>         // close
+#include <sys/mman.h>       // shm_open, mmap
+#include <sys/stat.h>       // fstat
+
+#include "HPGshm.h"                   // header for the shared memory ring
+
+
+/* SHM_READER_OPEN - map an existing ring, starting from the oldest block
+   still in it.   0: ok, 1: no ring of that name or not a ring       19oct26
+---------------------------------------------------------------------------*/
+int shm_reader_open ( const char *name, struct SHM_READER *r )
+{
+  struct stat  st;
+  uint32_t     w;
+
+  memset ( r, 0, sizeof(*r) );
+  if ( (r->fd = shm_open ( name, O_RDONLY, 0 )) < 0 )  return 1;
+  if ( fstat ( r->fd, &st ) || st.st_size < (off_t) sizeof(struct SHM_HEADER) ) {
+    close ( r->fd );
+    return 1;
+  }
+  r->bytes = st.st_size;
+  r->hdr = mmap ( NULL, r->bytes, PROT_READ, MAP_SHARED, r->fd, 0 );
+  close ( r->fd );
+  r->fd = -1;
+  if ( r->hdr == MAP_FAILED ||
+       r->hdr->magic != SHM_MAGIC || r->hdr->version != SHM_VERSION ) {
+    if ( r->hdr != MAP_FAILED )  munmap ( (void *) r->hdr, r->bytes );
+    r->hdr = NULL;
+    return 1;
+  }
+  atomic_thread_fence ( memory_order_acquire );
+
+  w = atomic_load_explicit ( (atomic_uint *) &r->hdr->written, memory_order_acquire );
+  r->next = ( w > r->hdr->nBlocks-1 ) ? w - (r->hdr->nBlocks-1) : 0;
+  return 0;
+}
+
+
+/* SHM_READER_NEXT - the next block, in place.
+   SHM_OK:      *blk is the next block
+   SHM_WAIT:    the next block is not yet complete
+   SHM_OVERRUN: the reader was lapped, and now continues from the oldest
+                block in the ring; call again
+   SHM_DONE:    the test is complete and every block has been returned 19oct26
+---------------------------------------------------------------------------*/
+int shm_reader_next ( struct SHM_READER *r, const struct SHM_BLOCK **blk )
+{
+  const struct SHM_HEADER  *h = r->hdr;
+  const struct SHM_BLOCK   *b;
+  uint32_t  done, w, s;
+
+  done = atomic_load_explicit ( (atomic_uint *) &h->done,    memory_order_acquire );
+  w    = atomic_load_explicit ( (atomic_uint *) &h->written, memory_order_acquire );
+
+  if ( r->next >= w )  return done ? SHM_DONE : SHM_WAIT;
+
+  b = (const struct SHM_BLOCK *) ( (const char *) h + SHM_HDR_BYTES +
+        (size_t)( r->next % h->nBlocks ) * h->blockBytes );
+  s = atomic_load_explicit ( (atomic_uint *) &b->seq, memory_order_acquire );
+
+  if ( w - r->next > h->nBlocks-1 || s != 2*r->next+2 ) {  // lapped
+    w = atomic_load_explicit ( (atomic_uint *) &h->written, memory_order_acquire );
+    r->lost += w - (h->nBlocks-1) - r->next;
+    r->next  = w - (h->nBlocks-1);
+    return SHM_OVERRUN;
+  }
+
+  *blk = b;
+  r->seq = s;
+  ++r->next;
+  return SHM_OK;
+}
+
+
+/* SHM_READER_VALID - 1 if the block last returned by shm_reader_next()
+   was not overwritten while it was being used, 0 if it was          19oct26
+---------------------------------------------------------------------------*/
+int shm_reader_valid ( struct SHM_READER *r, const struct SHM_BLOCK *blk )
+{
+  atomic_thread_fence ( memory_order_acquire );
+  return atomic_load_explicit ( (atomic_uint *) &blk->seq,
+                                memory_order_relaxed ) == r->seq;
+}
+
+
+/* SHM_READER_CLOSE - unmap the ring                                  19oct26
+---------------------------------------------------------------------------*/
+void shm_reader_close ( struct SHM_READER *r )
+{
+  if ( r->hdr )  munmap ( (void *) r->hdr, r->bytes );
+  r->hdr = NULL;
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+HPGshmcat.c
+follow the shared memory ring of a running HPGdaac test, and display, once
+a second, the number of scans received and the latest value of each channel
+in the units of the sensor configuration file.
+
+An example of a reader of the ring, see HPGshm_read.c
+
+to compile:   make shmcat
+
+to run:       HPGshmcat /HPGdaac
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <unistd.h>         // usleep
+
+#include "HPGshm.h"                   // header for the shared memory ring
+
+
+int main ( int argc, char *argv[] )
+{
+  struct SHM_READER        r;
+  const struct SHM_BLOCK  *blk;
+  const struct SHM_HEADER *h;
+  double     value[SHM_MAXCHNL];
+  uint32_t   scans = 0, bad = 0, chn, second = 0, last;
+  int        status;
+
+  if ( argc != 2 ) {
+    fprintf(stderr,"  usage: HPGshmcat <shared memory ring name, e.g. /HPGdaac>\n");
+    return 1;
+  }
+  while ( shm_reader_open ( argv[1], &r ) )  usleep ( 100000 );  // wait
+  h = r.hdr;
+
+  printf("%s\n %u channels at %.1f scans per second\n", h->title, h->nChnl, h->sr );
+  for (chn=0; chn<h->nChnl; chn++)
+    printf(" chn %u  %-32s %s\n", chn, h->chnl[chn].label, h->chnl[chn].units );
+
+  while ( (status = shm_reader_next ( &r, &blk )) != SHM_DONE ) {
+    if ( status == SHM_WAIT )    { usleep ( 1000 );  continue; }
+    if ( status == SHM_OVERRUN ) continue;
+
+    last = blk->nScan - 1;                  // the last scan of the block
+    for (chn=0; chn<h->nChnl; chn++)
+      value[chn] = ( blk->data[last*h->nChnl+chn] - h->chnl[chn].bias ) *
+                   h->chnl[chn].range / h->adMax / h->chnl[chn].sensi;
+    if ( !shm_reader_valid ( &r, blk ) )  { ++bad;  continue; }
+    scans += blk->nScan;
+
+    if ( (uint32_t)( (blk->scan + last) / h->sr ) > second ) {  // once a second
+      second = (uint32_t)( (blk->scan + last) / h->sr );
+      printf(" %6u s %9u scans ", second, scans );
+      for (chn=0; chn<h->nChnl; chn++)  printf(" %10.4f", value[chn] );
+      printf("\n");
+      fflush(stdout);
+    }
+  }
+
+  printf(" %u scans, %u blocks lost, %u blocks overwritten while read\n",
+           scans, r.lost, bad );
+  shm_reader_close ( &r );
+  return 0;
+}
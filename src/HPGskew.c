@@ -0,0 +1,260 @@
+/*******************************************************************************
+HPGskew.c
+channel-to-channel skew ... the instant each channel is converted in a scan,
+and, optionally, the channels aligned to a common instant in every scan
+
+ADS1256_ChannelScan converts the channels of a scan one after the other and
+returns the instant of each conversion, the middle of the conversion from
+the WAKEUP command to DRDY.  skew_add() is called from the scan handler
+with these instants; their mean, earliest, and latest values after the
+start of the scan are written to the header of the data file, so phase
+sensitive analyses, transfer functions and hysteresis loops, can account
+for the skew of each channel.
+
+With the channels aligned, every channel that is converted in every scan is
+interpolated to the mean conversion instant of those channels, the
+reference instant of the scan.  The sample of channel c in scan k is taken
+at (k + d_c) T, where T is the scan period and d_c the mean instant of the
+channel, in scans, so its value at the reference instant (n + d_r) T lies a
+fraction  s = d_r - d_c  of a scan after its sample in scan n.  The value is
+interpolated with a cubic Lagrange polynomial through four samples of the
+channel, in the Farrow form
+
+  y = ((c3 mu + c2) mu + c1) mu + x0 ,   mu = s - floor(s)
+
+whose coefficients c1, c2, c3 are sums of the samples and do not depend on
+the delay, so the delay of each channel follows the mean instants as they
+are measured during the test.  The two samples after the one interpolated
+are needed, so scan n is aligned in scan n + SKEW_DELAY, in the handler,
+and the last SKEW_DELAY scans are aligned after the test.  All channels of
+a scan are interpolated in one loop.  The aligned data is saved to the file
+<data file>.aln; the data file itself holds the data as converted.
+
+skew_add() and skew_align() do not allocate memory or call the library,
+so they are safe in the scan handler.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // standard string handling library
+#include <math.h>           // fabs, floor, lround
+
+// local libraries .. .
+#include "HPGskew.h"                  // header for the skew measurements
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* SKEW_INIT - start the measurements of a test                       19oct26
+---------------------------------------------------------------------------*/
+void skew_init ( struct SKEW *k, unsigned nChnl, float sr, unsigned *div,
+                 int align )
+{
+  unsigned  c;
+
+  memset ( k, 0, sizeof(*k) );
+  k->nChnl = nChnl;
+  k->T     = 1.0e6 / sr;
+  k->align = align;
+  for (c=0; c<nChnl; c++) {
+    k->div[c] = div[c];
+    k->min[c] = 1e12;
+  }
+}
+
+
+/* SKEW_ADD - add the conversion instant of channel chn, from the scan
+   handler; tScan is the start of the scan                            19oct26
+---------------------------------------------------------------------------*/
+void skew_add ( struct SKEW *k, unsigned chn, uint64_t tConv, uint64_t tScan )
+{
+  double  t = (double)( tConv - tScan );   // micro-seconds
+
+  k->sum[chn] += t;
+  if ( t < k->min[chn] )  k->min[chn] = t;
+  if ( t > k->max[chn] )  k->max[chn] = t;
+  ++k->n[chn];
+}
+
+
+/* SKEW_BYTES - the bytes of the arena for the aligned data         19oct26
+---------------------------------------------------------------------------*/
+size_t skew_bytes ( int align, unsigned nChnl, unsigned nScan )
+{
+  return align ? ARENA_ROUND ( ( (size_t) nScan * nChnl + 1 ) * sizeof(int32_t) ) : 0;
+}
+
+
+/* SKEW_ALLOC - the aligned data from the arena, if the channels are
+   aligned.  returns 0: successful  1: the arena is full              19oct26
+---------------------------------------------------------------------------*/
+int skew_alloc ( struct SKEW *k, unsigned nScan, struct ARENA *a )
+{
+  if ( !k->align )  return 0;
+  k->nScan = nScan;
+  k->data  = (int32_t *) arena_alloc ( a, skew_bytes ( 1, k->nChnl, nScan ) );
+  if ( k->data == NULL ) {
+    errorMsg("  skew_alloc: the arena is full, no room for the aligned data");
+    return 1;
+  }
+  return 0;
+}
+
+
+/* FARROW - align scan n, from the stored scans up to scan last     19oct26
+---------------------------------------------------------------------------*/
+static void farrow ( struct SKEW *k, uint32_t n, uint32_t last )
+{
+  double    d[SKEW_MAXCHNL],     // mean instant of each channel, scans
+            ref = 0,             // reference instant of the scan, scans
+            s, mu, xm, x0, x1, x2, c1, c2, c3;
+  long      b, i[4];
+  unsigned  c, j, m = 0;
+  int32_t  *y;
+
+  if ( n >= k->nScan )  return;
+  y = k->data + (size_t) n * k->nChnl;
+
+  for (c=0; c<k->nChnl; c++) {
+    d[c] = k->n[c] ? k->sum[c] / k->n[c] / k->T : 0.0;
+    if ( k->div[c] == 1 && k->n[c] ) { ref += d[c];  ++m; }
+  }
+  if ( m )  ref /= m;
+
+  for (c=0; c<k->nChnl; c++) {
+    s = ref - d[c];                      // delay of the channel, scans
+    if ( k->div[c] != 1 || k->n[c] == 0 || fabs(s) >= 1.0 )  s = 0.0;
+    b  = (long) n + ( s < 0.0 ? -1 : 0 );
+    mu = s - floor(s);
+    for (j=0; j<4; j++) {                // samples b-1 to b+2
+      i[j] = b - 1 + j;
+      if ( i[j] < 0 )            i[j] = 0;
+      if ( i[j] > (long) last )  i[j] = last;
+    }
+    xm = k->ring[i[0] % SKEW_RING][c];
+    x0 = k->ring[i[1] % SKEW_RING][c];
+    x1 = k->ring[i[2] % SKEW_RING][c];
+    x2 = k->ring[i[3] % SKEW_RING][c];
+
+    c1 = x1 - xm/3.0 - x0/2.0 - x2/6.0;
+    c2 = 0.5*(xm + x1) - x0;
+    c3 = (x2 - xm)/6.0 + 0.5*(x0 - x1);
+    y[c] = (int32_t) lround ( ((c3*mu + c2)*mu + c1)*mu + x0 );
+  }
+}
+
+
+/* SKEW_ALIGN - store a scan, and align the scan SKEW_DELAY before it, from
+   the scan handler                                                   19oct26
+---------------------------------------------------------------------------*/
+void skew_align ( struct SKEW *k, uint32_t scan, int32_t *adScan )
+{
+  if ( !k->data )  return;
+  memcpy ( k->ring[scan % SKEW_RING], adScan, k->nChnl * sizeof(int32_t) );
+  if ( scan >= SKEW_DELAY )  farrow ( k, scan - SKEW_DELAY, scan );
+}
+
+
+/* SKEW_FLUSH - align the last SKEW_DELAY scans of the test, with the last
+   scan repeated after the end of the test                            19oct26
+---------------------------------------------------------------------------*/
+void skew_flush ( struct SKEW *k, uint32_t nScan )
+{
+  uint32_t  n;
+
+  if ( !k->data || nScan == 0 )  return;
+  n = ( nScan > SKEW_DELAY ) ? nScan - SKEW_DELAY : 0;
+  for ( ; n < nScan; n++)  farrow ( k, n, nScan-1 );
+}
+
+
+/* SKEW_HEADER - the mean, earliest, and latest conversion instants of each
+   channel, micro-seconds after the start of the scan, as header lines of
+   the data file                                                      19oct26
+---------------------------------------------------------------------------*/
+void skew_header ( struct SKEW *k, FILE *fp )
+{
+  unsigned  c;
+
+  fprintf(fp, "%% conversion instant after the scan start, micro-sec: mean, earliest, latest \n");
+  for (c=0; c<k->nChnl; c++)
+    fprintf(fp, c == 0 ? "%% %8.1f" : "  %8.1f",
+                k->n[c] ? k->sum[c] / k->n[c] : 0.0 );
+  fprintf(fp, "\n");
+  for (c=0; c<k->nChnl; c++)
+    fprintf(fp, c == 0 ? "%% %8.0f" : "  %8.0f", k->n[c] ? k->min[c] : 0.0 );
+  fprintf(fp, "\n");
+  for (c=0; c<k->nChnl; c++)
+    fprintf(fp, c == 0 ? "%% %8.0f" : "  %8.0f", k->n[c] ? k->max[c] : 0.0 );
+  fprintf(fp, "\n");
+}
+
+
+/* SKEW_SAVE - write the aligned data to the file dataFilename.aln, with the
+   delay of each channel.   returns 0: successful  1: abnormal        19oct26
+---------------------------------------------------------------------------*/
+int skew_save ( struct SKEW *k, char *dataFilename, char *title, float sr )
+{
+  FILE     *fp;
+  char      filename[512];
+  double    ref = 0, d;
+  unsigned  c, m = 0, n;
+
+  if ( !k->data )  return 0;
+
+  for (c=0; c<k->nChnl; c++)
+    if ( k->div[c] == 1 && k->n[c] ) { ref += k->sum[c] / k->n[c];  ++m; }
+  if ( m )  ref /= m;
+
+  snprintf ( filename, sizeof(filename), "%s.aln", dataFilename );
+  if ( (fp = fopen ( filename, "w" )) == NULL ) {
+    color(0); color(41);
+    fprintf(stderr,"  cannot open aligned data file '%s'  ", filename );
+    color(0); fprintf(stderr,"\n"); color(1); color(33);
+    return 1;
+  }
+  fprintf(fp, "%% %s\n", title );
+  fprintf(fp, "%% channels of data file '%s' aligned in time\n", dataFilename );
+  fprintf(fp, "%%  %u scans of %u channels at %8.3f sps, at %.1f micro-sec after the scan start\n",
+                   k->nScan, k->nChnl, sr, ref );
+  fprintf(fp, "%% time shift of each channel to the common instant, micro-sec\n");
+  for (c=0; c<k->nChnl; c++) {
+    d = ( k->div[c] == 1 && k->n[c] ) ? ref - k->sum[c] / k->n[c] : 0.0;
+    if ( fabs(d) >= k->T )  d = 0.0;
+    fprintf(fp, c == 0 ? "%% %8.1f" : "  %8.1f", d );
+  }
+  fprintf(fp, "\n");
+  for (c=0; c<k->nChnl; c++)
+    fprintf(fp, c == 0 ? "%%   chn %2u" : "    chn %2u", c );
+  fprintf(fp, "\n");
+
+  for (n=0; n<k->nScan; n++) {
+    for (c=0; c<k->nChnl; c++)
+      fprintf(fp, "%10d", k->data[n * k->nChnl + c] );
+    fprintf(fp, "\n");
+  }
+  fclose(fp);
+  chOwnGrpMod( filename, 0444 );
+
+  fprintf(stderr,"  channels aligned at %.1f micro-sec after the scan start, saved to file '%s'\n",
+                  ref, filename );
+  return 0;
+}
+
+
+/* SKEW_REMOVE - remove the file of the aligned data                 19oct26
+---------------------------------------------------------------------------*/
+void skew_remove ( struct SKEW *k, char *dataFilename )
+{
+  char  filename[512];
+
+  if ( !k->data )  return;
+  snprintf ( filename, sizeof(filename), "%s.aln", dataFilename );
+  (void) remove ( filename );
+}
+
+
+/* SKEW_FREE - forget the aligned data, freed with the arena         19oct26
+---------------------------------------------------------------------------*/
+void skew_free ( struct SKEW *k )
+{
+  k->data = NULL;
+}
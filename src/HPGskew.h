@@ -0,0 +1,95 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGskew.h
+ *
+ *    Description:  header file for HPGskew.c
+ *                  channel-to-channel skew, and channels aligned in time
+ *
+ *   The channels of a scan are converted one after the other, so each is
+ *   sampled at its own instant after the start of the scan.  The instants
+ *   are measured in every scan, and, optionally, every channel is
+ *   interpolated to the mean instant of the scan with a cubic Lagrange
+ *   fractional delay in Farrow form, SKEW_DELAY scans behind the scan.
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGSKEW_H_
+#define _HPGSKEW_H_
+
+#include <stdio.h>          // FILE
+#include <stdint.h>         // int32_t, uint64_t
+#include <stddef.h>         // size_t
+#include "HPGarena.h"       // struct ARENA
+
+#define SKEW_MAXCHNL   32   /* most channels, NUMCHNL                       */
+#define SKEW_DELAY      2   /* scans from a scan to its aligned scan        */
+#define SKEW_RING       8   /* scans kept for the interpolation, 2^n        */
+
+  struct SKEW {         // conversion instants and the aligned data
+         unsigned  nChnl;                 // channels in the test
+         double    T;                     // scan period, micro-seconds
+         int       align;                 // 1: align the channels
+         unsigned  div[SKEW_MAXCHNL];     // rate divisor of each channel
+         double    sum[SKEW_MAXCHNL];     // sum of the instants, micro-sec
+         double    min[SKEW_MAXCHNL];     // earliest instant, micro-sec
+         double    max[SKEW_MAXCHNL];     // latest instant, micro-sec
+         unsigned  n[SKEW_MAXCHNL];       // conversions measured
+         int32_t   ring[SKEW_RING][SKEW_MAXCHNL]; // the latest scans
+         unsigned  nScan;                 // scans of the aligned data
+         int32_t  *data;                  // nScan scans of nChnl values
+      };
+
+/* start the measurements of a test, with scan rate sr */
+void skew_init ( struct SKEW *k,
+                 unsigned nChnl,
+                 float sr,
+                 unsigned *div,
+                 int align );
+
+/* add the conversion instant of a channel in a scan started at tScan */
+void skew_add ( struct SKEW *k,
+                unsigned chn,
+                uint64_t tConv,
+                uint64_t tScan );
+
+/* the bytes of the arena for the aligned data of nScan scans */
+size_t skew_bytes ( int align,
+                    unsigned nChnl,
+                    unsigned nScan );
+
+/* the aligned data for nScan scans, from the arena;  returns 0: successful */
+int  skew_alloc ( struct SKEW *k,
+                  unsigned nScan,
+                  struct ARENA *a );
+
+/* store a scan, and align the scan SKEW_DELAY scans before it */
+void skew_align ( struct SKEW *k,
+                  uint32_t scan,
+                  int32_t *adScan );
+
+/* align the last SKEW_DELAY scans, after the test */
+void skew_flush ( struct SKEW *k,
+                  uint32_t nScan );
+
+/* write the mean, earliest, and latest instants as data file header lines */
+void skew_header ( struct SKEW *k,
+                   FILE *fp );
+
+/* write the aligned data to dataFilename.aln */
+int  skew_save ( struct SKEW *k,
+                 char *dataFilename,
+                 char *title,
+                 float sr );
+
+/* remove the file of the aligned data */
+void skew_remove ( struct SKEW *k,
+                   char *dataFilename );
+
+/* free the aligned data */
+void skew_free ( struct SKEW *k );
+
+#endif // _HPGSKEW_H_
@@ -0,0 +1,211 @@
+/*******************************************************************************
+HPGstore.c
+the A/D samples of a test ... a list of blocks of whole scans, taken from a
+pool of blocks reserved in the arena of the test, with the samples as 32 bit
+integers or packed in 24 bits
+
+The samples are kept in blocks of at most STORE_BLOCK bytes, each holding a
+whole number of scans.  All of the blocks of the test are reserved before
+the test in the arena (HPGarena.c), which is locked and pre-faulted, so the
+scan handler neither allocates nor page-faults, and the samples need not be
+zeroed.  The list grows by one block from the pool when a scan falls past
+the last block.
+
+The A/D returns 24 bit conversions, stored, as in earlier versions, as twice
+the conversion (see ADS1256_ChannelScan).  Packed, a sample is stored as the
+conversion, in 3 bytes, least significant byte first, and the memory of the
+test is 3/4 of that of 32 bit samples.  The average of several conversions
+(Conversions per scan) may be odd, and is rounded down to even when packed.
+
+The blocks keep the scans in the order they are converted, one scan after
+the other, which is right for the scan handler, but every per-channel
+operation after the test (statistics, scaling, detrending, spectra) would
+then read each channel with a stride of a scan.  store_channels() copies a
+block to one contiguous array per channel.  The transpose runs over tiles
+of STORE_TILE scans, small enough to stay in the L1 cache of the Raspberry
+Pi with the rows of every channel they write, and packed samples are
+unpacked a tile at a time.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <string.h>         // memcpy, memset
+
+// local libraries .. .
+#include "HPGstore.h"                 // header for the sample store
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+
+/* PACK24 - n samples to 3 bytes each, the conversion, LSB first
+---------------------------------------------------------------------------*/
+static void pack24 ( uint8_t *p, const int32_t *v, unsigned n )
+{
+  uint32_t  u;
+
+  while ( n-- ) {
+    u = (uint32_t)( *v++ >> 1 );        // twice the conversion, see above
+    *p++ = (uint8_t)( u );
+    *p++ = (uint8_t)( u >> 8 );
+    *p++ = (uint8_t)( u >> 16 );
+  }
+}
+
+
+/* UNPACK24 - n samples of 3 bytes each, sign extended
+---------------------------------------------------------------------------*/
+static void unpack24 ( int32_t *v, const uint8_t *p, unsigned n )
+{
+  uint32_t  u;
+
+  while ( n-- ) {
+    u = (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16;
+    if ( u & 0x800000 )  u |= 0xFF000000;       // extend a signed number
+    *v++ = 2 * (int32_t) u;
+    p += 3;
+  }
+}
+
+
+/* STORE_LAYOUT - the bytes of a scan and the scans of a block
+---------------------------------------------------------------------------*/
+static void store_layout ( unsigned nChnl, int packed,
+                           unsigned *scanBytes, unsigned *blockScans )
+{
+  *scanBytes  = nChnl * ( packed ? 3 : sizeof(int32_t) );
+  *blockScans = ( *scanBytes > 0 ) ? STORE_BLOCK / *scanBytes : 1;
+  if ( *blockScans < 1 )  *blockScans = 1;
+}
+
+
+/* STORE_BYTES - the bytes of the arena for the samples of nScan scans of
+   nChnl channels, the blocks and their lists                         19oct26
+---------------------------------------------------------------------------*/
+size_t store_bytes ( unsigned nChnl, unsigned nScan, int packed )
+{
+  unsigned  scanBytes, blockScans, n;
+
+  store_layout ( nChnl, packed, &scanBytes, &blockScans );
+  n = ( nScan + blockScans - 1 ) / blockScans;
+  return n * ARENA_ROUND ( (size_t) blockScans * scanBytes ) +
+         2 * ARENA_ROUND ( n * sizeof(uint8_t *) );
+}
+
+
+/* STORE_ALLOC - reserve the blocks of a test in the pool, from the arena
+   returns 0: successful  1: the arena is full                       19oct26
+---------------------------------------------------------------------------*/
+int store_alloc ( struct STORE *st, unsigned nChnl, unsigned nScan, int packed,
+                  struct ARENA *a )
+{
+  size_t    bytes;
+  unsigned  k, n;
+
+  memset ( st, 0, sizeof(*st) );
+  if ( nChnl == 0 || nScan == 0 )  return 0;
+
+  st->nChnl      = nChnl;
+  st->nScan      = nScan;
+  st->packed     = packed;
+  store_layout ( nChnl, packed, &st->scanBytes, &st->blockScans );
+  n     = ( nScan + st->blockScans - 1 ) / st->blockScans;
+  bytes = (size_t) st->blockScans * st->scanBytes;
+
+  st->block = (uint8_t **) arena_alloc ( a, n * sizeof(uint8_t *) );
+  st->pool  = (uint8_t **) arena_alloc ( a, n * sizeof(uint8_t *) );
+  if ( st->block == NULL || st->pool == NULL ) {
+    memset ( st, 0, sizeof(*st) );
+    errorMsg("  store_alloc: the arena is full, no list of blocks");
+    return 1;
+  }
+  for (k=0; k<n; k++) {
+    if ( (st->pool[k] = (uint8_t *) arena_alloc ( a, bytes )) == NULL ) {
+      memset ( st, 0, sizeof(*st) );
+      errorMsg("  store_alloc: the arena is full, no room for the samples");
+      return 1;
+    }
+    st->nPool = k+1;
+  }
+  fprintf(stderr," sample store: %u blocks of %u scans, %.1f MB%s\n",
+                  n, st->blockScans, n * (double) bytes / 1.0e6,
+                  packed ? ", packed in 24 bits" : "" );
+  return 0;
+}
+
+
+/* STORE_SCAN - store one scan, from the scan handler; the list takes the
+   next block from the pool when the scan is past its last block    19oct26
+---------------------------------------------------------------------------*/
+void store_scan ( struct STORE *st, uint32_t scan, int32_t *adScan )
+{
+  unsigned  b;
+  uint8_t  *p;
+
+  if ( scan >= st->nScan )  return;
+  b = scan / st->blockScans;
+  while ( st->nBlock <= b && st->nPool > 0 )
+    st->block[st->nBlock++] = st->pool[--st->nPool];
+  if ( b >= st->nBlock )  return;
+
+  p = st->block[b] + (size_t)( scan % st->blockScans ) * st->scanBytes;
+  if ( st->packed )  pack24 ( p, adScan, st->nChnl );
+  else               memcpy ( p, adScan, st->scanBytes );
+  if ( scan >= st->nStored )  st->nStored = scan + 1;
+}
+
+
+/* STORE_READ - read one scan back, 0 for a scan that was not stored 19oct26
+---------------------------------------------------------------------------*/
+void store_read ( struct STORE *st, uint32_t scan, int32_t *adScan )
+{
+  unsigned  b = st->blockScans ? scan / st->blockScans : 0;
+  uint8_t  *p;
+
+  if ( scan >= st->nStored || b >= st->nBlock ) {
+    memset ( adScan, 0, st->nChnl * sizeof(int32_t) );
+    return;
+  }
+  p = st->block[b] + (size_t)( scan % st->blockScans ) * st->scanBytes;
+  if ( st->packed )  unpack24 ( adScan, p, st->nChnl );
+  else               memcpy ( adScan, p, st->scanBytes );
+}
+
+
+/* STORE_CHANNELS - copy block b by channel: the scans of channel chn are
+   chnlData[chn*n] to chnlData[chn*n + n-1], for the n scans stored in the
+   block; chnlData holds blockScans * nChnl samples.
+   returns n, 0 for a block with no scans stored                     19oct26
+---------------------------------------------------------------------------*/
+unsigned store_channels ( struct STORE *st, unsigned b, int32_t *chnlData )
+{
+  int32_t         tile[STORE_TILE * STORE_MAXCHNL], *y;
+  const int32_t  *x;
+  const uint8_t  *p;
+  unsigned        n, s0, m, i, c, nChnl = st->nChnl;
+
+  if ( b >= st->nBlock || nChnl > STORE_MAXCHNL ||
+       (size_t) b * st->blockScans >= st->nStored )  return 0;
+  n = st->nStored - b * st->blockScans;
+  if ( n > st->blockScans )  n = st->blockScans;
+
+  for (s0=0; s0<n; s0 += STORE_TILE) {       // a tile of scans at a time
+    m = ( n - s0 < STORE_TILE ) ? n - s0 : STORE_TILE;
+    p = st->block[b] + (size_t) s0 * st->scanBytes;
+    if ( st->packed ) {
+      unpack24 ( tile, p, m * nChnl );
+      x = tile;
+    } else
+      x = (const int32_t *) p;
+    for (c=0; c<nChnl; c++) {                // a row of each channel
+      y = chnlData + (size_t) c * n + s0;
+      for (i=0; i<m; i++)  y[i] = x[i*nChnl + c];
+    }
+  }
+  return n;
+}
+
+
+/* STORE_FREE - forget the blocks, which are freed with the arena    19oct26
+---------------------------------------------------------------------------*/
+void store_free ( struct STORE *st )
+{
+  memset ( st, 0, sizeof(*st) );
+}
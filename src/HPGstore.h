@@ -0,0 +1,72 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGstore.h
+ *
+ *    Description:  header file for HPGstore.c
+ *                  the A/D samples of a test, in blocks of whole scans,
+ *                  as 32 bit integers or packed in 24 bits
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGSTORE_H_
+#define _HPGSTORE_H_
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint8_t, int32_t
+#include "HPGarena.h"       // struct ARENA
+
+#define STORE_BLOCK   65536 /* bytes in a block, at most, a whole number of  */
+                            /* scans                                         */
+#define STORE_TILE       64 /* scans in a tile of the channel transpose      */
+#define STORE_MAXCHNL    32 /* most channels of a channel transpose, NUMCHNL */
+
+  struct STORE {        // the samples of a test
+         unsigned  nChnl;          // channels in a scan
+         unsigned  nScan;          // scans in the test
+         int       packed;         // 1: 3 bytes per sample ; 0: 4 bytes
+         unsigned  scanBytes;      // bytes in a scan
+         unsigned  blockScans;     // scans in a block
+         unsigned  nBlock;         // blocks in the list, taken from the pool
+         unsigned  nPool;          // blocks in the pool
+         uint8_t **block;          // the blocks, in the order of the scans
+         uint8_t **pool;           // the reserved blocks not yet taken
+         uint32_t  nStored;        // scans stored, the last one + 1
+      };
+
+/* the bytes of the arena for the samples of nScan scans of nChnl channels */
+size_t store_bytes ( unsigned nChnl,
+                     unsigned nScan,
+                     int packed );
+
+/* reserve the blocks of nScan scans of nChnl channels in the arena,
+   returns 0: successful  1: the arena is full */
+int  store_alloc ( struct STORE *st,
+                   unsigned nChnl,
+                   unsigned nScan,
+                   int packed,
+                   struct ARENA *a );
+
+/* store one scan, from the scan handler */
+void store_scan ( struct STORE *st,
+                  uint32_t scan,
+                  int32_t *adScan );
+
+/* read one scan back, 0 for a scan not stored */
+void store_read ( struct STORE *st,
+                  uint32_t scan,
+                  int32_t *adScan );
+
+/* copy block b to one contiguous array per channel, chnlData[chn*n ..],
+   returns n, the scans stored in the block */
+unsigned store_channels ( struct STORE *st,
+                          unsigned b,
+                          int32_t *chnlData );
+
+/* forget the blocks, freed with the arena */
+void store_free ( struct STORE *st );
+
+#endif // _HPGSTORE_H_
@@ -0,0 +1,388 @@
+/*******************************************************************************
+HPGstream.c
+live export of the scanned data over a local socket
+
+The scan handler copies each scan into a single-producer single-consumer
+ring with stream_scan(), which neither locks nor allocates nor blocks; if
+the ring is full the scan is dropped and counted.  A server thread wakes
+STREAM_HZ times a second, accepts subscribers, gathers the scans in the
+ring into STREAM_DATA frames, and appends each frame to the bounded queue
+of each subscriber.  A frame that does not fit in the queue of a slow
+subscriber is dropped for that subscriber only, so no subscriber can stall
+the acquisition or the other subscribers.  Each subscriber first receives
+a STREAM_META frame describing the channels, and a STREAM_END frame when
+the test is complete.  The frame format is described in HPGstream.h.
+
+The address is a path for a Unix-domain socket, e.g. /tmp/HPGdaac.sock, or
+a port number for a TCP socket on the loopback interface, e.g. 5025.
+Remote dashboards reach the TCP socket through an ssh tunnel.  The Unix
+socket is removed and created as the user running HPGdaac, not as root
+(HPGuser.c), so it is owned by the user, and a path the user could not
+write is refused; its mode, 0660, is set by the umask as it is bound,
+not by its path name afterwards.
+*******************************************************************************/
+
+#include <stdio.h>          // standard input/output library routines
+#include <stdlib.h>         // malloc, free
+#include <string.h>         // standard string handling library
+#include <errno.h>          // errno
+#include <signal.h>         // pthread_sigmask
+#include <fcntl.h>          // fcntl
+#include <poll.h>           // poll
+#include <unistd.h>         // close, unlink
+#include <pthread.h>        // the server thread
+#include <stdatomic.h>      // the ring indices
+#include <sys/socket.h>     // socket, bind, listen, accept, send
+#include <sys/stat.h>       // lstat, umask
+#include <sys/un.h>         // struct sockaddr_un
+#include <netinet/in.h>     // struct sockaddr_in
+
+// local libraries .. .
+#include "HPGstream.h"                // header for the data stream
+#include "HPGuser.h"                  // user_fs
+#include "../../HPGnumlib/HPGutil.h"  // HPG utility functions
+
+  struct SUBSCRIBER {   // one connected subscriber
+         int       fd;             // socket, -1 if not connected
+         uint8_t  *q;              // queued frames, STREAM_QUEUE bytes
+         uint32_t  head, tail;     // bytes queued and bytes sent, running
+         uint32_t  seq;            // frames queued
+         uint32_t  dropped;        // frames dropped, queue full
+      };
+
+static int32_t     ringData[STREAM_RING][NUMCHNL]; // scans from the handler
+static uint32_t    ringScan[STREAM_RING];          // scan numbers
+static atomic_uint ringHead,                       // written by the handler
+                   ringTail;                       // read by the server
+static uint32_t    ringDrops = 0;                  // scans dropped, ring full
+
+static struct SUBSCRIBER sub[STREAM_MAXSUB];
+static int         listenFd = -1;
+static char        sockPath[108] = "";             // Unix socket path
+static unsigned    streamChnl = 0;
+static char        meta[2*MAXL+NUMCHNL*(2*MAXL+80)];// STREAM_META payload
+static uint32_t    metaBytes = 0;
+static int32_t     block[STREAM_BLOCK*NUMCHNL];    // one STREAM_DATA payload
+static pthread_t   server;
+static atomic_int  stopping;
+static int         running = 0;
+
+
+/* ENQUEUE - append one frame to the queue of a subscriber, or drop it if
+   the queue does not have room for all of it                        19oct26
+---------------------------------------------------------------------------*/
+static void enqueue ( struct SUBSCRIBER *s, uint16_t type, uint32_t scan,
+                      uint32_t nScan, const void *payload, uint32_t bytes )
+{
+  struct STREAM_HEADER  hdr;
+  const uint8_t  *src[2] = { (const uint8_t *) &hdr, payload };
+  uint32_t        len[2] = { sizeof(hdr), bytes },  i, k, n;
+
+  if ( STREAM_QUEUE - (s->head - s->tail) < sizeof(hdr) + bytes ) {
+    ++s->dropped;
+    return;
+  }
+
+  hdr.magic = STREAM_MAGIC;
+  hdr.type  = type;
+  hdr.nChnl = streamChnl;
+  hdr.seq   = s->seq++;
+  hdr.scan  = scan;
+  hdr.nScan = nScan;
+  hdr.bytes = bytes;
+
+  for (i=0; i<2; i++)
+    for (k=0; k<len[i]; k+=n) {           // copy, wrapping around the queue
+      n = MIN ( len[i]-k, STREAM_QUEUE - s->head % STREAM_QUEUE );
+      memcpy ( s->q + s->head % STREAM_QUEUE, src[i] + k, n );
+      s->head += n;
+    }
+}
+
+
+/* PUBLISH - one frame to every subscriber                           19oct26
+---------------------------------------------------------------------------*/
+static void publish ( uint16_t type, uint32_t scan, uint32_t nScan,
+                      const void *payload, uint32_t bytes )
+{
+  int  k;
+
+  for (k=0; k<STREAM_MAXSUB; k++)
+    if ( sub[k].fd >= 0 )  enqueue ( &sub[k], type, scan, nScan, payload, bytes );
+}
+
+
+/* DISCONNECT - close a subscriber and report what it missed         19oct26
+---------------------------------------------------------------------------*/
+static void disconnect ( struct SUBSCRIBER *s )
+{
+  if ( s->dropped ) {
+    color(1); color(33);
+    fprintf(stderr,"  stream: a subscriber missed %u of %u frames\n",
+                    s->dropped, s->seq + s->dropped );
+  }
+  close ( s->fd );
+  free ( s->q );
+  s->fd = -1;
+  s->q  = NULL;
+}
+
+
+/* SEND_QUEUED - send as much of the queue of a subscriber as the socket
+   takes without blocking                                             19oct26
+---------------------------------------------------------------------------*/
+static void send_queued ( struct SUBSCRIBER *s )
+{
+  ssize_t   n;
+  uint32_t  len;
+
+  while ( s->head != s->tail ) {
+    len = MIN ( s->head - s->tail, STREAM_QUEUE - s->tail % STREAM_QUEUE );
+    n = send ( s->fd, s->q + s->tail % STREAM_QUEUE, len,
+               MSG_DONTWAIT | MSG_NOSIGNAL );
+    if ( n < 0 ) {
+      if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+        disconnect ( s );                   // gone
+      return;
+    }
+    s->tail += n;
+  }
+}
+
+
+/* ACCEPT_SUBSCRIBER - connect a new subscriber and queue the meta data
+---------------------------------------------------------------------------*/
+static void accept_subscriber ( void )
+{
+  int  fd, k;
+
+  if ( (fd = accept ( listenFd, NULL, NULL )) < 0 )  return;
+
+  for (k=0; k<STREAM_MAXSUB; k++)  if ( sub[k].fd < 0 )  break;
+  if ( k == STREAM_MAXSUB || (sub[k].q = malloc ( STREAM_QUEUE )) == NULL ) {
+    close ( fd );                           // no room
+    return;
+  }
+  fcntl ( fd, F_SETFL, fcntl ( fd, F_GETFL ) | O_NONBLOCK );
+  sub[k].fd = fd;
+  sub[k].head = sub[k].tail = sub[k].seq = sub[k].dropped = 0;
+  enqueue ( &sub[k], STREAM_META, 0, 0, meta, metaBytes );
+}
+
+
+/* DRAIN_RING - gather the scans in the ring into data frames.  A frame
+   holds consecutive scans only, so a scan dropped from a full ring shows
+   as a gap in the scan numbers                                       19oct26
+---------------------------------------------------------------------------*/
+static void drain_ring ( void )
+{
+  uint32_t  h = atomic_load_explicit ( &ringHead, memory_order_acquire ),
+            t = atomic_load_explicit ( &ringTail, memory_order_relaxed ),
+            first, n;
+
+  while ( t != h ) {
+    first = ringScan[t % STREAM_RING];
+    for (n=0; t != h && n < STREAM_BLOCK &&
+              ringScan[t % STREAM_RING] == first + n; n++, t++)
+      memcpy ( block + n*streamChnl, ringData[t % STREAM_RING],
+               streamChnl*sizeof(int32_t) );
+    atomic_store_explicit ( &ringTail, t, memory_order_release );
+    publish ( STREAM_DATA, first, n, block, n*streamChnl*sizeof(int32_t) );
+  }
+}
+
+
+/* STREAM_SERVER - the server thread                                 19oct26
+---------------------------------------------------------------------------*/
+static void *stream_server ( void *arg )
+{
+  struct pollfd  pfd[STREAM_MAXSUB+1];
+  int            idx[STREAM_MAXSUB+1], np, k, stop, tries;
+  char           junk[256];
+  sigset_t       mask;
+
+  sigemptyset ( &mask );                    // the scan handler runs in
+  sigaddset ( &mask, SIGALRM );             // the main thread only
+  pthread_sigmask ( SIG_BLOCK, &mask, NULL );
+
+  do {
+    stop = atomic_load ( &stopping );
+
+    pfd[0].fd = listenFd;
+    pfd[0].events = POLLIN;
+    for (np=1, k=0; k<STREAM_MAXSUB; k++)
+      if ( sub[k].fd >= 0 ) {
+        pfd[np].fd = sub[k].fd;
+        pfd[np].events = POLLIN | ( sub[k].head != sub[k].tail ? POLLOUT : 0 );
+        idx[np++] = k;
+      }
+    (void) poll ( pfd, np, stop ? 0 : 1000/STREAM_HZ );
+
+    for (k=1; k<np; k++) {                  // closed by the subscriber ?
+      if ( pfd[k].revents & (POLLERR | POLLHUP) )
+        disconnect ( &sub[idx[k]] );
+      else
+      if ( pfd[k].revents & POLLIN &&
+           recv ( pfd[k].fd, junk, sizeof(junk), MSG_DONTWAIT ) == 0 )
+        disconnect ( &sub[idx[k]] );
+    }
+    if ( pfd[0].revents & POLLIN )  accept_subscriber ();
+
+    drain_ring ();
+    for (k=0; k<STREAM_MAXSUB; k++)
+      if ( sub[k].fd >= 0 )  send_queued ( &sub[k] );
+  } while ( !stop );
+
+  // the test is complete ... send the end frame, waiting up to a second
+  publish ( STREAM_END, 0, 0, NULL, 0 );
+  for (tries=0; tries < STREAM_HZ; tries++) {
+    for (np=0, k=0; k<STREAM_MAXSUB; k++)
+      if ( sub[k].fd >= 0 ) {
+        send_queued ( &sub[k] );
+        if ( sub[k].fd >= 0 && sub[k].head != sub[k].tail )  ++np;
+      }
+    if ( np == 0 )  break;
+    usleep ( 1000000/STREAM_HZ );
+  }
+  for (k=0; k<STREAM_MAXSUB; k++)
+    if ( sub[k].fd >= 0 )  disconnect ( &sub[k] );
+
+  return arg;
+}
+
+
+/* STREAM_OPEN - open the socket, describe the channels, and start the
+   server thread.   0: ok, 1: the stream could not be opened        19oct26
+---------------------------------------------------------------------------*/
+int stream_open ( char *addr, char *title, unsigned nChnl, struct CHNL *chnl,
+                  uint8_t *rangeCode, float sr, unsigned nScan )
+{
+  struct sockaddr_un  un;
+  struct sockaddr_in  in;
+  struct stat         st;
+  mode_t              mask;
+  int                 k, one = 1, asUser;
+  unsigned            chn;
+
+  if ( strspn ( addr, "0123456789" ) == strlen ( addr ) ) {  // TCP port
+    memset ( &in, 0, sizeof(in) );
+    in.sin_family = AF_INET;
+    in.sin_port   = htons ( atoi ( addr ) );
+    in.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );          // local only
+    listenFd = socket ( AF_INET, SOCK_STREAM, 0 );
+    if ( listenFd >= 0 )
+      setsockopt ( listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+    if ( listenFd < 0 || bind ( listenFd, (struct sockaddr *) &in, sizeof(in) ) ) {
+      errorMsg ( "  stream_open: cannot bind the TCP port" );
+      fprintf(stderr,"  127.0.0.1:%s  %s\n", addr, strerror ( errno ) );
+      if ( listenFd >= 0 )  close ( listenFd );
+      listenFd = -1;
+      return 1;
+    }
+  } else {                                                   // Unix socket
+    if ( strlen ( addr ) >= sizeof(un.sun_path) ) {
+      errorMsg ( "  stream_open: the socket path is too long" );
+      return 1;
+    }
+    memset ( &un, 0, sizeof(un) );
+    un.sun_family = AF_UNIX;
+    strcpy ( un.sun_path, addr );
+    listenFd = socket ( AF_UNIX, SOCK_STREAM, 0 );
+    asUser = user_fs ( 1 );                 // only what the user may remove
+    if ( lstat ( addr, &st ) == 0 && S_ISSOCK ( st.st_mode ) )
+      unlink ( addr );                      // left over from an earlier test
+    mask = umask ( 0117 );                  // 0660, subscribers need not be root
+    if ( listenFd < 0 || bind ( listenFd, (struct sockaddr *) &un, sizeof(un) ) ) {
+      umask ( mask );
+      user_fs ( asUser );
+      errorMsg ( "  stream_open: cannot bind the socket" );
+      fprintf(stderr,"  %s  %s\n", addr, strerror ( errno ) );
+      if ( listenFd >= 0 )  close ( listenFd );
+      listenFd = -1;
+      return 1;
+    }
+    umask ( mask );
+    user_fs ( asUser );
+    strcpy ( sockPath, addr );
+  }
+  listen ( listenFd, STREAM_MAXSUB );
+  fcntl ( listenFd, F_SETFL, fcntl ( listenFd, F_GETFL ) | O_NONBLOCK );
+
+  // the meta data frame, plain text
+  streamChnl = nChnl;
+  metaBytes = snprintf ( meta, sizeof(meta),
+                         "%s\n%f scans per second\n%u scans\n%u channels\n",
+                         title, sr, nScan, nChnl );
+  for (chn=0; chn<nChnl && metaBytes < sizeof(meta); chn++)
+    metaBytes += snprintf ( meta + metaBytes, sizeof(meta) - metaBytes,
+                            "%u %f %.0f %.0f %f \"%s\" \"%s\"\n", chn,
+                            ADS1256_range_value ( rangeCode[chn] ),
+                            chnl[chn].bias, chnl[chn].rms, chnl[chn].sensi,
+                            chnl[chn].units, chnl[chn].label );
+  metaBytes = MIN ( metaBytes, (uint32_t) sizeof(meta) - 1 );
+
+  for (k=0; k<STREAM_MAXSUB; k++)  sub[k].fd = -1;
+  atomic_store ( &ringHead, 0 );
+  atomic_store ( &ringTail, 0 );
+  atomic_store ( &stopping, 0 );
+  ringDrops = 0;
+
+  if ( pthread_create ( &server, NULL, stream_server, NULL ) ) {
+    errorMsg ( "  stream_open: cannot start the server thread" );
+    close ( listenFd );
+    listenFd = -1;
+    return 1;
+  }
+  running = 1;
+
+  fprintf(stderr," stream server on %-40s . . . . . . . .  success \n", addr );
+  return 0;
+}
+
+
+/* STREAM_SCAN - copy one scan into the ring, from the scan handler.
+   Drops the scan if the server has fallen a whole ring behind.      19oct26
+---------------------------------------------------------------------------*/
+void stream_scan ( uint32_t scan, int32_t *adScan )
+{
+  uint32_t  h, t;
+
+  if ( !running )  return;
+
+  h = atomic_load_explicit ( &ringHead, memory_order_relaxed );
+  t = atomic_load_explicit ( &ringTail, memory_order_acquire );
+  if ( h - t >= STREAM_RING ) {
+    ++ringDrops;
+    return;
+  }
+  memcpy ( ringData[h % STREAM_RING], adScan, streamChnl*sizeof(int32_t) );
+  ringScan[h % STREAM_RING] = scan;
+  atomic_store_explicit ( &ringHead, h+1, memory_order_release );
+}
+
+
+/* STREAM_CLOSE - send the remaining scans and the end frame, and stop the
+   server thread.  Safe to call more than once.                      19oct26
+---------------------------------------------------------------------------*/
+void stream_close ( void )
+{
+  if ( !running )  return;
+  running = 0;
+
+  atomic_store ( &stopping, 1 );
+  pthread_join ( server, NULL );
+  close ( listenFd );
+  listenFd = -1;
+  if ( sockPath[0] ) {
+    int  asUser = user_fs ( 1 );
+    unlink ( sockPath );
+    user_fs ( asUser );
+  }
+  sockPath[0] = '\0';
+
+  if ( ringDrops ) {
+    color(1); color(33);
+    fprintf(stderr,"  stream: %u scans were dropped, the server fell behind\n",
+                    ringDrops );
+  }
+}
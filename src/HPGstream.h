@@ -0,0 +1,67 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGstream.h
+ *
+ *    Description:  header file for HPGstream.c
+ *                  live export of the scanned data over a local socket
+ *
+ *   Each frame is a STREAM_HEADER followed by header.bytes of payload.
+ *   STREAM_META   text:  the title, the scan rate, the number of scans,
+ *                 and one line per channel:  chn range bias rms sensi
+ *                 "units" "label"
+ *   STREAM_DATA   header.nScan scans, each of header.nChnl int32_t A/D
+ *                 values (0 to ADMAX) in channel order, from scan
+ *                 header.scan.  A gap in the scan numbers is dropped data.
+ *   STREAM_END    no payload, the test is complete
+ *   All values are in the byte order of the Raspberry Pi (little-endian).
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGSTREAM_H_
+#define _HPGSTREAM_H_
+
+#include <stdint.h>         // uint32_t, int32_t
+#include "HPGdaac.h"        // struct CHNL, NUMCHNL
+
+#define STREAM_MAGIC   0x73475048 /* "HPGs"                                 */
+#define STREAM_META    1    /* frame types                                  */
+#define STREAM_DATA    2
+#define STREAM_END     3
+
+#define STREAM_RING    8192 /* scans buffered for the server, a power of 2  */
+#define STREAM_BLOCK    256 /* most scans in one data frame                 */
+#define STREAM_QUEUE (1<<18)/* bytes queued per subscriber                  */
+#define STREAM_MAXSUB     8 /* most subscribers at once                     */
+#define STREAM_HZ        50 /* server wake-ups per second                   */
+
+  struct STREAM_HEADER {    // the header of every frame, 24 bytes
+         uint32_t  magic;          // STREAM_MAGIC
+         uint16_t  type;           // STREAM_META, STREAM_DATA, STREAM_END
+         uint16_t  nChnl;          // number of channels
+         uint32_t  seq;            // frame number, from 0 for each subscriber
+         uint32_t  scan;           // first scan of a data frame
+         uint32_t  nScan;          // number of scans in a data frame
+         uint32_t  bytes;          // payload bytes following the header
+      };
+
+/* open the socket and start the server thread, 0: ok, 1: failed */
+int  stream_open ( char *addr,
+                   char *title,
+                   unsigned nChnl,
+                   struct CHNL *chnl,
+                   uint8_t *rangeCode,
+                   float sr,
+                   unsigned nScan );
+
+/* queue one scan for the subscribers, from the scan handler, never blocks */
+void stream_scan ( uint32_t scan,
+                   int32_t *adScan );
+
+/* send the remaining scans and the end frame, stop the server thread */
+void stream_close ( void );
+
+#endif // _HPGSTREAM_H_
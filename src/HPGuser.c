@@ -0,0 +1,81 @@
+/*******************************************************************************
+HPGuser.c
+files named by the user are made and removed as the user, not as root
+
+HPGdaac is installed setuid root, for the bcm2835 library, so every file
+system call would otherwise be made as root, on paths the user names in
+the configuration file.  user_fs(1) sets the file system identity of the
+process, its fsuid and fsgid, to the real user and group, so that files
+are created, opened, and removed, and sockets bound, with the permissions
+of the user, and created owned by the user; user_fs(0) sets it back to
+root.  The other privileges of the process are not changed, so it may be
+used around a few calls in the middle of a test.
+
+hpgdaacd runs as root, for every user.  For each test, user_set() makes
+the user who asked for it the real user, with the groups of that user, so
+user_fs(1) reaches the file system as that user, and files are made and
+given to that user as they would be by HPGdaac run by that user.
+*******************************************************************************/
+
+#define _GNU_SOURCE                   // setresuid, setresgid
+
+#include <unistd.h>         // getuid, geteuid, setresuid
+#include <grp.h>            // setgroups, getgrouplist
+#include <pwd.h>            // getpwuid
+#include <sys/fsuid.h>      // setfsuid, setfsgid
+
+// local libraries .. .
+#include "HPGuser.h"                  // header for the user identity
+
+static int  asUser = 0;     // 1: the file system is reached as the user
+
+
+/* USER_FS - reach the file system as the real user (on = 1) or as the
+   effective user (on = 0),  returns the previous setting            19oct26
+---------------------------------------------------------------------------*/
+int user_fs ( int on )
+{
+  int  was = asUser;
+
+  if ( on ) {                               // group first, while still root
+    (void) setfsgid ( getgid() );
+    (void) setfsuid ( getuid() );
+  } else {
+    (void) setfsuid ( geteuid() );
+    (void) setfsgid ( getegid() );
+  }
+  asUser = on;
+  return was;
+}
+
+
+/* USER_SET - make uid and gid, with the groups of uid, the real user and
+   group, keeping root as the effective user;  user_set ( geteuid(),
+   getegid() ) sets them, and the groups of root, back.
+   returns 0: successful  1: abnormal                                19oct26
+---------------------------------------------------------------------------*/
+int user_set ( uid_t uid, gid_t gid )
+{
+  static gid_t   rootGroups[USER_MAXGROUPS];
+  static int     nRoot = -1;
+  gid_t          groups[USER_MAXGROUPS];
+  int            n = USER_MAXGROUPS;
+  struct passwd *pw;
+
+  if ( nRoot < 0 )  nRoot = getgroups ( USER_MAXGROUPS, rootGroups );
+
+  if ( uid == geteuid() ) {                 // back to root
+    if ( setresuid ( uid, -1, -1 ) || setresgid ( gid, -1, -1 ) ||
+         setgroups ( nRoot > 0 ? nRoot : 0, rootGroups ) )  return 1;
+    return 0;
+  }
+
+  if ( (pw = getpwuid ( uid )) == NULL ||
+       getgrouplist ( pw->pw_name, gid, groups, &n ) < 0 ) {
+    groups[0] = gid;                        // no more than the one group
+    n = 1;
+  }
+  if ( setgroups ( n, groups ) || setresgid ( gid, -1, -1 ) ||
+       setresuid ( uid, -1, -1 ) )  return 1;
+  return 0;
+}
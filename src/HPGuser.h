@@ -0,0 +1,32 @@
+/*
+ * ==========================================================================
+ *
+ *       Filename:  HPGuser.h
+ *
+ *    Description:  header file for HPGuser.c
+ *                  files named by the user are made and removed as the
+ *                  user, not as root
+ *
+ *         Author:  Henri P. Gavin
+ *
+ * ==========================================================================
+ */
+
+#ifndef _HPGUSER_H_
+#define _HPGUSER_H_
+
+#include <sys/types.h>      // uid_t, gid_t
+
+#define USER_MAXGROUPS   64  /* groups of a user, at most                   */
+
+/* reach the file system as the real user (on = 1) or as the effective
+   user, root (on = 0);  returns the previous setting */
+int  user_fs ( int on );
+
+/* make uid and gid, with their groups, the real user and group, for
+   user_fs(), keeping root as the effective user;  user_set ( geteuid(),
+   getegid() ) sets them back.  returns 0: successful  1: abnormal */
+int  user_set ( uid_t uid,
+                gid_t gid );
+
+#endif // _HPGUSER_H_